@@ -0,0 +1,82 @@
+"""Generates synthetic levels larger than the competition ones, to benchmark search on wide maps.
+
+Usage: python generate_large_levels.py [output_dir] [size] [count]
+"""
+import os
+import random
+import sys
+
+ROOM_SIZE = 12
+OBSTACLE_SHARE = 0.2
+BOX_COUNT = 1
+
+
+def rooms_grid(size: int, rng: random.Random) -> list[list[str]]:
+    """Rooms behind walls with one or two doorways on each side, so the way across takes detours."""
+    grid = [["+" if r % ROOM_SIZE == 0 or c % ROOM_SIZE == 0 else " " for c in range(size)] for r in range(size)]
+    for r in range(size):
+        grid[r][size - 1] = "+"
+    grid[size - 1] = ["+"] * size
+    for wall in range(ROOM_SIZE, size - 1, ROOM_SIZE):
+        for start in range(0, size - 1, ROOM_SIZE):
+            for _ in range(rng.randint(1, 2)):
+                offset = rng.randint(start + 1, min(start + ROOM_SIZE, size - 1) - 1)
+                grid[wall][offset] = " "
+                grid[offset][wall] = " "
+    return grid
+
+
+def open_grid(size: int, rng: random.Random) -> list[list[str]]:
+    """An open floor with scattered pillars."""
+    grid = [["+" if r in (0, size - 1) or c in (0, size - 1) else " " for c in range(size)] for r in range(size)]
+    for r in range(2, size - 2):
+        for c in range(2, size - 2):
+            if rng.random() < OBSTACLE_SHARE and (r + c) % 2 == 0:
+                grid[r][c] = "+"
+    return grid
+
+
+def free_cells(grid: list[list[str]], rows: range, cols: range) -> list[tuple[int, int]]:
+    return [(r, c) for r in rows for c in cols if grid[r][c] == " "]
+
+
+def generate(kind: str, size: int, seed: int) -> str:
+    rng = random.Random(seed)
+    grid = rooms_grid(size, rng) if kind == "rooms" else open_grid(size, rng)
+    goal = [row[:] for row in grid]
+    corner = range(1, size // 5)
+    far = range(size - size // 5, size - 1)
+    # The agent crosses the level from the top-left corner to the bottom-right one and delivers a box there
+    agent, = rng.sample(free_cells(grid, corner, corner), 1)
+    boxes = rng.sample(free_cells(grid, far, far), BOX_COUNT)
+    targets = rng.sample(free_cells(grid, far, far), BOX_COUNT + 1)
+    grid[agent[0]][agent[1]] = "0"
+    goal[targets[0][0]][targets[0][1]] = "0"
+    for (r, c), (gr, gc) in zip(boxes, targets[1:]):
+        grid[r][c] = "A"
+        goal[gr][gc] = "A"
+
+    name = f"SAlarge{kind.capitalize()}{seed}"
+    lines = ["#domain", "hospital", "#levelname", name, "#colors", "blue: 0, A", "#initial"]
+    lines += ["".join(row) for row in grid]
+    lines += ["#goal"]
+    lines += ["".join(row) for row in goal]
+    lines += ["#end"]
+    return name, "\n".join(lines) + "\n"
+
+
+def main():
+    output_dir = sys.argv[1] if len(sys.argv) > 1 else "../levels/large"
+    size = int(sys.argv[2]) if len(sys.argv) > 2 else 200
+    count = int(sys.argv[3]) if len(sys.argv) > 3 else 2
+    os.makedirs(output_dir, exist_ok=True)
+    for kind in ("rooms", "open"):
+        for seed in range(1, count + 1):
+            name, level = generate(kind, size, seed)
+            with open(os.path.join(output_dir, name + ".lvl"), "w") as f:
+                f.write(level)
+            print(f"Wrote {name}.lvl")
+
+
+if __name__ == "__main__":
+    main()
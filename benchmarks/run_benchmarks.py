@@ -4,7 +4,8 @@ import sys
 import datetime
 import subprocess
 from concurrent.futures import ProcessPoolExecutor
-from dataclasses import dataclass
+from collections import Counter
+from dataclasses import dataclass, field
 from enum import Enum
 from tqdm import tqdm
 
@@ -23,6 +24,9 @@ SERVER_JAR = "../server.jar"
 CLIENT_EXECUTABLE_PATH = "../searchclient_cpp/searchclient" 
 
 BENCHMARK_CONFIG_FILE = "benchmarks.json"
+
+COMMENTS_PREFIX = "[client][message]"
+PORTFOLIO_WINNER_PREFIX = "portfolio-winner:"
 BENCHMARK_CONFIG_REQUIRED_KEYS = ["levels_dir", "output_dir", "cases", "strategies", "run_full_benchmark", "skip_best_found_strategy"]
 
 class bcolors(Enum):
@@ -46,23 +50,33 @@ class CaseResult:
     strategy: str
     solution_length: int
     metrics: dict[str, float]
+    portfolio_winner: str | None = None
     
 @dataclass
 class BenchmarkResult:
     timestamp: str
     cases: list[CaseResult]
+    portfolio_wins: dict[str, int] = field(default_factory=dict)
     
     def to_json(self) -> str:
         return json.dumps(self, default=lambda o: o.__dict__, indent=4)
 
 
+def parse_portfolio_winner(output_str: str) -> str | None:
+    for line in output_str.strip().split('\n'):
+        line = line.strip()
+        if line.startswith(COMMENTS_PREFIX + PORTFOLIO_WINNER_PREFIX):
+            return line[len(COMMENTS_PREFIX + PORTFOLIO_WINNER_PREFIX):].strip()
+    return None
+
+
 def parse_server_output(output_str: str) -> tuple[dict, int]:
     lines = output_str.strip().split('\n')
     if len(lines) < 2:
         raise ValueError("Output must contain at least a header and a data line.")
     
-    COMMENTS_PREFIX = "[client][message]"
-    benchmarks_lines = [line[len(COMMENTS_PREFIX):] for line in lines if line.strip().startswith(COMMENTS_PREFIX)]
+    benchmarks_lines = [line.strip()[len(COMMENTS_PREFIX):] for line in lines if line.strip().startswith(COMMENTS_PREFIX)]
+    benchmarks_lines = [line for line in benchmarks_lines if not line.startswith(PORTFOLIO_WINNER_PREFIX)]
     if len(benchmarks_lines) < 2:
         raise ValueError("Output must contain at least two benchmark lines.")
 
@@ -133,6 +147,7 @@ def run_single_benchmark_case(commands: dict) -> CaseResult:
     level_name = commands["level_name"]
     strategy = commands["strategy"]
     timeout_s = commands["timeout_s"]
+    native = commands.get("native", False)
     
     case_result = CaseResult(
         level=level_name,
@@ -148,7 +163,8 @@ def run_single_benchmark_case(commands: dict) -> CaseResult:
             stderr=subprocess.PIPE, 
             text=True,
         )
-        stdout, stderr = process.communicate(timeout=timeout_s + 1)
+        # Batch mode kills its worker a few seconds after the deadline itself
+        stdout, stderr = process.communicate(timeout=timeout_s + (10 if native else 1))
     except subprocess.TimeoutExpired:
         process.kill()  # Shouldnt be needed
         stdout, stderr = process.communicate()
@@ -162,9 +178,17 @@ def run_single_benchmark_case(commands: dict) -> CaseResult:
         return case_result
     
     try:
-        metrics, solution_length = parse_server_output(stdout)
-        case_result.metrics = metrics
-        case_result.solution_length = solution_length
+        if native:
+            # The batch JSON already has the case layout, the plan was checked by the client's PlanValidator
+            case = json.loads(stdout)["cases"][0]
+            case_result.metrics = case["metrics"]
+            case_result.solution_length = case["solution_length"]
+            case_result.portfolio_winner = case["portfolio_winner"]
+        else:
+            metrics, solution_length = parse_server_output(stdout)
+            case_result.metrics = metrics
+            case_result.solution_length = solution_length
+            case_result.portfolio_winner = parse_portfolio_winner(stdout)
     except Exception as e:
         case_result.metrics = {
             "error": f"Failed to parse server output: {e}"
@@ -350,7 +374,9 @@ def main():
     if not ensure_output_directory(output_dir):
         return
 
-    if not check_executable_exists(SERVER_JAR):
+    # Optional: solve without server.jar, each case runs through `searchclient --batch` which validates its own plans
+    native = config.get("native", False)
+    if not native and not check_executable_exists(SERVER_JAR):
         return
 
     if not check_executable_exists(CLIENT_EXECUTABLE_PATH):
@@ -365,6 +391,12 @@ def main():
     strategies = config["strategies"]
     run_full_benchmark = config["run_full_benchmark"]
     skip_best_found_strategy = config["skip_best_found_strategy"]
+    # Optional: directory of .lvlc snapshots, so reruns skip level parsing and analysis
+    level_cache_dir = config.get("level_cache_dir")
+    client_options = ""
+    if level_cache_dir:
+        os.makedirs(level_cache_dir, exist_ok=True)
+        client_options = f"--level-cache {os.path.abspath(level_cache_dir)} "
 
     running_cases_count = len(cases) if run_full_benchmark else SHORT_BENCHMARK_CASES_COUNT
     
@@ -397,18 +429,25 @@ def main():
             if skip_best_found_strategy and strategy == case.get("best_found_solution_metrics", {}).get("strategy"):
                 continue
             
-            client_command_str = f"{CLIENT_EXECUTABLE_PATH} {strategy}"
-            command = [JAVA, "-jar", SERVER_JAR, 
-                       "-c", client_command_str, 
-                       "-l", level_full_path,
-                       "-t", str(timeout_s)
-                       ]
+            if native:
+                command = [CLIENT_EXECUTABLE_PATH, "--batch", level_full_path,
+                           "--workers", "1",
+                           "--timeout", str(timeout_s),
+                           *client_options.split(), *strategy.split()]
+            else:
+                client_command_str = f"{CLIENT_EXECUTABLE_PATH} {client_options}{strategy}"
+                command = [JAVA, "-jar", SERVER_JAR, 
+                           "-c", client_command_str, 
+                           "-l", level_full_path,
+                           "-t", str(timeout_s)
+                           ]
             tasks_to_run_commands.append(
                 {
                     "command_list": command,
                     "level_name": level_relative_path,
                     "strategy": strategy,
-                    "timeout_s": timeout_s
+                    "timeout_s": timeout_s,
+                    "native": native
                 }
             )
             
@@ -429,6 +468,7 @@ def main():
         ))
     
     all_results.cases.extend(case_results)
+    all_results.portfolio_wins = dict(Counter(case.portfolio_winner for case in case_results if case.portfolio_winner))
     
     if not all_results.cases: # Only save if there are results
         print("No benchmark results were collected.", file=sys.stderr)
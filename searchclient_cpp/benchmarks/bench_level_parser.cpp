@@ -0,0 +1,67 @@
+// Microbenchmark of the level parser: median time of parseLevelText, and of parseLevel with the static analysis,
+// over the given level files. Large synthetic levels come from ../benchmarks/generate_large_levels.py.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "level.hpp"
+
+static constexpr size_t PARSE_REPETITIONS = 50;
+static constexpr size_t LOAD_REPETITIONS = 5;
+
+static std::string readFile(const char *path) {
+    std::string text;
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return text;
+    }
+    char buffer[1 << 16];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        text.append(buffer, read);
+    }
+    fclose(file);
+    return text;
+}
+
+template <typename F>
+static double medianMs(size_t repetitions, F &&run) {
+    std::vector<double> times;
+    for (size_t i = 0; i < repetitions; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s level.lvl...\n", argv[0]);
+        return 1;
+    }
+    // The analysis reports every level on stderr, keep only the results
+    freopen("/dev/null", "w", stderr);
+    printf("%-28s %10s %12s %10s %12s\n", "level", "size", "parse[ms]", "MB/s", "load[ms]");
+    for (int i = 1; i < argc; i++) {
+        const std::string text = readFile(argv[i]);
+        std::string name = argv[i];
+        name = name.substr(name.find_last_of('/') + 1);
+        try {
+            parseLevelText(text);
+        } catch (const std::invalid_argument &e) {
+            printf("%-28s %s\n", name.c_str(), e.what());
+            continue;
+        }
+        const ParsedLevel parsed = parseLevelText(text);
+        const double parse_ms = medianMs(PARSE_REPETITIONS, [&] { parseLevelText(text); });
+        const double load_ms = medianMs(LOAD_REPETITIONS, [&] { parseLevel(text); });
+        printf("%-28s %4zux%-5zu %12.3f %10.1f %12.3f\n", name.c_str(), parsed.walls.size_rows(), parsed.walls.size_cols(), parse_ms,
+               text.size() / parse_ms / 1000.0, load_ms);
+    }
+    return 0;
+}
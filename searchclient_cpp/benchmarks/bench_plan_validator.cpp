@@ -0,0 +1,64 @@
+// Microbenchmark of PlanValidator: median time to validate long plans. The plan shuttles every agent of a
+// generated open room back and forth, one box per agent pushed and pulled along, for PLAN_LENGTH joint actions.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "level.hpp"
+#include "plan_validator.hpp"
+
+static constexpr size_t PLAN_LENGTH = 10'000;
+static constexpr size_t REPETITIONS = 101;
+static constexpr size_t ROOM_WIDTH = 12;
+
+// Agent i starts in column 1 of row i + 1 with its box next to it
+static std::string makeLevel(size_t agents) {
+    std::string colors, initial, goal;
+    const std::string wall(ROOM_WIDTH + 2, '+');
+    initial = goal = wall + "\n";
+    for (size_t i = 0; i < agents; i++) {
+        colors += "red: " + std::to_string(i) + ", " + char('A' + i) + "\n";
+        std::string row = "+" + std::string(ROOM_WIDTH, ' ') + "+\n";
+        goal += row;
+        row[1] = '0' + i;
+        row[2] = 'A' + i;
+        initial += row;
+    }
+    initial += wall + "\n";
+    goal += wall + "\n";
+    return "#domain\nhospital\n#levelname\nbench\n#colors\n" + colors + "#initial\n" + initial + "#goal\n" + goal + "#end\n";
+}
+
+int main() {
+    // The analysis reports every level on stderr, keep only the results
+    freopen("/dev/null", "w", stderr);
+    printf("%-8s %10s %12s %12s\n", "agents", "steps", "median[us]", "ns/action");
+    for (const size_t agents : {1, 4, 10}) {
+        const Level level = parseLevel(makeLevel(agents));
+        // Push the box to the far wall and pull it back
+        const size_t leg = ROOM_WIDTH - 2;
+        std::vector<std::vector<const Action *>> plan;
+        while (plan.size() < PLAN_LENGTH) {
+            const bool pushing = plan.size() / leg % 2 == 0;
+            plan.emplace_back(agents, pushing ? &Action::PushEE : &Action::PullWW);
+        }
+        const PlanValidator validator(level);
+        if (!validator.validate(plan).valid) {
+            printf("%-8zu invalid plan: %s\n", agents, validator.validate(plan).error.c_str());
+            continue;
+        }
+
+        std::vector<double> times;
+        for (size_t i = 0; i < REPETITIONS; i++) {
+            const auto start = std::chrono::steady_clock::now();
+            validator.validate(plan);
+            times.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+        const double median_us = times[times.size() / 2];
+        printf("%-8zu %10zu %12.1f %12.2f\n", agents, plan.size(), median_us, median_us * 1000 / (plan.size() * agents));
+    }
+    return 0;
+}
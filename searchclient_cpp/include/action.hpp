@@ -2,6 +2,7 @@
 
 #include <array>
 #include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -14,6 +15,7 @@ class Action {
     Action(const std::string &name, const ActionType type, const Cell2D agent_delta, const Cell2D box_delta);
 
     static std::map<size_t, std::vector<std::vector<const Action *>>> cached_permutations_;
+    static std::mutex cached_permutations_mutex_;  // Searches on several threads fill the cache
 
    public:
     Action(const Action &) = delete;
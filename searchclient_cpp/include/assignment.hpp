@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Minimum cost perfect matching of n rows into n columns (Hungarian method with potentials).
+// Rows can be re-costed one at a time: the row is unmatched and a single augmenting path
+// restores optimality in O(n^2), instead of O(n^3) for solving from scratch.
+class Assignment {
+   private:
+    size_t size_;
+    std::vector<long long> costs_;  // costs_[row * size_ + col]
+    // 1-based, index 0 is the virtual column an augmenting path starts from
+    std::vector<long long> row_potential_, col_potential_;
+    std::vector<size_t> col_match_, row_match_;
+
+    inline long long cost(size_t row, size_t col) const { return costs_[(row - 1) * size_ + col - 1]; }
+    void augment(size_t row);
+
+   public:
+    Assignment() = delete;
+    explicit Assignment(size_t size);
+    Assignment(const Assignment &) = default;
+    Assignment &operator=(const Assignment &) = default;
+    ~Assignment() = default;
+
+    // Replaces the costs of a row and leaves it unmatched until the next solve()
+    void setRow(size_t row, const std::vector<long long> &costs);
+    // Matches every unmatched row
+    void solve();
+
+    inline size_t size() const { return size_; }
+    inline size_t getColumn(size_t row) const { return row_match_[row + 1] - 1; }
+    long long getCost() const;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct BatchOptions {
+    std::string levels_dir;
+    std::string strategy;
+    size_t workers;
+    std::chrono::seconds timeout;  // Search deadline of every level
+    uint32_t memory_limit_mb;      // Memory::maxUsage of every level
+    std::string cache_dir;         // Level snapshots, see LevelCache, unused when empty
+
+    BatchOptions();
+};
+
+// Solves every .lvl file under a directory, or a single level file, without a server. Each level runs in a forked worker process, at most
+// `workers` at a time, so a crash or a runaway search only loses that level and memory is measured per level.
+// Every plan is checked by PlanValidator. The results are printed as JSON in the format run_benchmarks.py saves
+// under benchmarks/output.
+class BatchRunner {
+   public:
+    // Workers still running this long after their deadline are killed
+    static constexpr std::chrono::seconds KILL_GRACE{5};
+
+   private:
+    // Sent by a worker through its pipe when it finishes
+    struct CaseMetrics {
+        uint64_t expanded;
+        uint64_t generated;
+        uint64_t solution_length;
+        uint64_t sum_of_costs;
+        uint64_t fuel;
+        double time_s;
+        uint32_t alloc_mb;  // Peak resident memory of the worker
+        char portfolio_winner[64];
+        char error[128];
+    };
+    struct CaseResult {
+        std::string level;  // Relative to the levels directory
+        bool finished;
+        CaseMetrics metrics;
+        std::string error;  // Set when the worker crashed or was killed
+    };
+    struct Worker {
+        pid_t pid;
+        int pipe_fd;
+        size_t case_idx;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    BatchOptions options_;
+    std::vector<CaseResult> cases_;
+
+    // Runs in the forked process, never returns
+    [[noreturn]] void solveCase(const std::string &path, int pipe_fd) const;
+    void collect(const Worker &worker, int status);
+    void printJson(FILE *out) const;
+
+   public:
+    explicit BatchRunner(BatchOptions options);
+
+    // Solves all levels and prints the JSON to `out`. Returns the process exit status.
+    int run(FILE *out);
+};
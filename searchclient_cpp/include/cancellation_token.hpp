@@ -0,0 +1,17 @@
+#pragma once
+
+#include <atomic>
+
+// Shared stop flag for searches running on several threads. Searches poll it next to their deadline check.
+class CancellationToken {
+   private:
+    std::atomic<bool> cancelled_;
+
+   public:
+    CancellationToken() : cancelled_(false) {}
+    CancellationToken(const CancellationToken &) = delete;
+    CancellationToken &operator=(const CancellationToken &) = delete;
+
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+};
@@ -11,12 +11,17 @@
 // #include <vector>
 
 #include "action.hpp"
+#include "cancellation_token.hpp"
 #include "conflict.hpp"
 #include "constraint.hpp"
+#include "constraint_table.hpp"
 #include "frontier.hpp"
 #include "graphsearch.hpp"
+#include "heuristic.hpp"
 #include "low_level_state.hpp"
 #include "memory.hpp"
+#include "prioritized_planner.hpp"
+#include "reservation_table.hpp"
 #include "utils.hpp"
 
 // Global start time
@@ -91,27 +96,134 @@ class CBS {
 
    private:
     std::vector<LowLevelState *> initial_agents_states_;
+    // The groups before task allocation split some of them, empty if it split none
+    std::vector<LowLevelState *> unsplit_groups_;
     size_t agents_num_;
     std::set<std::set<OneSidedConflict>> visited_constraint_sets_;
+    std::chrono::steady_clock::time_point deadline_;
+    const CancellationToken *cancellation_token_;
+    size_t conflict_window_;  // CT nodes only resolve conflicts in this many first timesteps
+    bool warm_start_;         // Runs prioritized planning for an incumbent before the CT search
+    std::function<Heuristic *()> heuristic_factory_;  // Creates the heuristic of every low level search
+    std::vector<std::vector<std::vector<const Action *>>> solutions_;  // Per group plans behind the last solve() result
 
     // Fast lookup from agent symbol to (group_idx, agent_idx_within_group)
     std::map<char, std::pair<uint_fast8_t, uint_fast8_t>> agent_symbol_to_group_info_;
     size_t total_agents_;
+    // Representative agent symbol of the group owning each box, in findFirstConflict's box order, 0 if none
+    std::vector<char> box_owner_symbols_;
+
+    // Walls-only shortest distances, keyed by source cell, for symmetry reasoning
+    std::map<Cell2D, std::vector<size_t>> distances_cache_;
+    size_t target_splits_count_;
+    size_t corridor_splits_count_;
+    size_t rectangle_splits_count_;
+    // Low level states generated and expanded, and CT nodes expanded, by the last solve()
+    size_t generated_states_count_;
+    size_t expanded_states_count_;
+    size_t expanded_nodes_count_;
 
    public:
     CBS() = delete;
-    CBS(const Level &loaded_level);
+    // A previous instance on the same static level lends its distance tables, so replanning after a failed action
+    // skips recomputing them
+    CBS(const Level &loaded_level, std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(),
+        const CBS *previous = nullptr);
+    CBS(const CBS &) = delete;
+    CBS &operator=(const CBS &) = delete;
     ~CBS();
 
     std::vector<std::vector<const Action *>> solve();
 
-   private:
-    std::vector<std::vector<const Action *>> mergePlans(std::vector<std::vector<std::vector<const Action *>>> &plans);
+    void setCancellationToken(const CancellationToken *cancellation_token) { cancellation_token_ = cancellation_token; }
+    // Windowed CBS: solve() stops at the first CT node without conflicts in the first `window` timesteps. Only that
+    // many first steps of the returned plan are then guaranteed conflict free, unless the plan is not longer.
+    void setConflictWindow(size_t window) { conflict_window_ = window; }
+    // Only the first full solve of a level pays for the warm start, later rounds and repairs replan from states
+    // close to a known plan
+    void setWarmStart(bool warm_start) { warm_start_ = warm_start; }
+    void setHeuristicFactory(std::function<Heuristic *()> heuristic_factory) { heuristic_factory_ = std::move(heuristic_factory); }
+
+    // True if the merged plan has none of the conflicts CBS resolves
+    bool isConflictFree(const std::vector<std::vector<const Action *>> &plan) const;
+
+    // Greedily moves each agent's actions into earlier NoOps while the plan stays applicable, conflict free
+    // and reaches the same final state, then drops trailing all-NoOp steps
+    std::vector<std::vector<const Action *>> compressPlan(
+        std::vector<std::vector<const Action *>> plan,
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) const;
+
+    std::vector<std::vector<const Action *>> mergePlans(const std::vector<std::vector<std::vector<const Action *>>> &plans) const;
+    // The level as it is after executing the merged plan prefix, nullptr if the prefix is not applicable.
+    // The caller owns the returned level.
+    Level *advanceLevel(const std::vector<std::vector<const Action *>> &prefix) const;
+    // Projects a joint plan onto the groups of this instance, dropping each group's trailing NoOps
+    std::vector<std::vector<std::vector<const Action *>>> splitPlan(const std::vector<std::vector<const Action *>> &plan) const;
+    const std::vector<LowLevelState *> &getGroupStates() const { return initial_agents_states_; }
+    // Goes back to the groups task allocation split, false if it split none. solve() does so when the split
+    // groups find no plan and there is no warm start plan to fall back to.
+    bool undoTaskAllocation();
+    const std::vector<std::vector<std::vector<const Action *>>> &getSolutions() const { return solutions_; }
+    size_t getGeneratedStatesCount() const { return generated_states_count_; }
+    size_t getExpandedStatesCount() const { return expanded_states_count_; }
+    size_t getExpandedNodesCount() const { return expanded_nodes_count_; }
+    size_t getTargetSplitsCount() const { return target_splits_count_; }
+    size_t getCorridorSplitsCount() const { return corridor_splits_count_; }
+    size_t getRectangleSplitsCount() const { return rectangle_splits_count_; }
+    // Own constraints of the group, plus the negative constraints implied by positive constraints of other groups
+    std::vector<Constraint> getGroupConstraints(const CTNode &node, size_t group_idx) const;
 
-    FullConflict findFirstConflict(const std::vector<std::vector<const Action *>> &solutions) const;
-    size_t findAgentResponsibleForBox(size_t box_index, const std::vector<const Action *> &actions,
-                                      const std::vector<Cell2D> &previous_agent_positions,
-                                      const std::vector<Cell2D> &previous_box_positions) const;
+   private:
+    // One group per agent color
+    std::vector<LowLevelState *> buildColorGroups() const;
+    // Color groups split by wall-separated regions. Inside a region, agents without boxes of their color
+    // plan alone and the others share the region's boxes. solve() merges the groups that turn out to conflict.
+    std::vector<LowLevelState *> buildIndependentGroups() const;
+    // Splits every group of several agents into one group per agent. Goals are matched to boxes, then the
+    // resulting tasks to agents, both by min-cost assignment over true distances. When it splits a group, the
+    // groups as they were are kept in unsplit_groups_.
+    std::vector<LowLevelState *> allocateTasks(const std::vector<LowLevelState *> &groups);
+    // Every box is owned by the group holding it, represented by the group's first agent
+    void assignBoxOwners();
+    // Replaces both groups by their union at group1_idx, group1_idx < group2_idx
+    void mergeGroups(size_t group1_idx, size_t group2_idx);
+
+    // Runs prioritized planning briefly to get an upper bound and a fallback plan
+    std::vector<std::vector<std::vector<const Action *>>> findWarmStartSolutions() const;
+
+    // Executes the merged plan on the whole level, false if some action is not applicable.
+    // Leaves the final agent positions and the box letter in every cell in the output arguments.
+    bool simulatePlan(const std::vector<std::vector<const Action *>> &plan, std::vector<Cell2D> &agent_positions,
+                      CharGrid &box_cells) const;
+
+    // Splits a conflict into the constraints of each child. Tries target, corridor and rectangle reasoning,
+    // which resolve a whole family of symmetric conflicts at once, before the plain vertex split.
+    std::vector<std::vector<OneSidedConflict>> splitConflict(const FullConflict &conflict, const CTNode &node,
+                                                             const std::vector<std::vector<const Action *>> &merged_plans);
+    // Disjoint split when USE_DISJOINT_SPLITTING is on: the first side is required to keep its cell in one child
+    // and forbidden from it in the other. Otherwise each side gets its own negative constraint.
+    std::vector<std::vector<OneSidedConflict>> splitPlainConflict(const FullConflict &conflict) const;
+    bool splitTargetConflict(const FullConflict &conflict, const CTNode &node, const std::vector<std::vector<Cell2D>> &trajectories,
+                             std::vector<std::vector<OneSidedConflict>> &branches) const;
+    bool splitCorridorConflict(const FullConflict &conflict, const std::vector<std::vector<Cell2D>> &trajectories,
+                               std::vector<std::vector<OneSidedConflict>> &branches);
+    bool splitRectangleConflict(const FullConflict &conflict, const std::vector<std::vector<Cell2D>> &trajectories,
+                                std::vector<std::vector<OneSidedConflict>> &branches) const;
+
+    // Occupancy of every planned group except group_idx, for the low level tie-breaking
+    void buildConflictAvoidanceTable(const std::vector<std::vector<std::vector<const Action *>>> &solutions, size_t group_idx,
+                                     ReservationTable &table) const;
+
+    bool isSingleAgentGroup(char agent_symbol) const;
+    bool isCorridorCell(const Cell2D &cell) const;
+    const std::vector<size_t> &getDistances(const Cell2D &from);
+    // Position of every agent at every timestep of the merged plan, starting with the initial positions
+    std::vector<std::vector<Cell2D>> getTrajectories(const std::vector<std::vector<const Action *>> &merged_plans) const;
+
+    // First conflict of the merged plan. With mergeable_only, only conflicts independence detection resolves by
+    // merging count: those between box-free groups of the same color. Actions from `window` on are not checked.
+    FullConflict findFirstConflict(const std::vector<std::vector<const Action *>> &solutions, bool mergeable_only = false,
+                                   size_t window = SIZE_MAX) const;
 
     // Helper function to build agent symbol mapping
     static std::pair<std::map<char, std::pair<uint_fast8_t, uint_fast8_t>>, size_t> buildAgentMapping(
@@ -21,18 +21,29 @@ class OneSidedConflict {
 class FullConflict {
    public:
     FullConflict(char a1_symbol, char a2_symbol, Constraint constraint)
-        : a1_symbol(a1_symbol), a2_symbol(a2_symbol), constraint(constraint) {}
+        : a1_symbol(a1_symbol), a2_symbol(a2_symbol), constraint(constraint), a1_constraint(constraint), a2_constraint(constraint) {}
+    // Each side gets the tightest constraint its own plan violates, e.g. the follower the cell at t and the
+    // leader the same cell at t - 1. `constraint` keeps the first side's one as the conflict location.
+    FullConflict(char a1_symbol, Constraint a1_constraint, char a2_symbol, Constraint a2_constraint)
+        : a1_symbol(a1_symbol),
+          a2_symbol(a2_symbol),
+          constraint(a1_constraint),
+          a1_constraint(a1_constraint),
+          a2_constraint(a2_constraint) {}
     ~FullConflict() = default;
 
     char a1_symbol;
     char a2_symbol;
     Constraint constraint;
+    Constraint a1_constraint;
+    Constraint a2_constraint;
 
     std::pair<OneSidedConflict, OneSidedConflict> split() const {
-        return {OneSidedConflict(a1_symbol, constraint), OneSidedConflict(a2_symbol, constraint)};
+        return {OneSidedConflict(a1_symbol, a1_constraint), OneSidedConflict(a2_symbol, a2_constraint)};
     }
 
     bool operator==(const FullConflict &other) const {
-        return a1_symbol == other.a1_symbol && a2_symbol == other.a2_symbol && constraint == other.constraint;
+        return a1_symbol == other.a1_symbol && a2_symbol == other.a2_symbol && a1_constraint == other.a1_constraint &&
+               a2_constraint == other.a2_constraint;
     }
 };
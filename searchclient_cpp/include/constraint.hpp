@@ -1,18 +1,51 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <tuple>
 
 #include "cell2d.hpp"
 
+// What a constraint forbids, or requires when it is positive (vertex and box constraints only)
+enum class ConstraintType {
+    Vertex,  // An agent of the group at vertex at time g
+    Edge,    // An agent of the group moving from `from` to vertex, arriving at time g
+    Box,     // A box of the group at vertex at time g
+    Range,   // An agent of the group at vertex at any time in [g, g_end]
+    Length,  // The group reaching its goal at or before time g
+};
+
 class Constraint {
    public:
+    static constexpr size_t FOREVER = SIZE_MAX;
+
     Constraint() = delete;
-    Constraint(Cell2D vertex, size_t g) : vertex(vertex), g(g) {}
+    Constraint(Cell2D vertex, size_t g) : type(ConstraintType::Vertex), vertex(vertex), from(vertex), g(g), g_end(g), positive(false) {}
+    Constraint(ConstraintType type, Cell2D vertex, Cell2D from, size_t g, size_t g_end, bool positive)
+        : type(type), vertex(vertex), from(from), g(g), g_end(g_end), positive(positive) {}
     ~Constraint() = default;
 
+    static Constraint edge(Cell2D from, Cell2D to, size_t g) { return Constraint(ConstraintType::Edge, to, from, g, g, false); }
+    static Constraint box(Cell2D cell, size_t g) { return Constraint(ConstraintType::Box, cell, cell, g, g, false); }
+    static Constraint range(Cell2D vertex, size_t g, size_t g_end) {
+        return Constraint(ConstraintType::Range, vertex, vertex, g, g_end, false);
+    }
+    static Constraint length(Cell2D goal, size_t g) { return Constraint(ConstraintType::Length, goal, goal, g, g, false); }
+    Constraint asPositive() const { return Constraint(type, vertex, from, g, g_end, true); }
+
+    ConstraintType type;
     Cell2D vertex;
+    Cell2D from;   // Source cell of edge constraints, equals vertex otherwise
     size_t g;
+    size_t g_end;  // Last forbidden timestep of range constraints, equals g otherwise
+    bool positive;
 
-    bool operator<(const Constraint &other) const { return vertex < other.vertex || (vertex == other.vertex && g < other.g); }
-    bool operator==(const Constraint &other) const { return vertex == other.vertex && g == other.g; }
-};
\ No newline at end of file
+    bool operator<(const Constraint &other) const {
+        return std::tie(type, vertex, from, g, g_end, positive) <
+               std::tie(other.type, other.vertex, other.from, other.g, other.g_end, other.positive);
+    }
+    bool operator==(const Constraint &other) const {
+        return type == other.type && vertex == other.vertex && from == other.from && g == other.g && g_end == other.g_end &&
+               positive == other.positive;
+    }
+};
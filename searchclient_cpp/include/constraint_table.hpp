@@ -0,0 +1,48 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "cell2d.hpp"
+#include "constraint.hpp"
+#include "low_level_state.hpp"
+
+// Constraints of one group indexed by timestep, so a state is checked only against the constraints of its own
+// timestep instead of the whole constraint list.
+class ConstraintTable {
+   private:
+    size_t horizon_;         // First timestep without timed constraints
+    size_t last_goal_ban_;   // Goals at or before this timestep are forbidden, SIZE_MAX if none
+    std::vector<std::vector<Cell2D>> vertices_;                      // [t] cells no agent may occupy
+    std::vector<std::vector<Cell2D>> boxes_;                         // [t] cells no box may occupy
+    std::vector<std::vector<std::pair<Cell2D, Cell2D>>> edges_;      // [t] (from, to) moves no agent may make
+    std::vector<std::vector<Cell2D>> positive_vertices_;             // [t] cells some agent must occupy
+    std::vector<std::vector<Cell2D>> positive_boxes_;                // [t] cells some box must occupy
+    std::vector<std::pair<Cell2D, size_t>> permanent_vertices_;      // (cell, from) no agent may occupy from then on
+    std::vector<Constraint> landmarks_;                              // Positive constraints, in no particular order
+
+    void ensureHorizon(size_t t);
+    bool isAllowedAt(const LowLevelState &state, size_t t, const std::vector<Agent> *previous_agents) const;
+    bool isGoalAllowedAt(const LowLevelState &state, size_t g) const;
+    // False if a landmark after t is farther away than the time left to reach it
+    bool canReachLandmarks(const LowLevelState &state, size_t t) const;
+
+    static bool hasAgentAt(const LowLevelState &state, const Cell2D &cell);
+    static bool hasBoxAt(const LowLevelState &state, const Cell2D &cell);
+
+   public:
+    ConstraintTable();
+    ~ConstraintTable() = default;
+
+    void build(const std::vector<Constraint> &constraints);
+
+    // Checks the state at its own timestep, edge constraints look at the move from its parent.
+    // Positive constraints also act as landmarks: states too far away to reach one in time are rejected early.
+    bool isAllowed(const LowLevelState &state) const;
+    // The group stays in its goal state forever, so every later constraint is checked against it too
+    bool isGoalAllowed(const LowLevelState &state) const;
+    // Checks an existing plan without searching, the group keeps standing on its final cells afterwards
+    bool isPlanAllowed(const LowLevelState &initial_state, const std::vector<std::vector<const Action *>> &plan) const;
+
+    inline size_t getHorizon() const { return horizon_; }
+};
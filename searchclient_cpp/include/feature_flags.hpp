@@ -4,12 +4,36 @@
 // #define USE_STATE_MEMORY_POOL  // WIP
 // #define USE_STATE_SHUFFLE
 // #define DISABLE_ACTION_PRINTING
+#define USE_PRIORITIZED_WARM_START
+#define USE_LNS_POST_OPTIMIZATION
+#define USE_PLAN_COMPRESSION
+#define USE_DISJOINT_SPLITTING
+#define USE_CONFLICT_AVOIDANCE
+#define USE_INDEPENDENCE_DETECTION
+#define USE_TASK_ALLOCATION
+#define USE_DEADLOCK_PRUNING
+#define USE_MACRO_SEARCH
+#define USE_CORRIDOR_COMPRESSION
+#define USE_HIERARCHICAL_HEURISTIC
+#define USE_SEARCH_STATS
 
 /********************************************************** */
 
 #define FLAG_USE_STATE_MEMORY_POOL_STR "USE_STATE_MEMORY_POOL "
 #define FLAG_USE_STATE_SHUFFLE_STR "USE_STATE_SHUFFLE "
 #define FLAG_DISABLE_ACTION_PRINTING_STR "DISABLE_ACTION_PRINTING "
+#define FLAG_USE_PRIORITIZED_WARM_START_STR "USE_PRIORITIZED_WARM_START "
+#define FLAG_USE_LNS_POST_OPTIMIZATION_STR "USE_LNS_POST_OPTIMIZATION "
+#define FLAG_USE_PLAN_COMPRESSION_STR "USE_PLAN_COMPRESSION "
+#define FLAG_USE_DISJOINT_SPLITTING_STR "USE_DISJOINT_SPLITTING "
+#define FLAG_USE_CONFLICT_AVOIDANCE_STR "USE_CONFLICT_AVOIDANCE "
+#define FLAG_USE_INDEPENDENCE_DETECTION_STR "USE_INDEPENDENCE_DETECTION "
+#define FLAG_USE_TASK_ALLOCATION_STR "USE_TASK_ALLOCATION "
+#define FLAG_USE_DEADLOCK_PRUNING_STR "USE_DEADLOCK_PRUNING "
+#define FLAG_USE_MACRO_SEARCH_STR "USE_MACRO_SEARCH "
+#define FLAG_USE_CORRIDOR_COMPRESSION_STR "USE_CORRIDOR_COMPRESSION "
+#define FLAG_USE_HIERARCHICAL_HEURISTIC_STR "USE_HIERARCHICAL_HEURISTIC "
+#define FLAG_USE_SEARCH_STATS_STR "USE_SEARCH_STATS "
 
 #define EMPTY_FLAG_STR ""
 
@@ -32,7 +56,79 @@
 #define _FF_PART3 EMPTY_FLAG_STR
 #endif
 
+#ifdef USE_PRIORITIZED_WARM_START
+#define _FF_PART4 FLAG_USE_PRIORITIZED_WARM_START_STR
+#else
+#define _FF_PART4 EMPTY_FLAG_STR
+#endif
+
+#ifdef USE_LNS_POST_OPTIMIZATION
+#define _FF_PART5 FLAG_USE_LNS_POST_OPTIMIZATION_STR
+#else
+#define _FF_PART5 EMPTY_FLAG_STR
+#endif
+
+#ifdef USE_PLAN_COMPRESSION
+#define _FF_PART6 FLAG_USE_PLAN_COMPRESSION_STR
+#else
+#define _FF_PART6 EMPTY_FLAG_STR
+#endif
+
+#ifdef USE_DISJOINT_SPLITTING
+#define _FF_PART7 FLAG_USE_DISJOINT_SPLITTING_STR
+#else
+#define _FF_PART7 EMPTY_FLAG_STR
+#endif
+
+#ifdef USE_CONFLICT_AVOIDANCE
+#define _FF_PART8 FLAG_USE_CONFLICT_AVOIDANCE_STR
+#else
+#define _FF_PART8 EMPTY_FLAG_STR
+#endif
+
+#ifdef USE_INDEPENDENCE_DETECTION
+#define _FF_PART9 FLAG_USE_INDEPENDENCE_DETECTION_STR
+#else
+#define _FF_PART9 EMPTY_FLAG_STR
+#endif
+
+#ifdef USE_TASK_ALLOCATION
+#define _FF_PART10 FLAG_USE_TASK_ALLOCATION_STR
+#else
+#define _FF_PART10 EMPTY_FLAG_STR
+#endif
+
+#ifdef USE_DEADLOCK_PRUNING
+#define _FF_PART11 FLAG_USE_DEADLOCK_PRUNING_STR
+#else
+#define _FF_PART11 EMPTY_FLAG_STR
+#endif
+
+#ifdef USE_MACRO_SEARCH
+#define _FF_PART12 FLAG_USE_MACRO_SEARCH_STR
+#else
+#define _FF_PART12 EMPTY_FLAG_STR
+#endif
+
+#ifdef USE_CORRIDOR_COMPRESSION
+#define _FF_PART13 FLAG_USE_CORRIDOR_COMPRESSION_STR
+#else
+#define _FF_PART13 EMPTY_FLAG_STR
+#endif
+
+#ifdef USE_HIERARCHICAL_HEURISTIC
+#define _FF_PART14 FLAG_USE_HIERARCHICAL_HEURISTIC_STR
+#else
+#define _FF_PART14 EMPTY_FLAG_STR
+#endif
+
+#ifdef USE_SEARCH_STATS
+#define _FF_PART15 FLAG_USE_SEARCH_STATS_STR
+#else
+#define _FF_PART15 EMPTY_FLAG_STR
+#endif
+
 // Concatenate the parts to form the full feature string
-#define ENABLED_FEATURE_FLAGS _FF_PART1 _FF_PART2 _FF_PART3
+#define ENABLED_FEATURE_FLAGS _FF_PART1 _FF_PART2 _FF_PART3 _FF_PART4 _FF_PART5 _FF_PART6 _FF_PART7 _FF_PART8 _FF_PART9 _FF_PART10 _FF_PART11 _FF_PART12 _FF_PART13 _FF_PART14 _FF_PART15
 
 inline constexpr const char *getFeatureFlags() { return ENABLED_FEATURE_FLAGS; }
\ No newline at end of file
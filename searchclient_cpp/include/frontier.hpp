@@ -9,6 +9,8 @@
 
 #include "heuristic.hpp"
 #include "low_level_state.hpp"
+#include "reservation_table.hpp"
+#include "search_stats.hpp"
 
 class Frontier {
    public:
@@ -20,6 +22,8 @@ class Frontier {
     virtual bool contains(LowLevelState* state) const = 0;
     virtual void clear() = 0;
     virtual std::string getName() const = 0;
+    // Occupancy of the other groups' plans, used to break ties towards fewer conflicts with them
+    virtual void setConflictAvoidanceTable(const ReservationTable* table) { (void)table; }
 };
 
 // Breadth-First Search Frontier
@@ -118,20 +122,51 @@ class FrontierBestFirst : public Frontier {
    private:
     const Heuristic* heuristic_;
     std::unordered_set<LowLevelState*, LowLevelStatePtrHash, LowLevelStatePtrEqual> set_;
+    const ReservationTable* conflict_avoidance_table_;
 
-    struct StateComparator {
-        const Heuristic* heur;
-        StateComparator(const Heuristic* heuristic) : heur(heuristic) {}
-        bool operator()(const LowLevelState* lhs, const LowLevelState* rhs) const {
-            // Higher f-value means lower priority (further down the max-heap)
-            return heur->f(*lhs) > heur->f(*rhs);
+    // f is computed once on insertion, conflicts counts the cells shared with other groups along the path
+    struct Entry {
+        LowLevelState* state;
+        size_t f;
+        size_t conflicts;
+    };
+
+    struct EntryComparator {
+        bool operator()(const Entry& lhs, const Entry& rhs) const {
+            // Higher f-value means lower priority (further down the max-heap), ties go to fewer conflicts
+            if (lhs.f != rhs.f) {
+                return lhs.f > rhs.f;
+            }
+            return lhs.conflicts > rhs.conflicts;
         }
     };
 
-    std::priority_queue<LowLevelState*, std::vector<LowLevelState*>, StateComparator> queue_;
+    std::priority_queue<Entry, std::vector<Entry>, EntryComparator> queue_;
+    // Children are added right after their parent is popped, so its path conflicts are still at hand
+    const LowLevelState* last_popped_;
+    size_t last_popped_conflicts_;
+
+    // Cells shared with another group now, cells entered right after it left and cells left as it enters
+    size_t countConflicts(const LowLevelState& state) const {
+        if (!conflict_avoidance_table_) {
+            return 0;
+        }
+        const size_t g = state.getG();
+        size_t conflicts = 0;
+        for (const auto& cell : state.getOccupiedCells()) {
+            conflicts += conflict_avoidance_table_->isReserved(cell, g) || (g > 0 && conflict_avoidance_table_->isReserved(cell, g - 1));
+        }
+        if (state.parent) {
+            for (const auto& cell : state.parent->getOccupiedCells()) {
+                conflicts += conflict_avoidance_table_->isReserved(cell, g);
+            }
+        }
+        return conflicts;
+    }
 
    public:
-    FrontierBestFirst(const Heuristic* heuristic) : heuristic_(heuristic), queue_(StateComparator(heuristic)) {
+    FrontierBestFirst(const Heuristic* heuristic)
+        : heuristic_(heuristic), set_(), conflict_avoidance_table_(nullptr), queue_(), last_popped_(nullptr), last_popped_conflicts_(0) {
         if (!heuristic_) {
             throw std::invalid_argument("Heuristic cannot be null for FrontierBestFirst.");
         }
@@ -146,7 +181,11 @@ class FrontierBestFirst : public Frontier {
     }
 
     void add(LowLevelState* state) override {
-        queue_.push(state);
+        const size_t parent_conflicts = state->parent && state->parent == last_popped_ ? last_popped_conflicts_ : 0;
+        const auto started = SearchStats::start();
+        const size_t f = heuristic_->f(*state);
+        SearchStats::addTime(SearchStats::HEURISTIC, started);
+        queue_.push({state, f, parent_conflicts + countConflicts(*state)});
         set_.insert(state);
     }
 
@@ -154,10 +193,12 @@ class FrontierBestFirst : public Frontier {
         if (isEmpty()) {
             throw std::runtime_error("Cannot pop from an empty BestFirst frontier.");
         }
-        LowLevelState* state = queue_.top();
+        const Entry entry = queue_.top();
         queue_.pop();
-        set_.erase(state);
-        return state;
+        set_.erase(entry.state);
+        last_popped_ = entry.state;
+        last_popped_conflicts_ = entry.conflicts;
+        return entry.state;
     }
 
     bool isEmpty() const override { return set_.empty(); }
@@ -171,9 +212,13 @@ class FrontierBestFirst : public Frontier {
             delete state;
         }
         // Clear the priority_queue by creating a new empty one
-        queue_ = std::priority_queue<LowLevelState*, std::vector<LowLevelState*>, StateComparator>(StateComparator(heuristic_));
+        queue_ = std::priority_queue<Entry, std::vector<Entry>, EntryComparator>();
         set_.clear();
+        last_popped_ = nullptr;
+        last_popped_conflicts_ = 0;
     }
 
+    void setConflictAvoidanceTable(const ReservationTable* table) override { conflict_avoidance_table_ = table; }
+
     std::string getName() const override { return "best-first search using " + heuristic_->getName(); }
 };
@@ -1,86 +1,211 @@
 #pragma once
 
+#include <chrono>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "cancellation_token.hpp"
 #include "constraint.hpp"
+#include "constraint_table.hpp"
+#include "feature_flags.hpp"
 #include "frontier.hpp"
 #include "low_level_state.hpp"
 #include "memory.hpp"
+#include "reservation_table.hpp"
+#include "search_stats.hpp"
 #include "state.hpp"
 
 class Graphsearch {
    private:
+    // Macro search needs at least this share of the free cells to be corridor cells
+    static constexpr double MACRO_MIN_CORRIDOR_SHARE = 0.5;
+
     LowLevelState *initial_state_;
     Frontier *frontier_;
     std::unordered_set<LowLevelState *, LowLevelStatePtrHash, LowLevelStatePtrEqual> explored_;
+    // States before time_horizon_ are told apart by their timestep, since constraints or reservations still change
+    std::unordered_set<LowLevelState *, LowLevelStateTimedPtrHash, LowLevelStateTimedPtrEqual> timed_explored_;
+    struct MacroKeyHash {
+        size_t operator()(const std::vector<Cell2D> &key) const {
+            size_t hash = key.size();
+            for (const auto &cell : key) {
+                utils::hashCombine(hash, cell);
+            }
+            return hash;
+        }
+    };
+    // Lowest g generated for each macro key, so states equal up to walking are expanded again only when reached cheaper
+    std::unordered_map<std::vector<Cell2D>, size_t, MacroKeyHash> macro_generated_;
+    ConstraintTable constraint_table_;
+    size_t time_horizon_;
+    bool macro_search_;
+    bool corridor_traversals_;
     size_t generated_states_count_;
+    size_t expanded_states_count_;
+    size_t duplicates_pruned_count_;  // Children already explored or in the frontier
     bool solution_found_;
+    std::chrono::steady_clock::time_point deadline_;
+    const CancellationToken *cancellation_token_;
+
+    void clearExplored() {
+        for (auto state : explored_) {
+            delete state;
+        }
+        for (auto state : timed_explored_) {
+            delete state;
+        }
+        explored_.clear();
+        timed_explored_.clear();
+        macro_generated_.clear();
+    }
+
+    static size_t getTimeHorizon(const ConstraintTable &constraint_table, const ReservationTable *reservations) {
+        const size_t horizon = reservations ? reservations->getHorizon() : 0;
+        return std::max(horizon, constraint_table.getHorizon());
+    }
 
    public:
     Graphsearch() = delete;
     Graphsearch(LowLevelState *initial_state, Frontier *frontier)
-        : initial_state_(initial_state), frontier_(frontier), generated_states_count_(0), solution_found_(false) {
+        : initial_state_(initial_state),
+          frontier_(frontier),
+          explored_(),
+          timed_explored_(),
+          macro_generated_(),
+          constraint_table_(),
+          time_horizon_(0),
+          macro_search_(false),
+          corridor_traversals_(false),
+          generated_states_count_(0),
+          expanded_states_count_(0),
+          duplicates_pruned_count_(0),
+          solution_found_(false),
+          deadline_(std::chrono::steady_clock::time_point::max()),
+          cancellation_token_(nullptr) {
         explored_.reserve(1'000);
     }
     Graphsearch(const Graphsearch &) = delete;
     Graphsearch &operator=(const Graphsearch &) = delete;
-    ~Graphsearch() { delete frontier_; }
+    ~Graphsearch() {
+        clearExplored();
+        delete frontier_;
+    }
 
-    bool areConstraintsSatisfied(const LowLevelState *state, const std::vector<Constraint> &constraints) const {
-        for (const auto &constraint : constraints) {
-            if (constraint.g != state->getG()) {
-                continue;
-            }
+    void setDeadline(const std::chrono::steady_clock::time_point &deadline) { deadline_ = deadline; }
+    void setCancellationToken(const CancellationToken *cancellation_token) { cancellation_token_ = cancellation_token; }
+    void setConflictAvoidanceTable(const ReservationTable *table) { frontier_->setConflictAvoidanceTable(table); }
 
-            for (size_t i = 0; i < state->agents.size(); ++i) {
-                if (constraint.vertex == state->agents[i].getPosition()) {
-                    return false;
-                }
+    // A child may not enter a cell reserved now or in the previous step, nor leave a cell someone else enters.
+    bool areReservationsRespected(const LowLevelState *state, const ReservationTable *reservations) const {
+        if (!reservations || !state->parent) {
+            return true;
+        }
+        const size_t g = state->getG();
+        for (const auto &cell : state->getOccupiedCells()) {
+            if (reservations->isReserved(cell, g) || reservations->isReserved(cell, g - 1)) {
+                return false;
+            }
+        }
+        for (const auto &cell : state->parent->getOccupiedCells()) {
+            if (reservations->isReserved(cell, g)) {
+                return false;
             }
         }
         return true;
     }
 
-    bool isTemporallyExplored(const LowLevelState *state, const std::vector<Constraint> &constraints) const {
-        // If no constraints at all, use standard duplicate detection
-        if (constraints.empty()) {
-            for (const auto *explored_state : explored_) {
-                if (*state == *explored_state) {
-                    return true;
-                }
+    // The group stays on its final cells forever, so nobody may reserve them later
+    bool isGoalReservationFree(const LowLevelState *state, const ReservationTable *reservations) const {
+        if (!reservations) {
+            return true;
+        }
+        for (const auto &cell : state->getOccupiedCells()) {
+            if (reservations->isReservedFrom(cell, state->getG())) {
+                return false;
             }
-            return false;
         }
+        return true;
+    }
 
-        // Check if any state in explored set is temporally equivalent to this state
-        // Optimize by limiting search scope to prevent performance degradation
-        // size_t checks = 0;
-        for (const auto *explored_state : explored_) {
-            // if (++checks > 500) break;  // Cap expensive searches
-            if (state->temporalEquals(*explored_state, constraints)) {
-                return true;
-            }
+    // Records the macro state, false if one equal up to walking was generated before with a g no higher. A cheaper
+    // state re-opens its key. An identical state already explored or in the frontier is still dropped as a duplicate,
+    // as in the primitive search, so macro plans are not guaranteed to be the shortest.
+    bool isNewMacroState(const LowLevelState *state) {
+        const auto inserted = macro_generated_.emplace(state->getMacroKey(), state->getG());
+        if (inserted.second) {
+            return true;
+        }
+        if (state->getG() < inserted.first->second) {
+            inserted.first->second = state->getG();
+            return true;
         }
         return false;
     }
 
+    bool isTemporallyExplored(LowLevelState *state) const {
+        if (state->getG() < time_horizon_) {
+            return timed_explored_.count(state);
+        }
+        return explored_.count(state);
+    }
+
     // void printSearchStatus() const {
     //     fprintf(stdout, "Agent %d: %d\n", initial_state_->agent_bul.getColor(), initial_state_->agent_bulk.getSymbol());
     //     fflush(stdout);
     // }
 
-    std::vector<std::vector<const Action *>> solve(const std::vector<Constraint> &constraints) {
-        size_t iterations = 0;
+    std::vector<std::vector<const Action *>> solve(const std::vector<Constraint> &constraints,
+                                                   const ReservationTable *reservations = nullptr) {
+        const auto started = SearchStats::start();
+        auto plan = search(constraints, reservations);
+        SearchStats::addTime(SearchStats::LOW_LEVEL_SEARCH, started);
+        SearchStats::add(SearchStats::LOW_LEVEL_CALLS);
+        SearchStats::add(SearchStats::LOW_LEVEL_EXPANDED, expanded_states_count_);
+        SearchStats::add(SearchStats::LOW_LEVEL_GENERATED, generated_states_count_);
+        SearchStats::add(SearchStats::LOW_LEVEL_DUPLICATES_PRUNED, duplicates_pruned_count_);
+        SearchStats::updatePeak(SearchStats::STATES_HELD, explored_.size() + timed_explored_.size() + frontier_->size());
+        return plan;
+    }
+
+    // Getter methods for tracking information
+    size_t getGeneratedStatesCount() const { return generated_states_count_; }
+    size_t getExpandedStatesCount() const { return expanded_states_count_; }
+    size_t getDuplicatesPrunedCount() const { return duplicates_pruned_count_; }
+    bool wasSolutionFound() const { return solution_found_; }
+
+   private:
+    std::vector<std::vector<const Action *>> search(const std::vector<Constraint> &constraints, const ReservationTable *reservations) {
+        size_t &iterations = expanded_states_count_;
 
         // Reset tracking variables for new search
+        iterations = 0;
         generated_states_count_ = 0;
+        duplicates_pruned_count_ = 0;
         solution_found_ = false;
+        constraint_table_.build(constraints);
+        time_horizon_ = getTimeHorizon(constraint_table_, reservations);
+#ifdef USE_MACRO_SEARCH
+        // Walks skip timesteps, so macro successors only stand in for primitive ones while nothing is timed.
+        // In open rooms the agent's step-by-step guidance from the heuristic beats them.
+        macro_search_ = initial_state_->agents.size() == 1 && constraints.empty() && !reservations &&
+                        initial_state_->getStaticLevel().getCorridorShare() >= MACRO_MIN_CORRIDOR_SHARE;
+#endif
+#ifdef USE_CORRIDOR_COMPRESSION
+        // Traversals skip timesteps as well. Primitive moves are kept next to them, so boxes still get pulled into corridors.
+        corridor_traversals_ = !macro_search_ && initial_state_->agents.size() == 1 && constraints.empty() && !reservations;
+#endif
 
         // Clear frontier and explored set for new search
         frontier_->clear();
-        explored_.clear();
+        clearExplored();
 
+        if (!constraint_table_.isAllowed(*initial_state_)) {
+            return {};  // Constrained away from where the group starts
+        }
+        if (macro_search_) {
+            isNewMacroState(initial_state_);
+        }
         frontier_->add(initial_state_->clone());
 
         while (true) {
@@ -89,6 +214,14 @@ class Graphsearch {
                 return {};
             }
 
+            if (iterations % 100 == 0 && std::chrono::steady_clock::now() > deadline_) {
+                return {};
+            }
+
+            if (iterations % 100 == 0 && cancellation_token_ && cancellation_token_->isCancelled()) {
+                return {};
+            }
+
             if (frontier_->isEmpty()) {
                 // fprintf(stderr, "Frontier is empty.\n");
                 return {};
@@ -96,31 +229,44 @@ class Graphsearch {
 
             LowLevelState *state = frontier_->pop();
 
-            if (state->isGoalState() && areConstraintsSatisfied(state, constraints)) {
+            if (state->isGoalState() && constraint_table_.isGoalAllowed(*state) && isGoalReservationFree(state, reservations)) {
                 solution_found_ = true;
-                return state->extractPlan();
+                auto plan = state->extractPlan();
+                delete state;
+                return plan;
             }
 
-            auto expanded_states = state->getExpandedStates();
+            auto expanded_states = macro_search_ ? state->getMacroExpandedStates() : state->getExpandedStates();
+            if (corridor_traversals_) {
+                auto traversals = state->getCorridorTraversals();
+                expanded_states.insert(expanded_states.end(), traversals.begin(), traversals.end());
+            }
             generated_states_count_ += expanded_states.size();
 
             for (auto child : expanded_states) {
-                bool explored = isTemporallyExplored(child, constraints);
+                // Goal states are told apart from their key by where the agent ends
+                if (macro_search_ && !child->isGoalState() && !isNewMacroState(child)) {
+                    duplicates_pruned_count_++;
+                    delete child;
+                    continue;
+                }
+                bool explored = isTemporallyExplored(child);
                 bool in_frontier = frontier_->contains(child);
-                bool constraints_satisfied = areConstraintsSatisfied(child, constraints);
+                bool constraints_satisfied = constraint_table_.isAllowed(*child) && areReservationsRespected(child, reservations);
                 if (!explored && !in_frontier && constraints_satisfied) {
                     frontier_->add(child);
                     continue;
                 }
+                duplicates_pruned_count_ += explored || in_frontier;
                 delete child;
             }
 
-            explored_.insert(state);
+            if (state->getG() < time_horizon_) {
+                timed_explored_.insert(state);
+            } else {
+                explored_.insert(state);
+            }
             iterations++;
         }
     }
-
-    // Getter methods for tracking information
-    size_t getGeneratedStatesCount() const { return generated_states_count_; }
-    bool wasSolutionFound() const { return solution_found_; }
 };
@@ -7,6 +7,8 @@
 #include <unordered_map>
 #include <vector>
 
+#include "assignment.hpp"
+#include "feature_flags.hpp"
 #include "low_level_state.hpp"
 
 class Heuristic {
@@ -31,6 +33,22 @@ class HeuristicAStar : public Heuristic {
     static constexpr int MOVE_COST = 2;
     static constexpr int PUSH_PULL_COST = 3;  // Push/Pull actions are more expensive
 
+    // Box-goal matching of one bulk, solved for the box positions of some recently evaluated state
+    struct BulkMatching {
+        std::vector<Cell2D> goals;
+        std::vector<std::vector<size_t>> goal_distances;  // Per goal, true distance from every cell
+        std::vector<Cell2D> positions;
+        Assignment assignment;  // Rows are boxes, columns are goals then free columns for surplus boxes
+        Assignment scratch;     // States one box away from `positions` are solved here
+
+        BulkMatching(const StaticLevel& static_level, const BoxBulk& bulk);
+    };
+    mutable std::vector<BulkMatching> matchings_;
+    // On levels with a cluster abstraction, abstract distances from every portal to each agent goal, by cell index
+    mutable std::unordered_map<size_t, std::vector<size_t>> portal_distances_;
+    // Abstract distances can exceed the true ones, so only heuristics that already give up optimality use them
+    bool abstract_distances_;
+
     size_t manhattanDistance(const Cell2D& from, const Cell2D& to) const { return std::abs(from.r - to.r) + std::abs(from.c - to.c); }
 
     // Calculate cost for agent to manipulate a specific box to goal
@@ -43,68 +61,83 @@ class HeuristicAStar : public Heuristic {
         return agent_to_box + box_to_goal;
     }
 
+    // Optimal box-goal matching of a bulk in `state`
+    const Assignment& matchBoxes(const LowLevelState& state, size_t bulk_idx) const;
+
+    // Walking distance of an agent to one of its goals. Manhattan, or with abstract distances the abstract distance
+    // on large levels where walls between rooms make Manhattan misleading.
+    size_t walkingDistance(const StaticLevel& static_level, const Cell2D& from, const Cell2D& to) const;
+
+   protected:
+    explicit HeuristicAStar(bool abstract_distances) : matchings_(), portal_distances_(), abstract_distances_(abstract_distances) {}
+
    public:
-    HeuristicAStar() {}
+    HeuristicAStar() : HeuristicAStar(false) {}
 
     size_t f(const LowLevelState& state) const override { return state.getG() + h(state); }
 
+    // A lower bound on the joint timesteps left. Each agent moves at most one cell per step and moves at most one box,
+    // so the group needs as many steps as its furthest agent is from its goal, and, while a box is off its matched
+    // goal, the walk of the nearest agent up to a box followed by the matched box moves shared among the agents.
     size_t h(const LowLevelState& state) const override {
-        // Simple Manhattan distance heuristic
-        size_t total_cost = 0;
-
-        // Agent distances to their goals
+        size_t agents_cost = 0;
         for (const auto& agent : state.agents) {
             const auto& agent_goals = agent.getGoalPositions();
             if (!agent_goals.empty()) {
                 size_t min_dist = SIZE_MAX;
                 for (const auto& goal : agent_goals) {
-                    min_dist = std::min(min_dist, manhattanDistance(agent.getPosition(), goal));
+                    min_dist = std::min(min_dist, walkingDistance(state.getStaticLevel(), agent.getPosition(), goal));
                 }
-                total_cost += min_dist;
+                agents_cost = std::max(agents_cost, min_dist);
             }
         }
 
-        // Box distances to their goals - only consider N best boxes where N = number of goals
-        for (const auto& box_bulk : state.getBoxBulks()) {
-            if (box_bulk.getGoalsCount() <= 0) {
-                continue;
+        // Every goal gets its own box: true distances under a min-cost matching
+        size_t box_moves = 0;
+        for (size_t bulk_idx = 0; bulk_idx < state.box_bulks.size(); bulk_idx++) {
+            if (state.box_bulks[bulk_idx].hasGoals()) {
+                box_moves += matchBoxes(state, bulk_idx).getCost();
             }
-            // Collect all boxes with their distances to closest goals
-            std::vector<std::pair<size_t, size_t>> box_distances;  // pair<distance, box_index>
+        }
+        if (box_moves == 0 || state.agents.empty()) {
+            return agents_cost;
+        }
 
-            for (size_t i = 0; i < box_bulk.size(); i++) {
-                Cell2D box_pos = box_bulk.getPosition(i);
-                size_t min_dist = SIZE_MAX;
-                for (size_t j = 0; j < box_bulk.getGoalsCount(); j++) {
-                    min_dist = std::min(min_dist, manhattanDistance(box_pos, box_bulk.getGoal(j)));
-                }
-                if (min_dist != SIZE_MAX) {
-                    box_distances.push_back({min_dist, i});
+        // No box moves before some agent stands next to one
+        size_t agent_to_box_dist = SIZE_MAX;
+        for (const auto& box_bulk : state.box_bulks) {
+            for (const auto& position : box_bulk.getPositions()) {
+                for (const auto& agent : state.agents) {
+                    agent_to_box_dist = std::min(agent_to_box_dist, manhattanDistance(agent.getPosition(), position) - 1);
                 }
             }
+        }
+        const size_t boxes_cost = agent_to_box_dist + (box_moves + state.agents.size() - 1) / state.agents.size();
+        return std::max(agents_cost, boxes_cost);
+    }
+
+    std::string getName() const override { return "Modified A*"; }
+};
 
-            // Sort by distance (shortest first)
-            std::sort(box_distances.begin(), box_distances.end());
+// Weighted A*: inflates h to reach a goal with fewer expansions, plans are no longer optimal
+class HeuristicWeightedAStar : public HeuristicAStar {
+   private:
+    size_t weight_;
 
-            std::vector<std::pair<size_t, size_t>> box_agents_distances;
-            for (size_t i = 0; i < box_distances.size(); i++) {
-                // Add box-to-goal distance plus agent-to-box distance
-                Cell2D box_pos = box_bulk.getPosition(box_distances[i].second);
-                Cell2D agent_pos = state.agents[0].getPosition();  // Use first agent for simplicity
-                size_t agent_to_box_dist = manhattanDistance(agent_pos, box_pos);
-                box_agents_distances.push_back({box_distances[i].first + agent_to_box_dist, i});
-            }
+   public:
+    explicit HeuristicWeightedAStar(size_t weight) : HeuristicAStar(true), weight_(weight) {}
 
-            // Only consider the N closest boxes where N = number of goals
-            std::sort(box_agents_distances.begin(), box_agents_distances.end());
+    size_t f(const LowLevelState& state) const override { return state.getG() + weight_ * h(state); }
 
-            for (size_t i = 0; i < box_bulk.getGoalsCount(); i++) {
-                total_cost += box_agents_distances[i].first;
-            }
-        }
+    std::string getName() const override { return "Weighted A* (" + std::to_string(weight_) + ")"; }
+};
 
-        return total_cost;
-    }
+// Greedy best-first: orders by h alone, fastest to a goal and furthest from optimal
+class HeuristicGreedy : public HeuristicAStar {
+   public:
+    HeuristicGreedy() : HeuristicAStar(true) {}
 
-    std::string getName() const override { return "Modified A*"; }
+    size_t f(const LowLevelState& state) const override { return h(state); }
+
+    std::string getName() const override { return "Greedy"; }
 };
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "cell2d.hpp"
+
+// HPA* abstraction of a grid: square clusters joined by portals on their borders. Distances between the
+// portals of a cluster are cached at build time, so routes across the level are searched on the portal
+// graph and only refined cell by cell inside the clusters they pass. The search only uses the abstract
+// distances, as the walking distances of weighted A* and greedy; nothing plans with findPath's routes yet.
+class HierarchicalMap {
+   public:
+    static constexpr size_t CLUSTER_SIZE = 10;
+    // Entrances at least this wide get a portal at both ends instead of a single one in the middle
+    static constexpr size_t WIDE_ENTRANCE = 6;
+
+   private:
+    struct Portal {
+        Cell2D cell;
+        size_t cluster;
+        std::vector<size_t> local_distances;           // Per cell of the cluster, BFS distance inside the cluster
+        std::vector<std::pair<size_t, size_t>> edges;  // (portal, cost)
+
+        Portal() : cell(), cluster(0), local_distances(), edges() {}
+        Portal(const Cell2D &cell, size_t cluster) : cell(cell), cluster(cluster), local_distances(), edges() {}
+    };
+
+    size_t rows_, cols_;
+    std::vector<bool> free_;
+    size_t cluster_size_;
+    size_t cluster_cols_;
+    std::vector<Portal> portals_;
+    std::vector<std::vector<size_t>> cluster_portals_;
+    std::vector<size_t> portal_at_;  // Per cell, index into portals_, SIZE_MAX elsewhere
+
+    inline size_t clusterOf(const Cell2D &cell) const { return (cell.r / cluster_size_) * cluster_cols_ + cell.c / cluster_size_; }
+    inline size_t localIndex(const Cell2D &cell) const { return (cell.r % cluster_size_) * cluster_size_ + cell.c % cluster_size_; }
+    inline bool isFree(const Cell2D &cell) const { return cell.r < rows_ && cell.c < cols_ && free_[cell.r * cols_ + cell.c]; }
+
+    friend class LevelCache;  // Stores and restores the whole abstraction
+
+    size_t addPortal(const Cell2D &cell);
+    void addEntrances(const Cell2D &first, const Cell2D &step, const Cell2D &across, size_t length);
+    // BFS that never leaves the cluster of `from`. Distances per local index, `parents` gets the previous cell.
+    std::vector<size_t> searchCluster(const Cell2D &from, std::vector<Cell2D> *parents = nullptr) const;
+    // Appends the cells after `from` of a shortest path to `to` inside their cluster
+    void appendLocalPath(const Cell2D &from, const Cell2D &to, std::vector<Cell2D> &path) const;
+
+   public:
+    HierarchicalMap() : rows_(0), cols_(0), free_(), cluster_size_(CLUSTER_SIZE), cluster_cols_(0), portals_(), cluster_portals_(), portal_at_() {}
+    // `free_cells` is row-major, true where there is no wall
+    HierarchicalMap(size_t rows, size_t cols, const std::vector<bool> &free_cells, size_t cluster_size = CLUSTER_SIZE);
+
+    inline bool empty() const { return cluster_portals_.empty(); }
+    inline size_t getClusterCount() const { return cluster_portals_.size(); }
+    inline size_t getPortalCount() const { return portals_.size(); }
+
+    // Abstract distance from every portal to `to`, SIZE_MAX where unreachable. Computed once per target,
+    // then queried with getDistance for any number of sources.
+    std::vector<size_t> computePortalDistances(const Cell2D &to) const;
+    // Length of the shortest route from `from` to `to` that stays inside clusters between portals.
+    // Never shorter than the true distance, SIZE_MAX when `to` cannot be reached.
+    size_t getDistance(const std::vector<size_t> &portal_distances, const Cell2D &from, const Cell2D &to) const;
+    size_t getDistance(const Cell2D &from, const Cell2D &to) const { return getDistance(computePortalDistances(to), from, to); }
+    // Cells of the route measured by getDistance, from `from` to `to` included. Empty when unreachable.
+    std::vector<Cell2D> findPath(const Cell2D &from, const Cell2D &to) const;
+};
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "agent.hpp"
@@ -10,6 +11,7 @@
 #include "cell2d.hpp"
 #include "chargrid.hpp"
 #include "color.hpp"
+#include "hierarchical_map.hpp"
 
 #define WALL '+'
 #define EMPTY ' '
@@ -18,7 +20,20 @@
 #define FIRST_BOX 'A'
 #define LAST_BOX 'Z'
 
+// A maximal chain of free cells with exactly two free neighbours each. `ends` are the cells just outside
+// the chain on either side: junctions, rooms or dead ends.
+struct CorridorSegment {
+    std::vector<Cell2D> cells;  // From the ends[0] side to the ends[1] side
+    Cell2D ends[2];
+
+    CorridorSegment() : cells(), ends() {}
+};
+
 class StaticLevel {
+   public:
+    // Levels with at least this many cells, larger than any competition level, get a cluster abstraction
+    static constexpr size_t HIERARCHY_MIN_CELLS = 64 * 64;
+
    private:
     std::string name_;
     std::string domain_;
@@ -27,15 +42,56 @@ class StaticLevel {
     std::map<char, Color> agent_colors_;
     std::map<char, Color> box_colors_;
 
+    // Per box letter, cells from which no goal of that letter can be reached by pushes and pulls.
+    // Empty for letters with more boxes than goals, a surplus box may be parked anywhere.
+    std::vector<std::vector<bool>> dead_squares_;
+    double corridor_share_;  // Share of the free cells with at most two free neighbours
+
+    // Compressed level graph: corridor segments between the junction and room cells
+    std::vector<CorridorSegment> segments_;
+    std::vector<size_t> segment_of_;  // Per cell, index into segments_, SIZE_MAX outside corridors
+    void buildCorridorGraph();
+
+    HierarchicalMap hierarchy_;  // Empty on levels below HIERARCHY_MIN_CELLS
+
+    // Cells from which a box can be brought onto one of the goals, ignoring agents and other boxes
+    std::vector<bool> computeLiveSquares(const std::vector<Cell2D> &goals, bool allow_pulls) const;
+
+    // Without `analyse` the precomputed tables stay empty, a LevelCache snapshot fills them in
+    friend class LevelCache;
+    StaticLevel(std::string name, std::string domain, CharGrid walls, std::map<char, Color> agent_colors, std::map<char, Color> box_colors,
+                bool analyse);
+
    public:
     StaticLevel() = delete;
-    StaticLevel(std::string name, std::string domain, CharGrid walls, std::map<char, Color> agent_colors, std::map<char, Color> box_colors);
+    StaticLevel(std::string name, std::string domain, CharGrid walls, std::map<char, Color> agent_colors, std::map<char, Color> box_colors)
+        : StaticLevel(std::move(name), std::move(domain), std::move(walls), std::move(agent_colors), std::move(box_colors), true) {}
+    StaticLevel(const StaticLevel &) = default;
+    StaticLevel(StaticLevel &&) = default;  // The precomputed tables are large, restored levels hand them over
     ~StaticLevel() = default;
 
     bool isCellFree(const Cell2D &cell) const;
+    // Walls-only BFS distances from `from` to every cell (row-major), SIZE_MAX where unreachable
+    std::vector<size_t> computeDistances(const Cell2D &from) const;
+
+    // Finds the dead squares of every box letter. Returns how many (letter, cell) pairs connected to a goal
+    // of the letter are dead with push and pull moves, and how many would be with pushes alone.
+    // Every push or pull can be undone by the opposite action, so with pulls a box never gets stuck: only cells
+    // walled off from every goal are dead, and no box starts there on a solvable level. Boxes no agent can move
+    // are walls already, so there are no frozen boxes to detect either. The pass found no dead square connected
+    // to a goal and pruned no move on any of the 164 levels; it stays as a cheap guard.
+    std::pair<size_t, size_t> computeDeadSquares(const std::vector<BoxBulk> &boxes);
+    inline bool isDeadSquare(char box_symbol, const Cell2D &cell) const {
+        const auto &dead = dead_squares_[box_symbol - FIRST_BOX];
+        return !dead.empty() && dead[cell.r * walls_.size_cols() + cell.c];
+    }
     inline const std::string getDomain() const { return domain_; }
     inline const std::string getName() const { return name_; }
     inline const Cell2D getSize() const { return walls_.size(); }
+    inline double getCorridorShare() const { return corridor_share_; }
+    inline const std::vector<CorridorSegment> &getCorridorSegments() const { return segments_; }
+    inline size_t getSegmentAt(const Cell2D &cell) const { return segment_of_[cell.r * walls_.size_cols() + cell.c]; }
+    inline const HierarchicalMap &getHierarchy() const { return hierarchy_; }
 
     std::string toString() const;
     Color getAgentColor(const char &agent_symbol) const;
@@ -48,9 +104,30 @@ class Level {
     std::vector<BoxBulk> boxes;
 
     Level(StaticLevel static_level, const std::vector<Agent> &agents, const std::vector<BoxBulk> &boxes);
+    Level(const Level &) = default;
+    Level(Level &&) = default;
     ~Level() = default;
 
     std::string toString() const;
 };
 
+// The contents of a level file, before any analysis. Boxes without an agent of their color are already walls.
+struct ParsedLevel {
+    std::string domain;
+    std::string name;
+    CharGrid walls;
+    std::map<char, Color> agent_colors;
+    std::map<char, Color> box_colors;
+    std::vector<Agent> agents;
+    std::vector<BoxBulk> boxes;
+};
+
+// Parses a whole level description in one pass over the text. Throws std::invalid_argument on malformed input.
+ParsedLevel parseLevelText(std::string_view text);
+// parseLevelText followed by the static analysis of the level
+Level parseLevel(std::string_view text);
+// The level text sent by the server, up to #end
+std::string readLevelText(std::istream &serverMessages);
+std::string readLevelFile(const std::string &path);
 Level loadLevel(std::istream &serverMessages);
+Level loadLevelFile(const std::string &path);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "level.hpp"
+
+// Binary snapshots of loaded levels: the parsed level and everything StaticLevel precomputes (dead squares,
+// corridor graph, hierarchy), so later runs on the same level skip parsing and analysis. Snapshots are named
+// after a hash of the level text and mapped into memory when read back.
+class LevelCache {
+   public:
+    static constexpr uint32_t MAGIC = 0x434c564c;  // "LVLC"
+    // Bump whenever the layout changes or StaticLevel computes any cached table differently, older files are then
+    // ignored and rewritten. Loading only checks that the tables index each other within bounds, stale contents
+    // that are in range are restored as they are.
+    static constexpr uint32_t VERSION = 1;
+
+   private:
+    struct Writer;
+    struct Reader;
+
+    std::string directory_;
+
+    static void writeStaticLevel(Writer &out, const StaticLevel &level);
+    static void writeHierarchy(Writer &out, const HierarchicalMap &hierarchy);
+    // nullptr if the snapshot is truncated or inconsistent
+    static StaticLevel *readStaticLevel(Reader &in);
+    static void readHierarchy(Reader &in, HierarchicalMap &hierarchy);
+    // False if a table of the restored level has the wrong size for the grid or an index past the table it points into
+    static bool isConsistent(const StaticLevel &level);
+
+   public:
+    explicit LevelCache(std::string directory);
+
+    // FNV-1a of the level text
+    static uint64_t hashText(std::string_view text);
+    std::string getPath(uint64_t hash) const;
+
+    // The level stored for this text, nullptr if there is none or it is from another version. The caller owns it.
+    Level *load(std::string_view text) const;
+    // Writes the snapshot of `level`, parsed from `text`. False if the file cannot be written.
+    bool store(std::string_view text, const Level &level) const;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "action.hpp"
+#include "level.hpp"
+#include "low_level_state.hpp"
+#include "prioritized_planner.hpp"
+
+enum class NeighborhoodType { Random, AgentBased, MapBased };
+
+struct ImprovementPoint {
+    double seconds;  // Since the start of improve()
+    size_t iteration;
+    size_t cost;
+};
+
+// Large Neighborhood Search post-optimizer (MAPF-LNS). Repeatedly destroys the plans of a few groups
+// and repairs them with prioritized planning against the plans of all other groups, keeping any
+// repair with a lower utils::CBS_cost. Neighborhood types are chosen by adaptive roulette weights.
+class LargeNeighborhoodSearch {
+   public:
+    // improve() gives up after this many iterations in a row without a cheaper solution
+    static constexpr size_t MAX_ITERATIONS_WITHOUT_IMPROVEMENT = 500;
+
+   private:
+    static constexpr size_t NEIGHBORHOOD_TYPES_COUNT = 3;
+
+    const std::vector<LowLevelState *> &group_states_;
+    PrioritizedPlanner planner_;
+    size_t rows_;
+    size_t cols_;
+    size_t neighborhood_size_;
+    std::chrono::steady_clock::time_point deadline_;
+
+    std::array<double, NEIGHBORHOOD_TYPES_COUNT> weights_;
+    std::vector<size_t> tabu_;  // Groups recently used as the seed of an agent-based neighborhood
+    std::vector<ImprovementPoint> improvement_curve_;
+    size_t iterations_count_;
+
+    // Per group, the cells it occupies at any point of its plan
+    std::vector<std::vector<bool>> getVisitedCells(const std::vector<std::vector<std::vector<const Action *>>> &solutions) const;
+
+    NeighborhoodType selectNeighborhoodType();
+    std::vector<size_t> randomNeighborhood();
+    std::vector<size_t> agentBasedNeighborhood(const std::vector<std::vector<std::vector<const Action *>>> &solutions);
+    std::vector<size_t> mapBasedNeighborhood(const std::vector<std::vector<std::vector<const Action *>>> &solutions);
+
+   public:
+    LargeNeighborhoodSearch() = delete;
+    LargeNeighborhoodSearch(const Level &level, const std::vector<LowLevelState *> &group_states, size_t neighborhood_size,
+                            unsigned int seed = 0);
+    LargeNeighborhoodSearch(const LargeNeighborhoodSearch &) = delete;
+    LargeNeighborhoodSearch &operator=(const LargeNeighborhoodSearch &) = delete;
+    ~LargeNeighborhoodSearch() = default;
+
+    void setDeadline(const std::chrono::steady_clock::time_point &deadline);
+    void setCancellationToken(const CancellationToken *cancellation_token) { planner_.setCancellationToken(cancellation_token); }
+
+    // Improves a valid solution until the deadline or until MAX_ITERATIONS_WITHOUT_IMPROVEMENT iterations in a row
+    // fail to, returns the best solution found
+    std::vector<std::vector<std::vector<const Action *>>> improve(std::vector<std::vector<std::vector<const Action *>>> solutions);
+
+    const std::vector<ImprovementPoint> &getImprovementCurve() const { return improvement_curve_; }
+    size_t getIterationsCount() const { return iterations_count_; }
+};
+
+const char *neighborhoodTypeToString(NeighborhoodType type);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <vector>
 
@@ -7,7 +9,9 @@
 #include "agent.hpp"
 #include "box_bulk.hpp"
 #include "constraint.hpp"
+#include "feature_flags.hpp"
 #include "level.hpp"
+#include "utils.hpp"
 
 class LowLevelState {
    private:
@@ -18,7 +22,7 @@ class LowLevelState {
    public:
     LowLevelState() = delete;
     LowLevelState(const StaticLevel &static_level, const std::vector<Agent> &agents, const std::vector<BoxBulk> &boxes)
-        : g_(0), static_level_(static_level), agents(agents), box_bulks(boxes), parent(nullptr) {
+        : g_(0), static_level_(static_level), agents(agents), box_bulks(boxes), parent(nullptr), actions(), walk() {
         this->agents.shrink_to_fit();
         box_bulks.shrink_to_fit();
     }
@@ -29,7 +33,8 @@ class LowLevelState {
           agents(other.agents),
           box_bulks(other.box_bulks),
           parent(other.parent),
-          actions(other.actions) {}
+          actions(other.actions),
+          walk(other.walk) {}
 
     LowLevelState *clone() const { return new LowLevelState(*this); }
 
@@ -37,6 +42,10 @@ class LowLevelState {
     std::vector<BoxBulk> box_bulks;
     const LowLevelState *parent;
     std::vector<const Action *> actions;
+    std::vector<const Action *> walk;  // Moves of a lone agent done before `actions`, set by macro successors
+
+    // Box moves rejected as deadlocks, summed over all searches
+    static inline std::atomic<size_t> dead_square_prunes{0};
 
     inline size_t getG() const { return g_; }
 
@@ -56,6 +65,19 @@ class LowLevelState {
         return 0;  // No box
     }
 
+    // Cells taken by the group's agents and boxes
+    std::vector<Cell2D> getOccupiedCells() const {
+        std::vector<Cell2D> cells;
+        cells.reserve(agents.size() + box_bulks.size());
+        for (const auto &agent : agents) {
+            cells.push_back(agent.getPosition());
+        }
+        for (const auto &bulk : box_bulks) {
+            cells.insert(cells.end(), bulk.getPositions().begin(), bulk.getPositions().end());
+        }
+        return cells;
+    }
+
     bool moveBox(const Cell2D &from, const Cell2D &to) {
         for (auto &bulk : box_bulks) {
             for (size_t i = 0; i < bulk.size(); i++) {
@@ -75,6 +97,9 @@ class LowLevelState {
 
         while (current->parent != nullptr) {
             plan.push_back(current->actions);
+            for (auto it = current->walk.rbegin(); it != current->walk.rend(); ++it) {
+                plan.push_back({*it});
+            }
             current = current->parent;
         }
         std::reverse(plan.begin(), plan.end());
@@ -87,7 +112,7 @@ class LowLevelState {
         expanded_states.reserve(actions_permutations.size() * agents.size());
 
         for (const auto &actions_permutation : actions_permutations) {
-            if (!isApplicable(actions_permutation)) {
+            if (!isApplicable(actions_permutation) || isConflicting(actions_permutation)) {
                 continue;
             }
             expanded_states.push_back(new LowLevelState(this, actions_permutation));
@@ -95,6 +120,128 @@ class LowLevelState {
         return expanded_states;
     }
 
+    // Cells the lone agent can walk to without moving anything, in BFS order from its position.
+    // `reached_by` gets the last move of a shortest walk to each of them.
+    std::vector<Cell2D> getReachableCells(std::vector<const Action *> &reached_by) const {
+        const size_t cols = static_level_.getSize().c;
+        auto index = [cols](const Cell2D &cell) { return cell.r * cols + cell.c; };
+        std::vector<bool> visited(static_level_.getSize().r * cols, false);
+        for (const auto &cell : getOccupiedCells()) {
+            visited[index(cell)] = true;
+        }
+        reached_by.assign(visited.size(), nullptr);
+        std::vector<Cell2D> reached = {agents[0].getPosition()};
+        for (size_t i = 0; i < reached.size(); i++) {
+            for (const Action *move : {&Action::MoveN, &Action::MoveS, &Action::MoveE, &Action::MoveW}) {
+                const Cell2D next = reached[i] + move->agent_delta;
+                if (!visited[index(next)] && static_level_.isCellFree(next)) {
+                    visited[index(next)] = true;
+                    reached_by[index(next)] = move;
+                    reached.push_back(next);
+                }
+            }
+        }
+        return reached;
+    }
+
+    // Identifies the state up to walking: the smallest cell the lone agent can walk to, then every box
+    std::vector<Cell2D> getMacroKey() const {
+        std::vector<const Action *> reached_by;
+        const auto reached = getReachableCells(reached_by);
+        std::vector<Cell2D> key = {*std::min_element(reached.begin(), reached.end())};
+        for (const auto &bulk : box_bulks) {
+            key.insert(key.end(), bulk.getPositions().begin(), bulk.getPositions().end());
+        }
+        return key;
+    }
+
+    // Successors of a single-agent state as macro actions: the agent walks the shortest free path to a cell
+    // next to a box, then pushes or pulls it. Walking onto one of its own goals is a macro as well.
+    std::vector<LowLevelState *> getMacroExpandedStates() const {
+        assert(agents.size() == 1);
+        const size_t cols = static_level_.getSize().c;
+        auto index = [cols](const Cell2D &cell) { return cell.r * cols + cell.c; };
+        const Cell2D start = agents[0].getPosition();
+        std::vector<const Action *> reached_by;
+        const auto reached = getReachableCells(reached_by);
+        auto walkTo = [&](Cell2D cell) {
+            std::vector<const Action *> moves;
+            while (cell != start) {
+                moves.push_back(reached_by[index(cell)]);
+                cell -= moves.back()->agent_delta;
+            }
+            std::reverse(moves.begin(), moves.end());
+            return moves;
+        };
+
+        std::vector<LowLevelState *> expanded_states;
+        LowLevelState walked(*this);
+        for (const auto &cell : reached) {
+            walked.agents[0].position() = cell;
+            std::vector<const Action *> moves;
+            for (const auto &joint_action : Action::getAllPermutations(1)) {
+                const ActionType type = joint_action[0]->type;
+                if ((type != ActionType::Push && type != ActionType::Pull) || !walked.isApplicable(joint_action)) {
+                    continue;
+                }
+                if (moves.empty() && cell != start) {
+                    moves = walkTo(cell);
+                }
+                expanded_states.push_back(new LowLevelState(this, moves, joint_action));
+            }
+        }
+        for (const auto &goal : agents[0].getGoalPositions()) {
+            if (goal != start && reached_by[index(goal)]) {
+                auto moves = walkTo(goal);
+                const Action *last_move = moves.back();
+                moves.pop_back();
+                expanded_states.push_back(new LowLevelState(this, moves, {last_move}));
+            }
+        }
+        return expanded_states;
+    }
+
+    // Successors that take the lone agent through a whole corridor segment it stands at the entrance of,
+    // as long as no box or agent is in the way, ending on the cell just past the far end
+    std::vector<LowLevelState *> getCorridorTraversals() const {
+        assert(agents.size() == 1);
+        const Cell2D start = agents[0].getPosition();
+        std::vector<LowLevelState *> traversals;
+        for (const Action *entry : {&Action::MoveN, &Action::MoveS, &Action::MoveE, &Action::MoveW}) {
+            const Cell2D first = start + entry->agent_delta;
+            const size_t segment_idx = static_level_.getSegmentAt(first);
+            if (!static_level_.isCellFree(first) || segment_idx == SIZE_MAX || static_level_.getSegmentAt(start) == segment_idx) {
+                continue;
+            }
+            const CorridorSegment &segment = static_level_.getCorridorSegments()[segment_idx];
+            const bool forward = segment.cells.front() == first;
+            const Cell2D exit = segment.ends[forward ? 1 : 0];
+            if (exit == start || !isCellFree(exit)) {
+                continue;
+            }
+            std::vector<const Action *> moves = {entry};
+            Cell2D current = first;
+            bool blocked = !isCellFree(first);
+            for (size_t i = 1; i <= segment.cells.size() && !blocked; i++) {
+                const Cell2D next = i < segment.cells.size() ? segment.cells[forward ? i : segment.cells.size() - 1 - i] : exit;
+                blocked = !isCellFree(next);
+                for (const Action *move : {&Action::MoveN, &Action::MoveS, &Action::MoveE, &Action::MoveW}) {
+                    if (current + move->agent_delta == next) {
+                        moves.push_back(move);
+                    }
+                }
+                current = next;
+            }
+            if (blocked) {
+                continue;
+            }
+            const Action *last_move = moves.back();
+            moves.pop_back();
+            traversals.push_back(new LowLevelState(this, moves, {last_move}));
+        }
+        return traversals;
+    }
+
     size_t getHash() const {
         if (hash_ != 0) {
             return hash_;
@@ -175,6 +322,9 @@ class LowLevelState {
                             break;
                         }
                     }
+#ifdef USE_DEADLOCK_PRUNING
+                    action_applicable = action_applicable && !isDeadlocked(box_id, box_destination);
+#endif
                     break;
                 }
 
@@ -207,6 +357,9 @@ class LowLevelState {
                             break;
                         }
                     }
+#ifdef USE_DEADLOCK_PRUNING
+                    action_applicable = action_applicable && !isDeadlocked(box_id, agent_pos);
+#endif
                     break;
                 }
 
@@ -221,6 +374,36 @@ class LowLevelState {
         return true;  // All actions are applicable
     }
 
+    // Individually applicable actions may still clash: two objects ending in one cell or two agents moving one box
+    bool isConflicting(const std::vector<const Action *> &joint_actions) const {
+        std::vector<Cell2D> destinations;
+        std::vector<Cell2D> moved_boxes;
+        destinations.reserve(joint_actions.size() * 2);
+        moved_boxes.reserve(joint_actions.size());
+
+        for (size_t i = 0; i < joint_actions.size(); i++) {
+            const Action *action = joint_actions[i];
+            const Cell2D agent_pos = agents[i].getPosition();
+            destinations.push_back(agent_pos + action->agent_delta);
+            if (action->type == ActionType::Push) {
+                const Cell2D box_pos = agent_pos + action->agent_delta;
+                moved_boxes.push_back(box_pos);
+                destinations.push_back(box_pos + action->box_delta);
+            } else if (action->type == ActionType::Pull) {
+                moved_boxes.push_back(agent_pos - action->box_delta);
+                destinations.push_back(agent_pos);
+            }
+        }
+
+        for (auto *cells : {&destinations, &moved_boxes}) {
+            std::sort(cells->begin(), cells->end());
+            if (std::adjacent_find(cells->begin(), cells->end()) != cells->end()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     void applyActions(const std::vector<const Action *> &joint_actions) {
         assert(joint_actions.size() == agents.size());
 
@@ -265,10 +448,35 @@ class LowLevelState {
           agents(parent->agents),
           box_bulks(parent->box_bulks),
           parent(parent),
-          actions(joint_actions) {
+          actions(joint_actions),
+          walk() {
         applyActions(joint_actions);
     }
 
+    // Macro successor: the lone agent makes the `walk` moves first, one timestep each
+    LowLevelState(const LowLevelState *parent, const std::vector<const Action *> &walk, const std::vector<const Action *> &joint_actions)
+        : g_(parent->g_ + walk.size() + 1),
+          static_level_(parent->static_level_),
+          agents(parent->agents),
+          box_bulks(parent->box_bulks),
+          parent(parent),
+          actions(joint_actions),
+          walk(walk) {
+        for (const Action *move : walk) {
+            agents[0].position() += move->agent_delta;
+        }
+        applyActions(joint_actions);
+    }
+
+    // Moving the box onto `to` leaves it where it can never reach a goal
+    bool isDeadlocked(char box_symbol, const Cell2D &to) const {
+        if (static_level_.isDeadSquare(box_symbol, to)) {
+            dead_square_prunes++;
+            return true;
+        }
+        return false;
+    }
+
     bool isCellFree(const Cell2D &cell) const {
         if (!static_level_.isCellFree(cell)) return false;
 
@@ -306,4 +514,28 @@ struct LowLevelStatePtrEqual {
         }
         return *lhs_ptr == *rhs_ptr;
     }
-};
\ No newline at end of file
+};
+
+// Time-aware variants used when the same configuration at different timesteps must be told apart
+struct LowLevelStateTimedPtrHash {
+    std::size_t operator()(const LowLevelState *state_ptr) const {
+        if (!state_ptr) {
+            return 0;
+        }
+        std::size_t hash = state_ptr->getHash();
+        utils::hashCombine(hash, state_ptr->getG());
+        return hash;
+    }
+};
+
+struct LowLevelStateTimedPtrEqual {
+    bool operator()(const LowLevelState *lhs_ptr, const LowLevelState *rhs_ptr) const {
+        if (lhs_ptr == rhs_ptr) {
+            return true;
+        }
+        if (!lhs_ptr || !rhs_ptr) {
+            return false;
+        }
+        return lhs_ptr->getG() == rhs_ptr->getG() && *lhs_ptr == *rhs_ptr;
+    }
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "action.hpp"
+#include "level.hpp"
+
+class CBS;
+
+// Sends plans to the server and acts on its answers: streams them in parts while the search goes on, or repairs a
+// plan after rejected actions. Talks to the server through `out` and `in`, one executor per level.
+class OnlineExecutor {
+   public:
+    // Streaming mode: time to look for a shorter remainder while the committed prefix executes
+    static constexpr std::chrono::seconds STREAM_ROUND_TIME_LIMIT{2};
+    // Streaming mode: remainders this short are committed whole
+    static constexpr size_t STREAM_MIN_REMAINDER = 16;
+    // Replanning after the server rejected an action: time for each repair search, still capped by the search deadline
+    static constexpr std::chrono::seconds REPAIR_TIME_LIMIT{5};
+    static constexpr size_t MAX_REPAIRS = 8;
+
+   private:
+    FILE *out_;
+    std::istream &in_;
+    std::vector<std::vector<const Action *>> executed_;
+    size_t rounds_;
+    size_t repairs_;
+
+   public:
+    OnlineExecutor(FILE *out, std::istream &in) : out_(out), in_(in), executed_(), rounds_(0), repairs_(0) {}
+    OnlineExecutor(const OnlineExecutor &) = delete;
+    OnlineExecutor &operator=(const OnlineExecutor &) = delete;
+
+    // Without a window: commits the first half of the current plan and, while it executes, searches again. The old
+    // remainder stays the fallback, so every round keeps a complete plan.
+    // With a window: windowed CBS resolves only the conflicts of the next `window` steps, those are committed and
+    // the next cycle plans from the positions they lead to.
+    void stream(const Level &level, std::chrono::steady_clock::time_point deadline, size_t window = 0);
+
+    // Sends the offline plan `cbs` found for `level` and monitors the server's answers. When an action is rejected,
+    // the level is rebuilt from the actions the server did execute and a repair search, reusing the distance tables
+    // of the previous one, plans from there. Its plan is sent in turn, up to MAX_REPAIRS times.
+    void execute(const Level &level, const CBS &cbs, std::vector<std::vector<const Action *>> plan,
+                 std::chrono::steady_clock::time_point deadline);
+
+    // Every joint action the server answered, as it applied them
+    const std::vector<std::vector<const Action *>> &getExecuted() const { return executed_; }
+    size_t getRoundsCount() const { return rounds_; }
+    size_t getRepairsCount() const { return repairs_; }
+};
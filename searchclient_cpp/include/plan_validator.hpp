@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "action.hpp"
+#include "level.hpp"
+
+// Outcome of a simulated plan, with the metrics the benchmarks compare
+struct PlanReport {
+    bool valid;           // Every joint action applicable and free of conflicts
+    bool solved;          // Valid and every goal reached after the last joint action
+    size_t makespan;      // Joint actions, what the server reports as actions used
+    size_t sum_of_costs;  // Per agent, the step of its last action other than NoOp (SIC)
+    size_t fuel;          // Actions other than NoOp
+    size_t failed_step;   // First invalid joint action, SIZE_MAX if none
+    std::string error;    // Why the plan is invalid or unsolved, empty if solved
+
+    PlanReport() : valid(true), solved(false), makespan(0), sum_of_costs(0), fuel(0), failed_step(SIZE_MAX), error() {}
+};
+
+// Simulates plans with the hospital domain rules of the server, so plans can be checked without server.jar.
+// Preconditions are checked on the state before each joint action: Move needs a free destination, Push a box of the
+// agent's color next to it and a free cell behind the box, Pull a box of the agent's color behind it and a free
+// destination. Two actions of one joint action conflict if they move into the same cell or move the same box.
+class PlanValidator {
+   private:
+    const Level &level_;
+    size_t rows_, cols_;
+    std::vector<char> walls_;  // Row-major, non-zero on walls
+    std::vector<Color> agent_colors_;
+    Color box_colors_[LAST_BOX - FIRST_BOX + 1];
+
+   public:
+    explicit PlanValidator(const Level &level);
+    PlanValidator(const PlanValidator &) = delete;
+    PlanValidator &operator=(const PlanValidator &) = delete;
+
+    // Simulates `plan` from the initial state of the level, stopping at the first invalid joint action
+    PlanReport validate(const std::vector<std::vector<const Action *>> &plan) const;
+
+    // Reads a plan as sent to the server, one joint action per line with actions separated by '|'. The "@..."
+    // bubble text is ignored, as are blank lines and '#' comments. Throws std::invalid_argument on malformed input.
+    static std::vector<std::vector<const Action *>> parsePlan(std::string_view text, size_t agents_count);
+};
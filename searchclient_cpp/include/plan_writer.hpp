@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "action.hpp"
+
+// Streams a plan to the server without waiting a round-trip per joint action. A writer thread sends batches
+// through one buffer while at most `window` actions are unanswered, and a reader thread checks each of
+// the server's responses in order. Actions can be appended while earlier ones are still being sent.
+class PlanWriter {
+   public:
+    static constexpr size_t DEFAULT_WINDOW = 256;
+
+   private:
+    FILE *out_;
+    std::istream &in_;
+    size_t window_;
+    std::thread writer_;
+    std::thread reader_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<std::vector<const Action *>> pending_;  // Appended, not yet sent
+    std::vector<std::vector<const Action *>> sent_actions_;
+    std::vector<std::vector<const Action *>> executed_;  // Answered actions as the server applied them
+    size_t sent_;
+    size_t acknowledged_;
+    bool appending_;
+    bool done_sending_;
+    bool failed_;
+    size_t failed_step_;  // First joint action the server rejected, SIZE_MAX if none
+    std::string failed_response_;
+
+    void writeActions();
+    void readResponses();
+
+   public:
+    PlanWriter(FILE *out, std::istream &in, size_t window = DEFAULT_WINDOW);
+    PlanWriter(const PlanWriter &) = delete;
+    PlanWriter &operator=(const PlanWriter &) = delete;
+    ~PlanWriter();
+
+    // Starts the writer and reader threads
+    void start();
+    // Queues joint actions after the ones appended before, ignored once the server rejected one
+    void append(const std::vector<std::vector<const Action *>> &joint_actions);
+    // Waits until everything appended is sent and answered. False if the server rejected an action or
+    // stopped answering; nothing after the first rejected action is sent once the reader has seen it.
+    bool finish();
+    // start, append and finish in one go
+    bool send(const std::vector<std::vector<const Action *>> &plan);
+
+    bool hasFailed();
+    // Joint actions appended but not yet answered by the server
+    size_t getUnfinished();
+    size_t getFailedStep() const { return failed_step_; }
+    // Every answered joint action with the actions the server rejected replaced by NoOps, valid after finish()
+    const std::vector<std::vector<const Action *>> &getExecuted() const { return executed_; }
+    const std::string &getFailedResponse() const { return failed_response_; }
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "action.hpp"
+#include "cancellation_token.hpp"
+#include "cbs.hpp"
+#include "level.hpp"
+
+enum class PortfolioMode {
+    FirstValid,      // Stop every strategy as soon as one returns a valid plan
+    BestAtDeadline,  // Let all strategies finish (or hit the deadline) and keep the lowest utils::CBS_cost
+};
+
+// Runs a strategy and returns its joint plan, empty on failure. It must poll the token and respect the deadline.
+// Joint plans do not depend on how a strategy grouped the agents, the portfolio splits them into its own groups.
+using PortfolioRunner = std::function<std::vector<std::vector<const Action *>>(const Level &, const CancellationToken &,
+                                                                                  std::chrono::steady_clock::time_point)>;
+
+struct PortfolioResult {
+    std::string name;
+    std::vector<std::vector<std::vector<const Action *>>> solutions;
+    size_t cost;  // SIZE_MAX if the strategy failed or returned an invalid plan
+    double seconds;
+    bool finished;
+};
+
+// Races several solver configurations on separate threads. They share one cancellation token and the
+// process wide memory budget (Memory::maxUsage is checked against the whole process's usage).
+class PortfolioSolver {
+   private:
+    const Level &level_;
+    PortfolioMode mode_;
+    std::chrono::steady_clock::time_point deadline_;
+    std::vector<std::pair<std::string, PortfolioRunner>> strategies_;
+    size_t threads_count_;  // 0 runs every strategy on its own thread
+    CBS validator_;  // Checks the plans of all strategies and splits them into its groups
+
+    CancellationToken cancellation_token_;
+    std::mutex results_mutex_;
+    std::condition_variable results_changed_;
+    std::vector<PortfolioResult> results_;
+    size_t finished_count_;
+    size_t winner_idx_;
+
+    void run(size_t strategy_idx);
+
+   public:
+    PortfolioSolver() = delete;
+    PortfolioSolver(const Level &level, PortfolioMode mode, std::chrono::steady_clock::time_point deadline);
+    PortfolioSolver(const PortfolioSolver &) = delete;
+    PortfolioSolver &operator=(const PortfolioSolver &) = delete;
+    ~PortfolioSolver() = default;
+
+    void addStrategy(const std::string &name, PortfolioRunner runner);
+    // Runs at most `threads_count` strategies at once, in the order they were added
+    void setThreadsCount(size_t threads_count) { threads_count_ = threads_count; }
+    // CBS with A* and with weighted A* low level searches, and prioritized planning
+    void addDefaultStrategies();
+
+    // Returns the winner's per group plans, empty if no strategy found a valid plan
+    std::vector<std::vector<std::vector<const Action *>>> solve();
+
+    const std::vector<PortfolioResult> &getResults() const { return results_; }
+    // Nullptr if there is no winner
+    const PortfolioResult *getWinner() const { return winner_idx_ == SIZE_MAX ? nullptr : &results_[winner_idx_]; }
+};
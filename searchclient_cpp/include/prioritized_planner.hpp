@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "action.hpp"
+#include "cancellation_token.hpp"
+#include "graphsearch.hpp"
+#include "level.hpp"
+#include "low_level_state.hpp"
+#include "reservation_table.hpp"
+
+// Plans color groups one at a time, each against a reservation table holding the plans of the
+// groups planned before it. Incomplete, but finds a feasible plan much faster than CBS.
+class PrioritizedPlanner {
+   private:
+    const std::vector<LowLevelState *> &group_states_;
+    std::vector<Graphsearch *> group_searches_;
+    ReservationTable reservations_;
+    std::mt19937 random_generator_;
+    std::chrono::steady_clock::time_point deadline_;
+    const CancellationToken *cancellation_token_;
+    size_t generated_states_count_;
+    size_t attempts_count_;
+
+   public:
+    PrioritizedPlanner() = delete;
+    PrioritizedPlanner(const Level &level, const std::vector<LowLevelState *> &group_states, unsigned int seed = 0);
+    PrioritizedPlanner(const PrioritizedPlanner &) = delete;
+    PrioritizedPlanner &operator=(const PrioritizedPlanner &) = delete;
+    ~PrioritizedPlanner();
+
+    void setDeadline(const std::chrono::steady_clock::time_point &deadline);
+    void setCancellationToken(const CancellationToken *cancellation_token);
+    bool isCancelled() const { return cancellation_token_ && cancellation_token_->isCancelled(); }
+
+    // Replans the groups in `order` one by one while the plans of all other groups in `solutions` stay fixed.
+    // Groups waiting for their turn keep their initial cells blocked. On failure `solutions` is left partially replanned.
+    bool replan(const std::vector<size_t> &order, std::vector<std::vector<std::vector<const Action *>>> &solutions);
+
+    // Plans all groups in the given priority order, returns empty solutions on failure
+    std::vector<std::vector<std::vector<const Action *>>> solve(const std::vector<size_t> &order);
+
+    // Tries the natural order first, then random orders until one succeeds or the deadline passes
+    std::vector<std::vector<std::vector<const Action *>>> solveWithRestarts();
+
+    std::mt19937 &getRandomGenerator() { return random_generator_; }
+    size_t getGroupsCount() const { return group_states_.size(); }
+    size_t getGeneratedStatesCount() const { return generated_states_count_; }
+    size_t getAttemptsCount() const { return attempts_count_; }
+};
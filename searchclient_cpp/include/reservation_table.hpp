@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "action.hpp"
+#include "cell2d.hpp"
+#include "level.hpp"
+#include "low_level_state.hpp"
+
+// Space-time occupancy of already planned groups, stored as one bitset over the
+// StaticLevel cells per timestep. Cells stay reserved forever after the plan that
+// reserved them ends (the group keeps standing on its final cells).
+class ReservationTable {
+   private:
+    static constexpr size_t BITS_PER_WORD = 64;
+
+    size_t cols_;
+    size_t cells_count_;
+    size_t words_per_step_;
+    size_t horizon_;  // First timestep from which only permanent reservations remain
+
+    std::vector<uint64_t> steps_;          // steps_[t * words_per_step_ + word]
+    std::vector<uint64_t> blocked_;        // Cells reserved at every timestep
+    std::vector<size_t> permanent_from_;   // Per cell, timestep from which it stays reserved, SIZE_MAX if never
+    std::vector<size_t> last_reserved_at_;  // Per cell, last timestep with a timed reservation, SIZE_MAX if none
+
+    inline size_t index(const Cell2D &cell) const { return cell.r * cols_ + cell.c; }
+    inline bool testBit(const uint64_t *words, size_t idx) const { return (words[idx / BITS_PER_WORD] >> (idx % BITS_PER_WORD)) & 1; }
+    void ensureHorizon(size_t t);
+
+   public:
+    ReservationTable() = delete;
+    explicit ReservationTable(const StaticLevel &static_level);
+    ~ReservationTable() = default;
+
+    void clear();
+
+    void reserve(const Cell2D &cell, size_t t);
+    void reserveFrom(const Cell2D &cell, size_t t);
+    void block(const Cell2D &cell);
+    void unblock(const Cell2D &cell);
+
+    // Reserves every cell the group occupies while executing the plan, and its final cells forever after.
+    void reservePlan(const LowLevelState &initial_state, const std::vector<std::vector<const Action *>> &plan);
+
+    bool isReserved(const Cell2D &cell, size_t t) const;
+    // True if the cell is reserved at any timestep >= t.
+    bool isReservedFrom(const Cell2D &cell, size_t t) const;
+
+    inline size_t getHorizon() const { return horizon_; }
+};
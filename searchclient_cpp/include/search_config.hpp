@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "frontier.hpp"
+#include "heuristic.hpp"
+
+// Runtime search settings, so benchmark sweeps need no rebuild per configuration. They come from an optional
+// `key = value` file and `--key value` command line options, the command line winning. The compile-time feature
+// flags still decide which techniques are built in.
+struct SearchConfig {
+    static constexpr size_t DEFAULT_CONFLICT_WINDOW = 20;
+
+    std::string solver;               // High level: cbs, pp, portfolio, portfolio-best, stream or windowed
+    std::string frontier;             // Low level: bestfirst, bfs or dfs
+    std::string heuristic;            // Order of the best-first frontier: astar, wastar or greedy
+    size_t weight;                    // h inflation of wastar
+    size_t threads;                   // Portfolio strategies running at once, 0 runs all of them
+    uint32_t memory_mb;               // Memory::maxUsage
+    std::chrono::seconds time_limit;  // Search deadline, counted from when the level is loaded
+    size_t window;                    // Conflict window of the windowed solver
+    std::string level_cache;          // LevelCache directory, unused when empty
+    std::string stats;                // SearchStats JSON file, "-" for stderr, not collected when empty
+
+    // Read by every low level search of the process, main sets it before searching
+    static SearchConfig active;
+
+    SearchConfig();
+
+    // Throws std::invalid_argument on an unknown key or an invalid value
+    void set(const std::string &key, const std::string &value);
+    // `key = value` lines, '#' starts a comment
+    void loadFile(const std::string &path);
+    // `--config FILE` first, then the other `--key value` options in order. Positional arguments name a strategy,
+    // parts joined by '+' each setting the solver, frontier or heuristic ("cbs+wastar", "bfs"), optionally followed
+    // by the window of windowed or the weight of wastar.
+    void parseArgs(const std::vector<std::string> &args);
+
+    Heuristic *makeHeuristic() const;
+    // The low level frontier, ordered by `ordering` when best-first. Takes ownership of `ordering`.
+    Frontier *makeFrontier(Heuristic *ordering) const;
+
+    std::string toString() const;
+};
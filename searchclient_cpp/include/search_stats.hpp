@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "feature_flags.hpp"
+
+class LowLevelState;
+
+// Counters and timers of the whole run, exported as one JSON object at its end. Each thread counts into its own
+// copy, merged into the run totals when the thread ends, so the portfolio threads never contend. Nothing is
+// collected until enable() is called, a disabled run pays one branch per event, and without USE_SEARCH_STATS
+// every call compiles to nothing.
+namespace SearchStats {
+enum Counter {
+    CT_NODES_EXPANDED,
+    CT_NODES_GENERATED,
+    CT_DUPLICATES_PRUNED,  // CT nodes popped with a constraint set seen before
+    LOW_LEVEL_CALLS,
+    LOW_LEVEL_EXPANDED,
+    LOW_LEVEL_GENERATED,
+    LOW_LEVEL_DUPLICATES_PRUNED,  // Children already explored or in the frontier
+    COUNTERS_COUNT
+};
+enum Timer { HEURISTIC, CONFLICT_DETECTION, LOW_LEVEL_SEARCH, TIMERS_COUNT };
+enum Peak {
+    STATES_HELD,  // States one low level search keeps in its explored sets and frontier
+    PEAKS_COUNT
+};
+
+#ifdef USE_SEARCH_STATS
+extern bool enabled;
+
+void addToLocal(Counter counter, uint64_t count);
+void addTimeToLocal(Timer timer, std::chrono::steady_clock::duration time);
+void addReplanToLocal(const LowLevelState &group, std::chrono::steady_clock::duration time);
+void updateLocalPeak(Peak peak, uint64_t value);
+
+// Call before any search thread starts
+inline void enable() { enabled = true; }
+inline bool isEnabled() { return enabled; }
+inline void add(Counter counter, uint64_t count = 1) {
+    if (enabled) {
+        addToLocal(counter, count);
+    }
+}
+inline void updatePeak(Peak peak, uint64_t value) {
+    if (enabled) {
+        updateLocalPeak(peak, value);
+    }
+}
+// Start of a timed section, the epoch when disabled so no clock is read
+inline std::chrono::steady_clock::time_point start() {
+    return enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+}
+inline void addTime(Timer timer, std::chrono::steady_clock::time_point started) {
+    if (enabled && started != std::chrono::steady_clock::time_point()) {
+        addTimeToLocal(timer, std::chrono::steady_clock::now() - started);
+    }
+}
+// One low level replan of a CBS child node, timed per group. Groups are named by their agents.
+inline void addReplan(const LowLevelState &group, std::chrono::steady_clock::time_point started) {
+    if (enabled && started != std::chrono::steady_clock::time_point()) {
+        addReplanToLocal(group, std::chrono::steady_clock::now() - started);
+    }
+}
+
+// The totals of the threads that ended and of the calling thread
+std::string toJson();
+// "-" writes to stderr, false if the file cannot be written
+bool exportJson(const std::string &path);
+// Clears the totals and the calling thread's counts, for tests
+void reset();
+#else
+inline void enable() {}
+inline bool isEnabled() { return false; }
+inline void add(Counter, uint64_t = 1) {}
+inline void updatePeak(Peak, uint64_t) {}
+inline std::chrono::steady_clock::time_point start() { return std::chrono::steady_clock::time_point(); }
+inline void addTime(Timer, std::chrono::steady_clock::time_point) {}
+inline void addReplan(const LowLevelState &, std::chrono::steady_clock::time_point) {}
+inline std::string toJson() { return "{}"; }
+inline bool exportJson(const std::string &) { return true; }
+inline void reset() {}
+#endif
+
+// Times the enclosing scope
+class ScopedTimer {
+   private:
+    Timer timer_;
+    std::chrono::steady_clock::time_point started_;
+
+   public:
+    explicit ScopedTimer(Timer timer) : timer_(timer), started_(start()) {}
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+    ~ScopedTimer() { addTime(timer_, started_); }
+};
+}  // namespace SearchStats
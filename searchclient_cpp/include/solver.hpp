@@ -0,0 +1,24 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "action.hpp"
+#include "cbs.hpp"
+#include "level.hpp"
+
+// What a solveLevel call did, for the benchmark metrics
+struct SolveStats {
+    size_t expanded;  // Low level states expanded by CBS
+    size_t generated;
+    std::string portfolio_winner;  // Empty unless a portfolio strategy found the plan
+
+    SolveStats() : expanded(0), generated(0), portfolio_winner() {}
+};
+
+// Plans the whole level offline with `strategy`: cbs (the default), pp, portfolio or portfolio-best. The first
+// solution is improved by LNS and compressed when those features are on. `cbs` must be built on `level`, it
+// also merges the per group plans. Empty if the level is not solved by the deadline.
+std::vector<std::vector<const Action *>> solveLevel(const Level &level, CBS &cbs, const std::string &strategy,
+                                                    std::chrono::steady_clock::time_point deadline, SolveStats *stats = nullptr);
@@ -18,6 +18,10 @@ size_t makespan(const std::vector<std::vector<std::vector<const Action *>>> &sol
 size_t fuel_used(const std::vector<std::vector<std::vector<const Action *>>> &solutions);
 size_t CBS_cost(const std::vector<std::vector<std::vector<const Action *>>> &solutions);
 
+// Minimum cost perfect matching of the rows into the columns (rows <= cols), SIZE_MAX marks forbidden pairs.
+// Returns the column of every row.
+std::vector<size_t> minCostAssignment(const std::vector<std::vector<size_t>> &costs);
+
 template <typename T>
 std::vector<std::vector<T>> transpose(const std::vector<std::vector<T>> &vector2d) {
     std::vector<std::vector<T>> result(vector2d[0].size(), std::vector<T>(vector2d.size()));
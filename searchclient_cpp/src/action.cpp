@@ -6,6 +6,7 @@ Action::Action(const std::string &name, const ActionType type, const Cell2D agen
     : name(name), type(type), agent_delta(agent_delta), box_delta(box_delta) {}
 
 std::map<size_t, std::vector<std::vector<const Action *>>> Action::cached_permutations_ = {};
+std::mutex Action::cached_permutations_mutex_;
 
 const Action Action::NoOp("NoOp", ActionType::NoOp, {0, 0}, {0, 0});
 
@@ -51,6 +52,8 @@ const std::array<const Action *, 29> &Action::allValues() {
 }
 
 const std::vector<std::vector<const Action *>> &Action::getAllPermutations(size_t n) {
+    // Map references stay valid after later insertions, so holding the lock while looking up is enough
+    std::lock_guard<std::mutex> lock(cached_permutations_mutex_);
     auto it = cached_permutations_.find(n);
     if (it != cached_permutations_.end()) {
         return it->second;  // Return const reference to cached result
@@ -0,0 +1,88 @@
+#include "assignment.hpp"
+
+#include <algorithm>
+#include <limits>
+
+static constexpr long long INF = std::numeric_limits<long long>::max() / 4;
+
+Assignment::Assignment(size_t size)
+    : size_(size),
+      costs_(size * size, 0),
+      row_potential_(size + 1, 0),
+      col_potential_(size + 1, 0),
+      col_match_(size + 1, 0),
+      row_match_(size + 1, 0) {}
+
+void Assignment::setRow(size_t row, const std::vector<long long> &costs) {
+    row++;
+    std::copy(costs.begin(), costs.end(), costs_.begin() + (row - 1) * size_);
+    if (row_match_[row] != 0) {
+        col_match_[row_match_[row]] = 0;
+        row_match_[row] = 0;
+    }
+    // Tightest potential keeping every reduced cost of the row non-negative
+    long long potential = INF;
+    for (size_t col = 1; col <= size_; col++) {
+        potential = std::min(potential, cost(row, col) - col_potential_[col]);
+    }
+    row_potential_[row] = potential;
+}
+
+void Assignment::solve() {
+    for (size_t row = 1; row <= size_; row++) {
+        if (row_match_[row] == 0) {
+            augment(row);
+        }
+    }
+}
+
+void Assignment::augment(size_t row) {
+    col_match_[0] = row;
+    size_t col0 = 0;
+    std::vector<long long> min_slack(size_ + 1, INF);
+    std::vector<size_t> way(size_ + 1, 0);
+    std::vector<bool> used(size_ + 1, false);
+    do {
+        used[col0] = true;
+        const size_t row0 = col_match_[col0];
+        long long delta = INF;
+        size_t col1 = 0;
+        for (size_t col = 1; col <= size_; col++) {
+            if (used[col]) {
+                continue;
+            }
+            const long long slack = cost(row0, col) - row_potential_[row0] - col_potential_[col];
+            if (slack < min_slack[col]) {
+                min_slack[col] = slack;
+                way[col] = col0;
+            }
+            if (min_slack[col] < delta) {
+                delta = min_slack[col];
+                col1 = col;
+            }
+        }
+        for (size_t col = 0; col <= size_; col++) {
+            if (used[col]) {
+                row_potential_[col_match_[col]] += delta;
+                col_potential_[col] -= delta;
+            } else {
+                min_slack[col] -= delta;
+            }
+        }
+        col0 = col1;
+    } while (col_match_[col0] != 0);
+    do {
+        const size_t col1 = way[col0];
+        col_match_[col0] = col_match_[col1];
+        row_match_[col_match_[col0]] = col0;
+        col0 = col1;
+    } while (col0 != 0);
+}
+
+long long Assignment::getCost() const {
+    long long total = 0;
+    for (size_t row = 1; row <= size_; row++) {
+        total += cost(row, row_match_[row]);
+    }
+    return total;
+}
@@ -0,0 +1,255 @@
+#include "batch_runner.hpp"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+#include "cbs.hpp"
+#include "level.hpp"
+#include "level_cache.hpp"
+#include "memory.hpp"
+#include "plan_validator.hpp"
+#include "solver.hpp"
+
+BatchOptions::BatchOptions()
+    : levels_dir(),
+      strategy("cbs"),
+      workers(std::max(1u, std::thread::hardware_concurrency())),
+      timeout(10),
+      memory_limit_mb(Memory::maxUsage),
+      cache_dir() {}
+
+BatchRunner::BatchRunner(BatchOptions options) : options_(std::move(options)), cases_() {}
+
+// Copies into a fixed size field of the metrics, cut to fit
+static void copyField(char *field, size_t size, const std::string &value) {
+    strncpy(field, value.c_str(), size - 1);
+    field[size - 1] = '\0';
+}
+
+void BatchRunner::solveCase(const std::string &path, int pipe_fd) const {
+    // The search reports on both streams, only the metrics leave the worker
+    const int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDOUT_FILENO);
+    dup2(null_fd, STDERR_FILENO);
+    close(null_fd);
+    Memory::maxUsage = options_.memory_limit_mb;
+
+    CaseMetrics metrics;
+    memset(&metrics, 0, sizeof(metrics));
+    const auto start = std::chrono::steady_clock::now();
+    try {
+        const std::string text = readLevelFile(path);
+        Level *level = nullptr;
+        if (!options_.cache_dir.empty()) {
+            const LevelCache cache(options_.cache_dir);
+            level = cache.load(text);
+            if (!level) {
+                level = new Level(parseLevel(text));
+                cache.store(text, *level);
+            }
+        } else {
+            level = new Level(parseLevel(text));
+        }
+
+        CBS cbs(*level, start + options_.timeout);
+        SolveStats stats;
+        const auto plan = solveLevel(*level, cbs, options_.strategy, start + options_.timeout, &stats);
+        metrics.expanded = stats.expanded;
+        metrics.generated = stats.generated;
+        copyField(metrics.portfolio_winner, sizeof(metrics.portfolio_winner), stats.portfolio_winner);
+        if (plan.empty()) {
+            copyField(metrics.error, sizeof(metrics.error), "Unable to solve level");
+        } else {
+            // A plan that fails validation counts as no solution, its length is not reported
+            const PlanReport report = PlanValidator(*level).validate(plan);
+            if (report.solved) {
+                metrics.solution_length = plan.size();
+                metrics.sum_of_costs = report.sum_of_costs;
+                metrics.fuel = report.fuel;
+            } else {
+                copyField(metrics.error, sizeof(metrics.error), "Invalid plan: " + report.error);
+            }
+        }
+        delete level;
+    } catch (const std::exception &e) {
+        copyField(metrics.error, sizeof(metrics.error), e.what());
+    }
+    metrics.time_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        metrics.alloc_mb = usage.ru_maxrss / 1024;
+    }
+
+    // Smaller than a pipe buffer, written at once
+    const bool written = write(pipe_fd, &metrics, sizeof(metrics)) == sizeof(metrics);
+    _exit(written ? 0 : 1);  // Skips the destructors and atexit handlers of the parent's state
+}
+
+void BatchRunner::collect(const Worker &worker, int status) {
+    CaseResult &result = cases_[worker.case_idx];
+    if (read(worker.pipe_fd, &result.metrics, sizeof(result.metrics)) == sizeof(result.metrics)) {
+        result.finished = true;
+    } else if (WIFSIGNALED(status)) {
+        result.error = std::string("Worker killed by signal ") + strsignal(WTERMSIG(status));
+    } else {
+        result.error = "Worker exited with status " + std::to_string(WEXITSTATUS(status));
+    }
+    close(worker.pipe_fd);
+
+    const CaseMetrics &metrics = result.metrics;
+    if (result.finished && metrics.error[0]) {
+        fprintf(stderr, "%s: %s in %.2f s, %u MB.\n", result.level.c_str(), metrics.error, metrics.time_s, metrics.alloc_mb);
+    } else if (result.finished) {
+        fprintf(stderr, "%s: solved, length %llu in %.2f s, %u MB.\n", result.level.c_str(),
+                static_cast<unsigned long long>(metrics.solution_length), metrics.time_s, metrics.alloc_mb);
+    } else {
+        fprintf(stderr, "%s: %s.\n", result.level.c_str(), result.error.c_str());
+    }
+}
+
+int BatchRunner::run(FILE *out) {
+    if (options_.strategy == "stream" || options_.strategy == "windowed") {
+        fprintf(stderr, "Strategy %s needs a server, batch mode plans offline.\n", options_.strategy.c_str());
+        return 1;
+    }
+    std::error_code error;
+    if (std::filesystem::is_regular_file(options_.levels_dir, error)) {
+        // A single level, reported under its file name
+        const std::filesystem::path path(options_.levels_dir);
+        options_.levels_dir = path.parent_path().string();
+        cases_.push_back(CaseResult{path.filename().string(), false, {}, ""});
+    } else {
+        for (auto it = std::filesystem::recursive_directory_iterator(options_.levels_dir, error);
+             !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            if (it->is_regular_file() && it->path().extension() == ".lvl") {
+                cases_.push_back(CaseResult{std::filesystem::relative(it->path(), options_.levels_dir).generic_string(), false, {}, ""});
+            }
+        }
+    }
+    if (error) {
+        fprintf(stderr, "Cannot read %s: %s\n", options_.levels_dir.c_str(), error.message().c_str());
+        return 1;
+    }
+    std::sort(cases_.begin(), cases_.end(), [](const CaseResult &a, const CaseResult &b) { return a.level < b.level; });
+    fprintf(stderr, "Batch: %zu levels, strategy %s, %zu workers, %lld s and %u MB per level.\n", cases_.size(),
+            options_.strategy.c_str(), options_.workers, static_cast<long long>(options_.timeout.count()), options_.memory_limit_mb);
+
+    const auto batch_start = std::chrono::steady_clock::now();
+    std::vector<Worker> workers;
+    size_t next_case = 0;
+    while (next_case < cases_.size() || !workers.empty()) {
+        while (next_case < cases_.size() && workers.size() < options_.workers) {
+            int pipe_fds[2];
+            if (pipe(pipe_fds) != 0) {
+                fprintf(stderr, "Cannot create a pipe: %s\n", strerror(errno));
+                return 1;
+            }
+            fflush(nullptr);  // The worker must not flush the parent's buffered output again
+            const pid_t pid = fork();
+            if (pid == 0) {
+                close(pipe_fds[0]);
+                solveCase((std::filesystem::path(options_.levels_dir) / cases_[next_case].level).string(), pipe_fds[1]);
+            }
+            close(pipe_fds[1]);
+            if (pid < 0) {
+                close(pipe_fds[0]);
+                fprintf(stderr, "Cannot start a worker: %s\n", strerror(errno));
+                return 1;
+            }
+            workers.push_back(Worker{pid, pipe_fds[0], next_case++, std::chrono::steady_clock::now()});
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        for (auto it = workers.begin(); it != workers.end();) {
+            int status = 0;
+            if (waitpid(it->pid, &status, WNOHANG) == it->pid) {
+                collect(*it, status);
+                it = workers.erase(it);
+                continue;
+            }
+            if (std::chrono::steady_clock::now() - it->started > options_.timeout + KILL_GRACE) {
+                kill(it->pid, SIGKILL);
+                waitpid(it->pid, &status, 0);
+                close(it->pipe_fd);
+                cases_[it->case_idx].error = "Timed out";
+                fprintf(stderr, "%s: timed out.\n", cases_[it->case_idx].level.c_str());
+                it = workers.erase(it);
+                continue;
+            }
+            ++it;
+        }
+    }
+
+    const size_t solved = std::count_if(cases_.begin(), cases_.end(), [](const CaseResult &result) {
+        return result.finished && !result.metrics.error[0];
+    });
+    fprintf(stderr, "Solved %zu of %zu levels in %.1f s.\n", solved, cases_.size(),
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - batch_start).count());
+    printJson(out);
+    return 0;
+}
+
+static std::string jsonString(const std::string &value) {
+    std::string quoted = "\"";
+    for (const char c : value) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+void BatchRunner::printJson(FILE *out) const {
+    char timestamp[32];
+    const time_t now = time(nullptr);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    std::map<std::string, size_t> portfolio_wins;
+    fprintf(out, "{\n    \"timestamp\": \"%s\",\n    \"cases\": [", timestamp);
+    for (size_t i = 0; i < cases_.size(); i++) {
+        const CaseResult &result = cases_[i];
+        const CaseMetrics &metrics = result.metrics;
+        fprintf(out, "%s\n        {\n            \"level\": %s,\n            \"strategy\": %s,\n", i ? "," : "",
+                jsonString(result.level).c_str(), jsonString(options_.strategy).c_str());
+        fprintf(out, "            \"solution_length\": %llu,\n            \"metrics\": {\n",
+                static_cast<unsigned long long>(result.finished ? metrics.solution_length : 0));
+        if (result.finished) {
+            fprintf(out,
+                    "                \"expanded\": %llu,\n                \"generated\": %llu,\n                \"time[s]\": %.3f,\n"
+                    "                \"alloc[mb]\": %u,\n                \"maxalloc[mb]\": %u,\n"
+                    "                \"sic\": %llu,\n                \"fuel\": %llu%s\n",
+                    static_cast<unsigned long long>(metrics.expanded), static_cast<unsigned long long>(metrics.generated), metrics.time_s,
+                    metrics.alloc_mb, options_.memory_limit_mb, static_cast<unsigned long long>(metrics.sum_of_costs),
+                    static_cast<unsigned long long>(metrics.fuel), metrics.error[0] ? "," : "");
+            if (metrics.error[0]) {
+                fprintf(out, "                \"error\": %s\n", jsonString(metrics.error).c_str());
+            }
+        } else {
+            fprintf(out, "                \"error\": %s\n", jsonString(result.error).c_str());
+        }
+        const bool won = result.finished && metrics.portfolio_winner[0];
+        fprintf(out, "            },\n            \"portfolio_winner\": %s\n        }",
+                won ? jsonString(metrics.portfolio_winner).c_str() : "null");
+        if (won) {
+            portfolio_wins[metrics.portfolio_winner]++;
+        }
+    }
+    fprintf(out, "\n    ],\n    \"portfolio_wins\": {");
+    size_t printed = 0;
+    for (const auto &[name, wins] : portfolio_wins) {
+        fprintf(out, "%s\n        %s: %zu", printed++ ? "," : "", jsonString(name).c_str(), wins);
+    }
+    fprintf(out, "%s}\n}\n", portfolio_wins.empty() ? "" : "\n    ");
+}
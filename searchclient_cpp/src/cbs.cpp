@@ -1,41 +1,122 @@
 #include "cbs.hpp"
 
 // C++
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <queue>
 #include <unordered_map>
 
+#include "feature_flags.hpp"
 #include "memory.hpp"
+#include "search_config.hpp"
+#include "search_stats.hpp"
+
+// Time spent on the prioritized warm start, at most this share of what is left until the deadline
+static constexpr std::chrono::milliseconds WARM_START_BUDGET(1'000);
+static constexpr size_t WARM_START_BUDGET_SHARE = 10;
 
 void printSearchStatus(const CBSFrontier &cbs_frontier, const size_t &generated_states_count) {
-    static bool first_time = true;
+    static std::atomic<bool> first_time(true);
 
-    if (first_time) {
+    if (first_time.exchange(false)) {
         fprintf(stdout, "#frontier, alloc[mb], generated\n");
-        first_time = false;
     }
 
     fprintf(stdout, "#%11zu, %13d, %16zu\n", cbs_frontier.size(), Memory::getUsage(), generated_states_count);
     fflush(stdout);
 }
 
-CBS::CBS(const Level &loaded_level) : initial_level(loaded_level) {
+CBS::CBS(const Level &loaded_level, std::chrono::steady_clock::time_point deadline, const CBS *previous) : initial_level(loaded_level),
+      initial_agents_states_(),
+      unsplit_groups_(),
+      agents_num_(0),
+      visited_constraint_sets_(),
+      deadline_(deadline),
+      cancellation_token_(nullptr),
+      conflict_window_(SIZE_MAX),
+      warm_start_(true),
+      heuristic_factory_([]() { return SearchConfig::active.makeHeuristic(); }),
+      solutions_(),
+      agent_symbol_to_group_info_(),
+      total_agents_(0),
+      box_owner_symbols_(),
+      distances_cache_(previous ? previous->distances_cache_ : std::map<Cell2D, std::vector<size_t>>()),
+      target_splits_count_(0),
+      corridor_splits_count_(0),
+      rectangle_splits_count_(0),
+      generated_states_count_(0),
+      expanded_states_count_(0),
+      expanded_nodes_count_(0) {
+#ifdef USE_INDEPENDENCE_DETECTION
+    initial_agents_states_ = buildIndependentGroups();
+#else
+    initial_agents_states_ = buildColorGroups();
+#endif
+#ifdef USE_TASK_ALLOCATION
+    initial_agents_states_ = allocateTasks(initial_agents_states_);
+#endif
+    agents_num_ = initial_agents_states_.size();
+
+    // Build agent symbol mapping using helper function
+    auto mapping_result = buildAgentMapping(initial_agents_states_);
+    agent_symbol_to_group_info_ = std::move(mapping_result.first);
+    total_agents_ = mapping_result.second;
+    assignBoxOwners();
+}
+
+void CBS::assignBoxOwners() {
+    box_owner_symbols_.clear();
+    for (const auto &box_bulk : initial_level.boxes) {
+        for (const auto &position : box_bulk.getPositions()) {
+            char owner = 0;
+            for (const auto group_state : initial_agents_states_) {
+                if (group_state->getBoxAt(position) == box_bulk.getSymbol()) {
+                    owner = group_state->agents.front().getSymbol();
+                    break;
+                }
+            }
+            box_owner_symbols_.push_back(owner);
+        }
+    }
+}
+
+bool CBS::undoTaskAllocation() {
+    if (unsplit_groups_.empty()) {
+        return false;
+    }
+    for (auto group : initial_agents_states_) {
+        delete group;
+    }
+    initial_agents_states_ = std::move(unsplit_groups_);
+    unsplit_groups_.clear();
+    agents_num_ = initial_agents_states_.size();
+    agent_symbol_to_group_info_ = buildAgentMapping(initial_agents_states_).first;
+    assignBoxOwners();
+    // Constraint sets name groups by index
+    visited_constraint_sets_.clear();
+    fprintf(stderr, "Task allocation undone, planning %zu groups.\n", initial_agents_states_.size());
+    return true;
+}
+
+std::vector<LowLevelState *> CBS::buildColorGroups() const {
     // Group agents by color
     std::map<Color, std::vector<Agent>> agents_by_color;
     std::map<Color, std::vector<BoxBulk>> boxes_by_color;
 
     // Group agents by their color
-    for (const auto &agent : loaded_level.agents) {
+    for (const auto &agent : initial_level.agents) {
         Color agent_color = initial_level.static_level.getAgentColor(agent.getSymbol());
         agents_by_color[agent_color].push_back(agent);
     }
 
     // Group boxes by their color
-    for (const auto &box : loaded_level.boxes) {
+    for (const auto &box : initial_level.boxes) {
         boxes_by_color[box.getColor()].push_back(box);
     }
 
     // Create LowLevelState for each color group that has agents
+    std::vector<LowLevelState *> groups;
     for (const auto &[color, agents] : agents_by_color) {
         std::vector<BoxBulk> matching_boxes;
         if (boxes_by_color.find(color) != boxes_by_color.end()) {
@@ -45,55 +126,398 @@ CBS::CBS(const Level &loaded_level) : initial_level(loaded_level) {
             }
         }
 
-        initial_agents_states_.push_back(new LowLevelState(initial_level.static_level, agents, matching_boxes));
+        groups.push_back(new LowLevelState(initial_level.static_level, agents, matching_boxes));
+    }
+    return groups;
+}
+
+std::vector<LowLevelState *> CBS::buildIndependentGroups() const {
+    const StaticLevel &static_level = initial_level.static_level;
+    const size_t cols = static_level.getSize().c;
+
+    // Label the wall-separated regions lazily, starting from the cells that matter
+    std::vector<size_t> regions(static_level.getSize().r * cols, SIZE_MAX);
+    size_t regions_count = 0;
+    auto region_of = [&](const Cell2D &cell) {
+        size_t &region = regions[cell.r * cols + cell.c];
+        if (region != SIZE_MAX || !static_level.isCellFree(cell)) {
+            return region;
+        }
+        std::queue<Cell2D> queue;
+        region = regions_count++;
+        queue.push(cell);
+        while (!queue.empty()) {
+            const Cell2D current = queue.front();
+            queue.pop();
+            for (const Action *action : {&Action::MoveN, &Action::MoveS, &Action::MoveE, &Action::MoveW}) {
+                const Cell2D next = current + action->agent_delta;
+                if (static_level.isCellFree(next) && regions[next.r * cols + next.c] == SIZE_MAX) {
+                    regions[next.r * cols + next.c] = region;
+                    queue.push(next);
+                }
+            }
+        }
+        return region;
+    };
+
+    std::map<std::pair<Color, size_t>, std::vector<Agent>> agents_by_region;
+    for (const auto &agent : initial_level.agents) {
+        const Color color = static_level.getAgentColor(agent.getSymbol());
+        agents_by_region[{color, region_of(agent.getPosition())}].push_back(agent);
+    }
+
+    // Split every bulk into the boxes and goals of each region
+    std::map<std::pair<Color, size_t>, std::vector<BoxBulk>> boxes_by_region;
+    for (const auto &bulk : initial_level.boxes) {
+        std::map<size_t, std::pair<std::vector<Cell2D>, std::vector<Cell2D>>> parts;
+        for (const auto &position : bulk.getPositions()) {
+            parts[region_of(position)].first.push_back(position);
+        }
+        for (const auto &goal : bulk.getGoals()) {
+            parts[region_of(goal)].second.push_back(goal);
+        }
+        for (const auto &[region, part] : parts) {
+            boxes_by_region[{bulk.getColor(), region}].push_back(BoxBulk(part.first, part.second, bulk.getColor(), bulk.getSymbol()));
+        }
+    }
+
+    // Agents sharing a region with boxes of their color may need each other's help, the rest plan alone
+    std::vector<LowLevelState *> groups;
+    for (const auto &[key, agents] : agents_by_region) {
+        auto boxes_it = boxes_by_region.find(key);
+        if (boxes_it == boxes_by_region.end()) {
+            for (const auto &agent : agents) {
+                groups.push_back(new LowLevelState(static_level, {agent}, {}));
+            }
+            continue;
+        }
+        groups.push_back(new LowLevelState(static_level, agents, boxes_it->second));
+        boxes_by_region.erase(boxes_it);
+    }
+
+    // Boxes no agent of their color can reach never move, the first group of their color keeps them as obstacles
+    for (const auto &[key, bulks] : boxes_by_region) {
+        for (auto group : groups) {
+            if (static_level.getAgentColor(group->agents.front().getSymbol()) == key.first) {
+                for (const auto &bulk : bulks) {
+                    group->box_bulks.push_back(bulk);
+                }
+                break;
+            }
+        }
+    }
+    return groups;
+}
+
+std::vector<LowLevelState *> CBS::allocateTasks(const std::vector<LowLevelState *> &groups) {
+    std::vector<LowLevelState *> allocated_groups;
+    std::vector<const LowLevelState *> split_groups;
+    for (auto group : groups) {
+        if (group->agents.size() < 2 || group->box_bulks.empty()) {
+            allocated_groups.push_back(group);
+            continue;
+        }
+        const size_t cols = initial_level.static_level.getSize().c;
+        auto distance = [&](const Cell2D &from, const Cell2D &to) { return getDistances(from)[to.r * cols + to.c]; };
+
+        // Match the goals of every box letter to the boxes of that letter
+        struct Task {
+            size_t bulk_idx;
+            Cell2D box;
+            Cell2D goal;
+        };
+        std::vector<Task> tasks;
+        std::vector<std::vector<bool>> is_task_box(group->box_bulks.size());
+        bool feasible = true;
+        for (size_t bulk_idx = 0; bulk_idx < group->box_bulks.size() && feasible; bulk_idx++) {
+            const BoxBulk &bulk = group->box_bulks[bulk_idx];
+            is_task_box[bulk_idx].assign(bulk.size(), false);
+            if (!bulk.hasGoals()) {
+                continue;
+            }
+            if (bulk.getGoalsCount() > bulk.size()) {
+                feasible = false;
+                break;
+            }
+            std::vector<std::vector<size_t>> costs(bulk.getGoalsCount(), std::vector<size_t>(bulk.size()));
+            for (size_t goal_idx = 0; goal_idx < bulk.getGoalsCount(); goal_idx++) {
+                for (size_t box_idx = 0; box_idx < bulk.size(); box_idx++) {
+                    costs[goal_idx][box_idx] = distance(bulk.getGoal(goal_idx), bulk.getPosition(box_idx));
+                }
+            }
+            const auto boxes_of_goals = utils::minCostAssignment(costs);
+            for (size_t goal_idx = 0; goal_idx < boxes_of_goals.size(); goal_idx++) {
+                is_task_box[bulk_idx][boxes_of_goals[goal_idx]] = true;
+                tasks.push_back({bulk_idx, bulk.getPosition(boxes_of_goals[goal_idx]), bulk.getGoal(goal_idx)});
+            }
+        }
+        if (!feasible || tasks.empty()) {
+            allocated_groups.push_back(group);
+            continue;
+        }
+
+        // Each agent takes at most its share of the tasks, a task goes to the agent closest to its box
+        const size_t agents_count = group->agents.size();
+        const size_t capacity = (tasks.size() + agents_count - 1) / agents_count;
+        std::vector<std::vector<size_t>> costs(tasks.size(), std::vector<size_t>(agents_count * capacity));
+        for (size_t task_idx = 0; task_idx < tasks.size(); task_idx++) {
+            for (size_t agent_idx = 0; agent_idx < agents_count; agent_idx++) {
+                const size_t cost = distance(group->agents[agent_idx].getPosition(), tasks[task_idx].box);
+                for (size_t slot = 0; slot < capacity; slot++) {
+                    costs[task_idx][agent_idx * capacity + slot] = cost;
+                }
+            }
+        }
+        const auto slots_of_tasks = utils::minCostAssignment(costs);
+
+        // Per agent and bulk, the positions and goals it is responsible for
+        std::vector<std::vector<std::pair<std::vector<Cell2D>, std::vector<Cell2D>>>> parts(
+            agents_count, std::vector<std::pair<std::vector<Cell2D>, std::vector<Cell2D>>>(group->box_bulks.size()));
+        for (size_t task_idx = 0; task_idx < tasks.size(); task_idx++) {
+            auto &part = parts[slots_of_tasks[task_idx] / capacity][tasks[task_idx].bulk_idx];
+            part.first.push_back(tasks[task_idx].box);
+            part.second.push_back(tasks[task_idx].goal);
+        }
+        // Boxes without a goal only have to get out of the way, the closest agent takes care of them
+        for (size_t bulk_idx = 0; bulk_idx < group->box_bulks.size(); bulk_idx++) {
+            const BoxBulk &bulk = group->box_bulks[bulk_idx];
+            for (size_t box_idx = 0; box_idx < bulk.size(); box_idx++) {
+                if (is_task_box[bulk_idx][box_idx]) {
+                    continue;
+                }
+                size_t closest_agent = 0;
+                for (size_t agent_idx = 1; agent_idx < agents_count; agent_idx++) {
+                    if (distance(group->agents[agent_idx].getPosition(), bulk.getPosition(box_idx)) <
+                        distance(group->agents[closest_agent].getPosition(), bulk.getPosition(box_idx))) {
+                        closest_agent = agent_idx;
+                    }
+                }
+                parts[closest_agent][bulk_idx].first.push_back(bulk.getPosition(box_idx));
+            }
+        }
+
+        for (size_t agent_idx = 0; agent_idx < agents_count; agent_idx++) {
+            std::vector<BoxBulk> boxes;
+            for (size_t bulk_idx = 0; bulk_idx < group->box_bulks.size(); bulk_idx++) {
+                const auto &[positions, goals] = parts[agent_idx][bulk_idx];
+                if (!positions.empty()) {
+                    const BoxBulk &bulk = group->box_bulks[bulk_idx];
+                    boxes.push_back(BoxBulk(positions, goals, bulk.getColor(), bulk.getSymbol()));
+                }
+            }
+            allocated_groups.push_back(new LowLevelState(initial_level.static_level, {group->agents[agent_idx]}, boxes));
+        }
+        fprintf(stderr, "Task allocation split a group of %zu agents and %zu tasks.\n", agents_count, tasks.size());
+        split_groups.push_back(group);
+    }
+    if (!split_groups.empty()) {
+        for (auto group : groups) {
+            const bool split = std::find(split_groups.begin(), split_groups.end(), group) != split_groups.end();
+            unsplit_groups_.push_back(split ? group : group->clone());
+        }
+    }
+    return allocated_groups;
+}
+
+void CBS::mergeGroups(size_t group1_idx, size_t group2_idx) {
+    LowLevelState *group1 = initial_agents_states_[group1_idx];
+    LowLevelState *group2 = initial_agents_states_[group2_idx];
+    // Copy element by element since the assignment operators are deleted
+    std::vector<Agent> agents = group1->agents;
+    for (const auto &agent : group2->agents) {
+        agents.push_back(agent);
+    }
+    std::vector<BoxBulk> boxes = group1->box_bulks;
+    for (const auto &bulk : group2->box_bulks) {
+        boxes.push_back(bulk);
     }
 
+    initial_agents_states_[group1_idx] = new LowLevelState(initial_level.static_level, agents, boxes);
+    initial_agents_states_.erase(initial_agents_states_.begin() + group2_idx);
+    delete group1;
+    delete group2;
+
     agents_num_ = initial_agents_states_.size();
+    agent_symbol_to_group_info_ = buildAgentMapping(initial_agents_states_).first;
+}
 
-    // Build agent symbol mapping using helper function
-    auto mapping_result = buildAgentMapping(initial_agents_states_);
-    agent_symbol_to_group_info_ = std::move(mapping_result.first);
-    total_agents_ = mapping_result.second;
+std::vector<std::vector<std::vector<const Action *>>> CBS::splitPlan(const std::vector<std::vector<const Action *>> &plan) const {
+    std::vector<std::vector<std::vector<const Action *>>> solutions(initial_agents_states_.size());
+    for (size_t group_idx = 0; group_idx < solutions.size(); group_idx++) {
+        solutions[group_idx].resize(plan.size(), std::vector<const Action *>(initial_agents_states_[group_idx]->agents.size()));
+    }
+    for (size_t t = 0; t < plan.size(); t++) {
+        size_t agent_column = 0;
+        for (const auto &[symbol, group_info] : agent_symbol_to_group_info_) {
+            solutions[group_info.first][t][group_info.second] = plan[t][agent_column++];
+        }
+    }
+
+    // A group that is done waits on its final cells, so its trailing NoOps carry no information
+    for (auto &solution : solutions) {
+        while (!solution.empty() && std::all_of(solution.back().begin(), solution.back().end(),
+                                                [](const Action *action) { return action->type == ActionType::NoOp; })) {
+            solution.pop_back();
+        }
+    }
+    return solutions;
 }
 
 CBS::~CBS() {
     for (auto agent_state : initial_agents_states_) {
         delete agent_state;
     }
+    for (auto group : unsplit_groups_) {
+        delete group;
+    }
+}
+
+std::vector<std::vector<std::vector<const Action *>>> CBS::findWarmStartSolutions() const {
+    PrioritizedPlanner prioritized_planner(initial_level, initial_agents_states_);
+    const auto now = std::chrono::steady_clock::now();
+    const auto remaining = deadline_ > now ? deadline_ - now : std::chrono::steady_clock::duration::zero();
+    const auto budget = std::min<std::chrono::steady_clock::duration>(WARM_START_BUDGET, remaining / WARM_START_BUDGET_SHARE);
+    prioritized_planner.setDeadline(now + budget);
+    prioritized_planner.setCancellationToken(cancellation_token_);
+
+    auto solutions = prioritized_planner.solveWithRestarts();
+    if (solutions.empty()) {
+        fprintf(stderr, "Prioritized warm start failed after %zu attempts.\n", prioritized_planner.getAttemptsCount());
+    } else {
+        fprintf(stderr, "Prioritized warm start found cost %zu after %zu attempts.\n", utils::CBS_cost(solutions),
+                prioritized_planner.getAttemptsCount());
+    }
+    return solutions;
 }
 
 std::vector<std::vector<const Action *>> CBS::solve() {
-    size_t generated_states_count = 0;
+    solutions_.clear();
+    size_t &generated_states_count = generated_states_count_;
+    generated_states_count = 0;
+    expanded_states_count_ = 0;
     CTNode root;
 
     CBSFrontier cbs_frontier;
 
+    std::vector<std::vector<std::vector<const Action *>>> incumbent_solutions;
+#ifdef USE_PRIORITIZED_WARM_START
+    if (warm_start_) {
+        incumbent_solutions = findWarmStartSolutions();
+    }
+#endif
+    size_t iterations = 0;
+    auto print_reasoning_stats = [&]() {
+        expanded_nodes_count_ = iterations;
+        fprintf(stderr, "CBS expanded %zu CT nodes.\n", iterations);
+        fprintf(stderr, "Symmetry reasoning splits: target %zu, corridor %zu, rectangle %zu.\n", target_splits_count_,
+                corridor_splits_count_, rectangle_splits_count_);
+    };
+    auto fallback_plan = [&]() -> std::vector<std::vector<const Action *>> {
+        print_reasoning_stats();
+        if (incumbent_solutions.empty()) {
+            return {};
+        }
+        fprintf(stderr, "CBS falls back to the prioritized plan.\n");
+        solutions_ = incumbent_solutions;
+        return mergePlans(incumbent_solutions);
+    };
+    // The split groups found no plan. Planned whole, a group's agents may take each other's tasks.
+    auto unsplit_plan = [&]() -> std::vector<std::vector<const Action *>> {
+        if (!incumbent_solutions.empty() || !undoTaskAllocation()) {
+            return fallback_plan();
+        }
+        print_reasoning_stats();
+        const size_t generated = generated_states_count_, expanded = expanded_states_count_;
+        auto plan = solve();
+        generated_states_count_ += generated;
+        expanded_states_count_ += expanded;
+        return plan;
+    };
+
     // root.constraints.reserve(agents_states_.size());
     // root.solutions.reserve(agents_states_.size());
 
     // Create AgentGraphSearch objects for each agent_state
+    ConstraintTable constraint_table;
+    ReservationTable conflict_avoidance_table(initial_level.static_level);
+    auto make_search = [&](LowLevelState *agent_state) {
+        Graphsearch *search = new Graphsearch(agent_state, SearchConfig::active.makeFrontier(heuristic_factory_()));
+        search->setDeadline(deadline_);
+        search->setCancellationToken(cancellation_token_);
+#ifdef USE_CONFLICT_AVOIDANCE
+        search->setConflictAvoidanceTable(&conflict_avoidance_table);
+#endif
+        return search;
+    };
     std::vector<Graphsearch *> agent_searches;
     agent_searches.reserve(initial_agents_states_.size());
     for (auto agent_state : initial_agents_states_) {
-        agent_searches.push_back(new Graphsearch(agent_state, new FrontierBestFirst(new HeuristicAStar())));
+        agent_searches.push_back(make_search(agent_state));
     }
 
-    // Find a solution for each agent bulk
+    // Find a solution for each agent bulk, avoiding the groups planned before it
     for (size_t i = 0; i < agent_searches.size(); i++) {
+#ifdef USE_CONFLICT_AVOIDANCE
+        buildConflictAvoidanceTable(root.solutions, i, conflict_avoidance_table);
+#endif
         auto bulk_plan = agent_searches[i]->solve({});
         generated_states_count += agent_searches[i]->getGeneratedStatesCount();
+        expanded_states_count_ += agent_searches[i]->getExpandedStatesCount();
         if (!agent_searches[i]->wasSolutionFound()) {
             printSearchStatus(cbs_frontier, generated_states_count);
-            return {};
+            return unsplit_plan();
         }
         root.solutions.push_back(bulk_plan);
     }
 
+#ifdef USE_INDEPENDENCE_DETECTION
+    // Groups of one color were split as far as the level allows, merge the box-free ones whose plans still conflict.
+    // Groups owning boxes only meet other groups of their color after task allocation, CBS coordinates those.
+    const size_t independent_groups_count = initial_agents_states_.size();
+    while (true) {
+        const FullConflict conflict = findFirstConflict(mergePlans(root.solutions), true, conflict_window_);
+        if (conflict.a1_symbol == 0 && conflict.a2_symbol == 0) {
+            break;
+        }
+        size_t group1_idx = agent_symbol_to_group_info_.at(conflict.a1_symbol).first;
+        size_t group2_idx = agent_symbol_to_group_info_.at(conflict.a2_symbol).first;
+        if (group1_idx > group2_idx) {
+            std::swap(group1_idx, group2_idx);
+        }
+
+        const auto incumbent_plan = mergePlans(incumbent_solutions);
+        mergeGroups(group1_idx, group2_idx);
+        if (!incumbent_solutions.empty()) {
+            incumbent_solutions = splitPlan(incumbent_plan);
+        }
+
+        delete agent_searches[group1_idx];
+        delete agent_searches[group2_idx];
+        agent_searches.erase(agent_searches.begin() + group2_idx);
+        agent_searches[group1_idx] = make_search(initial_agents_states_[group1_idx]);
+        root.solutions.erase(root.solutions.begin() + group2_idx);
+
+#ifdef USE_CONFLICT_AVOIDANCE
+        buildConflictAvoidanceTable(root.solutions, group1_idx, conflict_avoidance_table);
+#endif
+        root.solutions[group1_idx] = agent_searches[group1_idx]->solve({});
+        generated_states_count += agent_searches[group1_idx]->getGeneratedStatesCount();
+        expanded_states_count_ += agent_searches[group1_idx]->getExpandedStatesCount();
+        if (!agent_searches[group1_idx]->wasSolutionFound()) {
+            printSearchStatus(cbs_frontier, generated_states_count);
+            return unsplit_plan();
+        }
+    }
+    fprintf(stderr, "Independence detection: %zu independent groups, %zu after merging.\n", independent_groups_count,
+            initial_agents_states_.size());
+#endif
+
+    const size_t incumbent_cost = incumbent_solutions.empty() ? SIZE_MAX : utils::CBS_cost(incumbent_solutions);
     root.cost = utils::CBS_cost(root.solutions);
 
     cbs_frontier.add(&root);
+    SearchStats::add(SearchStats::CT_NODES_GENERATED);
 
-    size_t iterations = 0;
     while (!cbs_frontier.isEmpty()) {
         if (iterations < 5 || iterations % 20 == 0) {  // 10000
             printSearchStatus(cbs_frontier, generated_states_count);
@@ -103,6 +527,7 @@ std::vector<std::vector<const Action *>> CBS::solve() {
 
         // Check for duplicate constraint sets
         if (visited_constraint_sets_.find(node->one_sided_conflicts) != visited_constraint_sets_.end()) {
+            SearchStats::add(SearchStats::CT_DUPLICATES_PRUNED);
             delete node;
             continue;
         }
@@ -111,13 +536,33 @@ std::vector<std::vector<const Action *>> CBS::solve() {
         if (Memory::getUsage() > Memory::maxUsage) {
             fprintf(stderr, "Maximum memory usage exceeded.\n");
             printSearchStatus(cbs_frontier, generated_states_count);
-            return {};
+            return fallback_plan();
+        }
+
+        if (std::chrono::steady_clock::now() > deadline_) {
+            fprintf(stderr, "CBS deadline reached.\n");
+            printSearchStatus(cbs_frontier, generated_states_count);
+            return fallback_plan();
+        }
+
+        if (cancellation_token_ && cancellation_token_->isCancelled()) {
+            return fallback_plan();
+        }
+
+        // Best-first order: no remaining node can beat the warm start plan
+        if (node->cost >= incumbent_cost) {
+            printSearchStatus(cbs_frontier, generated_states_count);
+            print_reasoning_stats();
+            solutions_ = incumbent_solutions;
+            return mergePlans(incumbent_solutions);
         }
 
         std::vector<std::vector<const Action *>> merged_plans = mergePlans(node->solutions);
-        FullConflict conflict = findFirstConflict(merged_plans);
+        FullConflict conflict = findFirstConflict(merged_plans, false, conflict_window_);
         if (conflict.a1_symbol == 0 && conflict.a2_symbol == 0) {
             printSearchStatus(cbs_frontier, generated_states_count);
+            print_reasoning_stats();
+            solutions_ = node->solutions;
             return merged_plans;
         }
 
@@ -126,7 +571,9 @@ std::vector<std::vector<const Action *>> CBS::solve() {
         // fprintf(stderr, "One-sided conflicts: %zu, Node cost: %zu\n", node->one_sided_conflicts.size(), node->cost);
         // fflush(stderr);
 
-        for (auto agent_symbol : {conflict.a1_symbol, conflict.a2_symbol}) {
+        for (const auto &branch : splitConflict(conflict, *node, merged_plans)) {
+            const char agent_symbol = branch.front().a1_symbol;
+
             // Fast lookup of group index for this agent symbol
             auto it = agent_symbol_to_group_info_.find(agent_symbol);
             if (it == agent_symbol_to_group_info_.end()) {
@@ -136,44 +583,383 @@ std::vector<std::vector<const Action *>> CBS::solve() {
             uint_fast8_t group_idx = it->second.first;
 
             CTNode *child = new CTNode(*node);
+            child->one_sided_conflicts.insert(branch.begin(), branch.end());
 
-            auto osc_pair = conflict.split();
-            if (osc_pair.first.a1_symbol == agent_symbol) {
-                child->one_sided_conflicts.insert(osc_pair.first);
-            }
-            if (osc_pair.second.a1_symbol == agent_symbol) {
-                child->one_sided_conflicts.insert(osc_pair.second);
+            // A positive constraint keeps its group's plan and pushes every other group out of the way
+            std::vector<size_t> affected_groups = {group_idx};
+            if (branch.front().constraint.positive) {
+                for (size_t other_idx = 0; other_idx < agent_searches.size(); other_idx++) {
+                    if (other_idx != group_idx) {
+                        affected_groups.push_back(other_idx);
+                    }
+                }
             }
 
-            // Get constraints from conflicts of an agent
-            std::vector<Constraint> constraints;
-            constraints.reserve(child->one_sided_conflicts.size());
-            for (const auto &conflict : child->one_sided_conflicts) {
-                if (conflict.a1_symbol == agent_symbol) {
-                    constraints.push_back(conflict.constraint);
+            bool replanned_all = true;
+            for (size_t affected_idx : affected_groups) {
+                const std::vector<Constraint> constraints = getGroupConstraints(*child, affected_idx);
+                constraint_table.build(constraints);
+                if (constraint_table.isPlanAllowed(*initial_agents_states_[affected_idx], child->solutions[affected_idx])) {
+                    continue;
                 }
-            }
 
-            Graphsearch *agent_search = agent_searches[group_idx];
-            auto plan = agent_search->solve(constraints);
-            generated_states_count += agent_search->getGeneratedStatesCount();
-            child->solutions[group_idx] = plan;
-            if (!agent_search->wasSolutionFound()) {
-                child->cost = SIZE_MAX;
+#ifdef USE_CONFLICT_AVOIDANCE
+                buildConflictAvoidanceTable(child->solutions, affected_idx, conflict_avoidance_table);
+#endif
+                Graphsearch *agent_search = agent_searches[affected_idx];
+                const auto replan_started = SearchStats::start();
+                child->solutions[affected_idx] = agent_search->solve(constraints);
+                SearchStats::addReplan(*initial_agents_states_[affected_idx], replan_started);
+                generated_states_count += agent_search->getGeneratedStatesCount();
+                expanded_states_count_ += agent_search->getExpandedStatesCount();
+                if (!agent_search->wasSolutionFound()) {
+                    replanned_all = false;
+                    break;
+                }
+            }
+            if (!replanned_all) {
                 delete child;
                 continue;
             }
             child->cost = utils::CBS_cost(child->solutions);
             cbs_frontier.add(child);
+            SearchStats::add(SearchStats::CT_NODES_GENERATED);
         }
 
+        SearchStats::add(SearchStats::CT_NODES_EXPANDED);
         iterations++;
     }
     printSearchStatus(cbs_frontier, generated_states_count);
-    return {};
+    return unsplit_plan();
+}
+
+void CBS::buildConflictAvoidanceTable(const std::vector<std::vector<std::vector<const Action *>>> &solutions, size_t group_idx,
+                                      ReservationTable &table) const {
+    table.clear();
+    for (size_t other_idx = 0; other_idx < solutions.size(); other_idx++) {
+        if (other_idx != group_idx) {
+            table.reservePlan(*initial_agents_states_[other_idx], solutions[other_idx]);
+        }
+    }
+}
+
+bool CBS::isSingleAgentGroup(char agent_symbol) const {
+    auto it = agent_symbol_to_group_info_.find(agent_symbol);
+    return it != agent_symbol_to_group_info_.end() && initial_agents_states_[it->second.first]->agents.size() == 1;
+}
+
+bool CBS::isCorridorCell(const Cell2D &cell) const {
+    const StaticLevel &static_level = initial_level.static_level;
+    if (!static_level.isCellFree(cell)) {
+        return false;
+    }
+    size_t free_neighbours = 0;
+    for (const Action *action : {&Action::MoveN, &Action::MoveS, &Action::MoveE, &Action::MoveW}) {
+        free_neighbours += static_level.isCellFree(cell + action->agent_delta);
+    }
+    return free_neighbours == 2;
 }
 
-std::vector<std::vector<const Action *>> CBS::mergePlans(std::vector<std::vector<std::vector<const Action *>>> &plans) {
+const std::vector<size_t> &CBS::getDistances(const Cell2D &from) {
+    auto it = distances_cache_.find(from);
+    if (it != distances_cache_.end()) {
+        return it->second;
+    }
+
+    return distances_cache_.emplace(from, initial_level.static_level.computeDistances(from)).first->second;
+}
+
+std::vector<std::vector<Cell2D>> CBS::getTrajectories(const std::vector<std::vector<const Action *>> &merged_plans) const {
+    std::vector<std::vector<Cell2D>> trajectories(initial_level.agents.size());
+    for (size_t i = 0; i < initial_level.agents.size(); i++) {
+        trajectories[i].reserve(merged_plans.size() + 1);
+        trajectories[i].push_back(initial_level.agents[i].getPosition());
+        for (const auto &joint_action : merged_plans) {
+            trajectories[i].push_back(trajectories[i].back() + joint_action[i]->agent_delta);
+        }
+    }
+    return trajectories;
+}
+
+std::vector<std::vector<OneSidedConflict>> CBS::splitConflict(const FullConflict &conflict, const CTNode &node,
+                                                              const std::vector<std::vector<const Action *>> &merged_plans) {
+    std::vector<std::vector<OneSidedConflict>> branches;
+    const auto trajectories = getTrajectories(merged_plans);
+
+    // Symmetry reasoning only covers conflicts between two agents, box conflicts use the plain split
+    const bool agents_only = conflict.a1_constraint.type == ConstraintType::Vertex && conflict.a2_constraint.type == ConstraintType::Vertex;
+    if (!agents_only) {
+        return splitPlainConflict(conflict);
+    }
+
+    if (splitTargetConflict(conflict, node, trajectories, branches)) {
+        target_splits_count_++;
+        return branches;
+    }
+    if (splitCorridorConflict(conflict, trajectories, branches)) {
+        corridor_splits_count_++;
+        return branches;
+    }
+    if (splitRectangleConflict(conflict, trajectories, branches)) {
+        rectangle_splits_count_++;
+        return branches;
+    }
+
+    return splitPlainConflict(conflict);
+}
+
+std::vector<std::vector<OneSidedConflict>> CBS::splitPlainConflict(const FullConflict &conflict) const {
+#ifdef USE_DISJOINT_SPLITTING
+    // The first side either keeps what its plan does now or is forbidden from it, so the children never overlap
+    const Constraint &constraint = conflict.a1_constraint;
+    return {{OneSidedConflict(conflict.a1_symbol, constraint.asPositive())}, {OneSidedConflict(conflict.a1_symbol, constraint)}};
+#else
+    auto osc_pair = conflict.split();
+    return {{osc_pair.first}, {osc_pair.second}};
+#endif
+}
+
+std::vector<Constraint> CBS::getGroupConstraints(const CTNode &node, size_t group_idx) const {
+    std::vector<Constraint> constraints;
+    constraints.reserve(node.one_sided_conflicts.size());
+    for (const auto &one_sided_conflict : node.one_sided_conflicts) {
+        const Constraint &constraint = one_sided_conflict.constraint;
+        if (agent_symbol_to_group_info_.at(one_sided_conflict.a1_symbol).first == group_idx) {
+            constraints.push_back(constraint);
+            continue;
+        }
+        if (!constraint.positive) {
+            continue;
+        }
+        // Another group holds the cell at t, so nobody else may be there then, nor leave it just before (the group
+        // would follow) or enter it right after
+        for (size_t g = constraint.g ? constraint.g - 1 : 0; g <= constraint.g + 1; g++) {
+            constraints.push_back(Constraint(constraint.vertex, g));
+            constraints.push_back(Constraint::box(constraint.vertex, g));
+        }
+    }
+    return constraints;
+}
+
+// One agent already finished its group's plan on its goal and the other one runs into it later.
+// Either the finished group takes longer than t, or nobody of the other group may enter the goal from t on.
+bool CBS::splitTargetConflict(const FullConflict &conflict, const CTNode &node, const std::vector<std::vector<Cell2D>> &trajectories,
+                              std::vector<std::vector<OneSidedConflict>> &branches) const {
+    const Cell2D &vertex = conflict.constraint.vertex;
+    const size_t t = conflict.constraint.g;
+
+    for (const auto &[finished, other] : {std::make_pair(conflict.a1_symbol, conflict.a2_symbol),
+                                          std::make_pair(conflict.a2_symbol, conflict.a1_symbol)}) {
+        const Agent &agent = initial_level.agents[finished - FIRST_AGENT];
+        const size_t group_idx = agent_symbol_to_group_info_.at(finished).first;
+        if (agent.getGoalPositions().size() != 1 || agent.getGoalPositions()[0] != vertex || node.solutions[group_idx].size() > t) {
+            continue;
+        }
+        if (trajectories[other - FIRST_AGENT][t] != vertex) {
+            continue;  // The other agent's plan would survive the range constraint
+        }
+        branches = {{OneSidedConflict(finished, Constraint::length(vertex, t))},
+                    {OneSidedConflict(other, Constraint::range(vertex, t, Constraint::FOREVER))}};
+        return true;
+    }
+    return false;
+}
+
+// Two single-agent groups cross in a corridor that separates the level, so one has to wait until the other
+// is through. The agent going first reaches its exit k steps before the other one can, at the earliest.
+bool CBS::splitCorridorConflict(const FullConflict &conflict, const std::vector<std::vector<Cell2D>> &trajectories,
+                                std::vector<std::vector<OneSidedConflict>> &branches) {
+    const Cell2D &vertex = conflict.constraint.vertex;
+    if (!isSingleAgentGroup(conflict.a1_symbol) || !isSingleAgentGroup(conflict.a2_symbol) || !isCorridorCell(vertex)) {
+        return false;
+    }
+
+    const StaticLevel &static_level = initial_level.static_level;
+    const size_t cols = static_level.getSize().c;
+    std::vector<bool> in_corridor(static_level.getSize().r * cols, false);
+    in_corridor[vertex.r * cols + vertex.c] = true;
+    size_t corridor_length = 1;
+
+    // Walk away from the conflict in both directions until leaving the corridor
+    std::vector<Cell2D> exits;
+    for (const Action *first_step : {&Action::MoveN, &Action::MoveS, &Action::MoveE, &Action::MoveW}) {
+        Cell2D cell = vertex + first_step->agent_delta;
+        if (!static_level.isCellFree(cell)) {
+            continue;
+        }
+        Cell2D previous = vertex;
+        while (isCorridorCell(cell)) {
+            if (in_corridor[cell.r * cols + cell.c]) {
+                return false;  // The corridor is a cycle
+            }
+            in_corridor[cell.r * cols + cell.c] = true;
+            corridor_length++;
+
+            for (const Action *step : {&Action::MoveN, &Action::MoveS, &Action::MoveE, &Action::MoveW}) {
+                const Cell2D next = cell + step->agent_delta;
+                if (next != previous && static_level.isCellFree(next)) {
+                    previous = cell;
+                    cell = next;
+                    break;
+                }
+            }
+        }
+        exits.push_back(cell);
+    }
+    if (exits.size() != 2 || exits[0] == exits[1]) {
+        return false;
+    }
+
+    // Cells reachable from the first exit without entering the corridor
+    std::vector<bool> first_side(in_corridor.size(), false);
+    std::queue<Cell2D> queue;
+    first_side[exits[0].r * cols + exits[0].c] = true;
+    queue.push(exits[0]);
+    while (!queue.empty()) {
+        const Cell2D cell = queue.front();
+        queue.pop();
+        for (const Action *action : {&Action::MoveN, &Action::MoveS, &Action::MoveE, &Action::MoveW}) {
+            const Cell2D next = cell + action->agent_delta;
+            const size_t idx = next.r * cols + next.c;
+            if (static_level.isCellFree(next) && !in_corridor[idx] && !first_side[idx]) {
+                first_side[idx] = true;
+                queue.push(next);
+            }
+        }
+    }
+    if (first_side[exits[1].r * cols + exits[1].c]) {
+        return false;  // A bypass exists, agents do not have to cross the corridor
+    }
+
+    const Cell2D start1 = initial_level.agents[conflict.a1_symbol - FIRST_AGENT].getPosition();
+    const Cell2D start2 = initial_level.agents[conflict.a2_symbol - FIRST_AGENT].getPosition();
+    const size_t start1_idx = start1.r * cols + start1.c;
+    const size_t start2_idx = start2.r * cols + start2.c;
+    if (in_corridor[start1_idx] || in_corridor[start2_idx] || first_side[start1_idx] == first_side[start2_idx]) {
+        return false;
+    }
+
+    // Each agent exits on the side the other one starts on
+    const Cell2D exit1 = first_side[start1_idx] ? exits[1] : exits[0];
+    const Cell2D exit2 = first_side[start1_idx] ? exits[0] : exits[1];
+    const size_t earliest1 = getDistances(start1)[exit1.r * cols + exit1.c];
+    const size_t earliest2 = getDistances(start2)[exit2.r * cols + exit2.c];
+    if (earliest1 == SIZE_MAX || earliest2 == SIZE_MAX) {
+        return false;
+    }
+    const size_t last_forbidden1 = earliest2 + corridor_length - 1;
+    const size_t last_forbidden2 = earliest1 + corridor_length - 1;
+
+    // Both children must exclude the current plans, otherwise the split makes no progress
+    auto visits_before = [](const std::vector<Cell2D> &trajectory, const Cell2D &cell, size_t last_g) {
+        for (size_t g = 0; g < trajectory.size() && g <= last_g; g++) {
+            if (trajectory[g] == cell) {
+                return true;
+            }
+        }
+        return last_g >= trajectory.size() && trajectory.back() == cell;
+    };
+    if (!visits_before(trajectories[conflict.a1_symbol - FIRST_AGENT], exit1, last_forbidden1) ||
+        !visits_before(trajectories[conflict.a2_symbol - FIRST_AGENT], exit2, last_forbidden2)) {
+        return false;
+    }
+
+    branches = {{OneSidedConflict(conflict.a1_symbol, Constraint::range(exit1, 0, last_forbidden1))},
+                {OneSidedConflict(conflict.a2_symbol, Constraint::range(exit2, 0, last_forbidden2))}};
+    return true;
+}
+
+// Two single-agent groups moving monotonically in the same quadrant meet inside the rectangle spanned by
+// their starts and goals. Every pair of shortest paths crossing it collides, so each child gets a barrier
+// on the rectangle border it exits through, at the times a shortest path would reach it.
+bool CBS::splitRectangleConflict(const FullConflict &conflict, const std::vector<std::vector<Cell2D>> &trajectories,
+                                 std::vector<std::vector<OneSidedConflict>> &branches) const {
+    const Cell2D &vertex = conflict.constraint.vertex;
+    const size_t t = conflict.constraint.g;
+    if (!isSingleAgentGroup(conflict.a1_symbol) || !isSingleAgentGroup(conflict.a2_symbol)) {
+        return false;
+    }
+    const auto &trajectory1 = trajectories[conflict.a1_symbol - FIRST_AGENT];
+    const auto &trajectory2 = trajectories[conflict.a2_symbol - FIRST_AGENT];
+    if (trajectory1[t] != vertex || trajectory2[t] != vertex) {
+        return false;  // Only vertex conflicts
+    }
+
+    const Agent &agent1 = initial_level.agents[conflict.a1_symbol - FIRST_AGENT];
+    const Agent &agent2 = initial_level.agents[conflict.a2_symbol - FIRST_AGENT];
+    if (agent1.getGoalPositions().size() != 1 || agent2.getGoalPositions().size() != 1) {
+        return false;
+    }
+    const int s1r = agent1.getPosition().r, s1c = agent1.getPosition().c;
+    const int s2r = agent2.getPosition().r, s2c = agent2.getPosition().c;
+    const int g1r = agent1.getGoalPositions()[0].r, g1c = agent1.getGoalPositions()[0].c;
+    const int g2r = agent2.getGoalPositions()[0].r, g2c = agent2.getGoalPositions()[0].c;
+    auto sign = [](int x) { return (x > 0) - (x < 0); };
+    auto manhattan = [](int r1, int c1, int r2, int c2) { return size_t(std::abs(r1 - r2) + std::abs(c1 - c2)); };
+
+    const int dr = sign(g1r - s1r);
+    const int dc = sign(g1c - s1c);
+    if (dr == 0 || dc == 0 || dr != sign(g2r - s2r) || dc != sign(g2c - s2c)) {
+        return false;
+    }
+    if (manhattan(s1r, s1c, vertex.r, vertex.c) != t || manhattan(s2r, s2c, vertex.r, vertex.c) != t) {
+        return false;  // Both must be on shortest paths when they meet
+    }
+
+    // Rectangle corners: the later of the starts and the earlier of the goals along each axis
+    const int rs_r = dr > 0 ? std::max(s1r, s2r) : std::min(s1r, s2r);
+    const int rs_c = dc > 0 ? std::max(s1c, s2c) : std::min(s1c, s2c);
+    const int rg_r = dr > 0 ? std::min(g1r, g2r) : std::max(g1r, g2r);
+    const int rg_c = dc > 0 ? std::min(g1c, g2c) : std::max(g1c, g2c);
+    if ((rg_r - rs_r) * dr < 0 || (rg_c - rs_c) * dc < 0 || (vertex.r - rs_r) * dr < 0 || (rg_r - vertex.r) * dr < 0 ||
+        (vertex.c - rs_c) * dc < 0 || (rg_c - vertex.c) * dc < 0) {
+        return false;
+    }
+
+    // One agent enters the rectangle across its start row (vertical mover), the other across its start column
+    char vertical, horizontal;
+    if (s1c == rs_c && s1r != rs_r && s2r == rs_r && s2c != rs_c) {
+        vertical = conflict.a1_symbol;
+        horizontal = conflict.a2_symbol;
+    } else if (s2c == rs_c && s2r != rs_r && s1r == rs_r && s1c != rs_c) {
+        vertical = conflict.a2_symbol;
+        horizontal = conflict.a1_symbol;
+    } else {
+        return false;
+    }
+
+    auto make_barrier = [&](char agent_symbol, bool along_row) {
+        const Cell2D start = initial_level.agents[agent_symbol - FIRST_AGENT].getPosition();
+        const auto &trajectory = trajectories[agent_symbol - FIRST_AGENT];
+        std::vector<OneSidedConflict> barrier;
+        bool blocks_current_plan = false;
+
+        const int from = along_row ? rs_c : rs_r;
+        const int to = along_row ? rg_c : rg_r;
+        const int step = along_row ? dc : dr;
+        for (int i = from;; i += step) {
+            const Cell2D cell = along_row ? Cell2D(rg_r, i) : Cell2D(i, rg_c);
+            const size_t g = manhattan(start.r, start.c, cell.r, cell.c);
+            barrier.push_back(OneSidedConflict(agent_symbol, Constraint(cell, g)));
+            blocks_current_plan |= g < trajectory.size() && trajectory[g] == cell;
+            if (i == to) {
+                break;
+            }
+        }
+        return blocks_current_plan ? barrier : std::vector<OneSidedConflict>();
+    };
+
+    // The vertical mover leaves through the far row, the horizontal mover through the far column
+    auto vertical_barrier = make_barrier(vertical, true);
+    auto horizontal_barrier = make_barrier(horizontal, false);
+    if (vertical_barrier.empty() || horizontal_barrier.empty()) {
+        return false;
+    }
+    branches = {std::move(vertical_barrier), std::move(horizontal_barrier)};
+    return true;
+}
+
+std::vector<std::vector<const Action *>> CBS::mergePlans(const std::vector<std::vector<std::vector<const Action *>>> &plans) const {
     auto plans_copy = plans;
 
     // Make all plans the same length
@@ -184,7 +970,8 @@ std::vector<std::vector<const Action *>> CBS::mergePlans(std::vector<std::vector
 
     // Extend plans to same length with NoOp
     for (size_t i = 0; i < plans_copy.size(); i++) {
-        plans_copy[i].resize(longest_plan_length, std::vector<const Action *>(plans_copy[i][0].size(), (const Action *)&Action::NoOp));
+        const size_t group_agents_count = initial_agents_states_[i]->agents.size();
+        plans_copy[i].resize(longest_plan_length, std::vector<const Action *>(group_agents_count, (const Action *)&Action::NoOp));
     }
 
     std::vector<const Action *> row;
@@ -206,33 +993,193 @@ std::vector<std::vector<const Action *>> CBS::mergePlans(std::vector<std::vector
     return merged_plans;
 }
 
-// Helper function to find which agent is responsible for moving a specific box
-size_t CBS::findAgentResponsibleForBox(size_t box_index, const std::vector<const Action *> &actions,
-                                       const std::vector<Cell2D> &previous_agent_positions,
-                                       const std::vector<Cell2D> &previous_box_positions) const {
-    Cell2D box_previous_pos = previous_box_positions[box_index];
+bool CBS::isConflictFree(const std::vector<std::vector<const Action *>> &plan) const {
+    if (plan.empty()) {
+        return true;
+    }
+    const FullConflict conflict = findFirstConflict(plan);
+    return conflict.a1_symbol == 0 && conflict.a2_symbol == 0;
+}
+
+bool CBS::simulatePlan(const std::vector<std::vector<const Action *>> &plan, std::vector<Cell2D> &agent_positions,
+                       CharGrid &box_cells) const {
+    const StaticLevel &static_level = initial_level.static_level;
+    std::map<char, Color> box_colors;
+
+    agent_positions.clear();
+    for (const auto &agent : initial_level.agents) {
+        agent_positions.push_back(agent.getPosition());
+    }
+    box_cells = CharGrid(static_level.getSize());
+    for (const auto &box_bulk : initial_level.boxes) {
+        box_colors.emplace(box_bulk.getSymbol(), box_bulk.getColor());
+        for (size_t i = 0; i < box_bulk.size(); i++) {
+            box_cells(box_bulk.getPosition(i)) = box_bulk.getSymbol();
+        }
+    }
+
+    auto is_free = [&](const Cell2D &cell) {
+        return static_level.isCellFree(cell) && box_cells(cell) == 0 &&
+               std::find(agent_positions.begin(), agent_positions.end(), cell) == agent_positions.end();
+    };
+
+    std::vector<std::pair<Cell2D, Cell2D>> box_moves;  // (from, to)
+    for (const auto &joint_action : plan) {
+        box_moves.clear();
+
+        // Preconditions are checked on the state before the joint action
+        for (size_t j = 0; j < joint_action.size(); j++) {
+            const Action *action = joint_action[j];
+            const Cell2D agent_pos = agent_positions[j];
+            const Color agent_color = static_level.getAgentColor(initial_level.agents[j].getSymbol());
+
+            if (action->type == ActionType::Move) {
+                if (!is_free(agent_pos + action->agent_delta)) {
+                    return false;
+                }
+            } else if (action->type == ActionType::Push) {
+                const Cell2D box_pos = agent_pos + action->agent_delta;
+                const char box = box_cells(box_pos);
+                if (box == 0 || box_colors.at(box) != agent_color || !is_free(box_pos + action->box_delta)) {
+                    return false;
+                }
+                box_moves.emplace_back(box_pos, box_pos + action->box_delta);
+            } else if (action->type == ActionType::Pull) {
+                const Cell2D box_pos = agent_pos - action->box_delta;
+                const char box = box_cells(box_pos);
+                if (box == 0 || box_colors.at(box) != agent_color || !is_free(agent_pos + action->agent_delta)) {
+                    return false;
+                }
+                box_moves.emplace_back(box_pos, agent_pos);
+            }
+        }
+
+        for (size_t j = 0; j < joint_action.size(); j++) {
+            agent_positions[j] = agent_positions[j] + joint_action[j]->agent_delta;
+        }
+        std::vector<char> moved_boxes;
+        moved_boxes.reserve(box_moves.size());
+        for (const auto &[from, to] : box_moves) {
+            moved_boxes.push_back(box_cells(from));
+            box_cells(from) = 0;
+        }
+        for (size_t i = 0; i < box_moves.size(); i++) {
+            if (box_cells(box_moves[i].second) != 0) {
+                return false;  // Two boxes end in the same cell
+            }
+            box_cells(box_moves[i].second) = moved_boxes[i];
+        }
+    }
+    return true;
+}
 
-    for (size_t agent_idx = 0; agent_idx < actions.size(); ++agent_idx) {
-        const Action *action = actions[agent_idx];
-        Cell2D agent_pos = previous_agent_positions[agent_idx];
+Level *CBS::advanceLevel(const std::vector<std::vector<const Action *>> &prefix) const {
+    std::vector<Cell2D> agent_positions;
+    CharGrid box_cells(initial_level.static_level.getSize());
+    if (!simulatePlan(prefix, agent_positions, box_cells)) {
+        return nullptr;
+    }
+    std::vector<Agent> agents;
+    for (size_t i = 0; i < initial_level.agents.size(); i++) {
+        const Agent &agent = initial_level.agents[i];
+        agents.emplace_back(agent_positions[i], agent.getGoalPositions(), agent.getSymbol());
+    }
+    std::vector<BoxBulk> boxes;
+    for (const auto &box_bulk : initial_level.boxes) {
+        std::vector<Cell2D> positions;
+        for (size_t r = 0; r < box_cells.size_rows(); r++) {
+            for (size_t c = 0; c < box_cells.size_cols(); c++) {
+                if (box_cells(r, c) == box_bulk.getSymbol()) {
+                    positions.emplace_back(r, c);
+                }
+            }
+        }
+        boxes.emplace_back(positions, box_bulk.getGoals(), box_bulk.getColor(), box_bulk.getSymbol());
+    }
+    return new Level(initial_level.static_level, agents, boxes);
+}
+
+std::vector<std::vector<const Action *>> CBS::compressPlan(std::vector<std::vector<const Action *>> plan,
+                                                          std::chrono::steady_clock::time_point deadline) const {
+    if (plan.empty()) {
+        return plan;
+    }
+
+    std::vector<Cell2D> final_agent_positions;
+    CharGrid final_box_cells(initial_level.static_level.getSize());
+    if (!simulatePlan(plan, final_agent_positions, final_box_cells)) {
+        fprintf(stderr, "Plan compression skipped, the plan is not applicable.\n");
+        return plan;
+    }
+
+    auto count_noops = [](const std::vector<std::vector<const Action *>> &joint_plan) {
+        size_t noops = 0;
+        for (const auto &joint_action : joint_plan) {
+            noops += std::count_if(joint_action.begin(), joint_action.end(),
+                                   [](const Action *action) { return action->type == ActionType::NoOp; });
+        }
+        return noops;
+    };
+    const size_t initial_length = plan.size();
+    const size_t initial_noops = count_noops(plan);
 
-        if (action->type == ActionType::Push) {
-            Cell2D expected_box_pos = agent_pos + action->agent_delta;
-            if (expected_box_pos == box_previous_pos) {
-                return agent_idx;
+    std::vector<Cell2D> agent_positions;
+    CharGrid box_cells(initial_level.static_level.getSize());
+    auto is_valid = [&](const std::vector<std::vector<const Action *>> &candidate) {
+        return simulatePlan(candidate, agent_positions, box_cells) && agent_positions == final_agent_positions &&
+               box_cells == final_box_cells && isConflictFree(candidate);
+    };
+
+    bool changed = true;
+    while (changed && std::chrono::steady_clock::now() < deadline) {
+        changed = false;
+        for (size_t agent_idx = 0; agent_idx < total_agents_; agent_idx++) {
+            // Index of the agent's last real action, nothing after it can move earlier
+            size_t last_action = SIZE_MAX;
+            for (size_t t = 0; t < plan.size(); t++) {
+                if (plan[t][agent_idx]->type != ActionType::NoOp) {
+                    last_action = t;
+                }
             }
-        } else if (action->type == ActionType::Pull) {
-            Cell2D expected_box_pos = agent_pos - action->box_delta;
-            if (expected_box_pos == box_previous_pos) {
-                return agent_idx;
+
+            for (size_t t = 0; last_action != SIZE_MAX && t < last_action; t++) {
+                if (plan[t][agent_idx]->type != ActionType::NoOp) {
+                    continue;
+                }
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    break;
+                }
+
+                // Drop the NoOp at t and shift the rest of the agent's actions one step earlier
+                auto candidate = plan;
+                for (size_t k = t; k + 1 < candidate.size(); k++) {
+                    candidate[k][agent_idx] = candidate[k + 1][agent_idx];
+                }
+                candidate.back()[agent_idx] = &Action::NoOp;
+
+                if (is_valid(candidate)) {
+                    plan = std::move(candidate);
+                    last_action--;
+                    changed = true;
+                    t--;  // The shifted step may be a NoOp again
+                }
             }
         }
+
+        while (!plan.empty() && std::all_of(plan.back().begin(), plan.back().end(),
+                                             [](const Action *action) { return action->type == ActionType::NoOp; })) {
+            plan.pop_back();
+        }
     }
 
-    return SIZE_MAX;  // No agent responsible (box didn't move)
+    fprintf(stderr, "Plan compression: length %zu -> %zu, NoOps %zu -> %zu.\n", initial_length, plan.size(), initial_noops,
+            count_noops(plan));
+    return plan;
 }
 
-FullConflict CBS::findFirstConflict(const std::vector<std::vector<const Action *>> &solutions) const {
+// Helper function to find which agent is responsible for moving a specific box
+FullConflict CBS::findFirstConflict(const std::vector<std::vector<const Action *>> &solutions, bool mergeable_only, size_t window) const {
+    SearchStats::ScopedTimer timer(SearchStats::CONFLICT_DETECTION);
     // assert(solutions[0].size() == agents_num_);
 
     std::vector<Cell2D> current_agent_positions(solutions[0].size());
@@ -256,7 +1203,7 @@ FullConflict CBS::findFirstConflict(const std::vector<std::vector<const Action *
     }
     previous_box_positions = current_box_positions;
 
-    for (size_t depth = 0; depth < solutions.size(); depth++) {
+    for (size_t depth = 0; depth < std::min(solutions.size(), window); depth++) {
         // Update position history
         previous_agent_positions = current_agent_positions;
         previous_box_positions = current_box_positions;
@@ -266,7 +1213,7 @@ FullConflict CBS::findFirstConflict(const std::vector<std::vector<const Action *
             current_agent_positions[j] = previous_agent_positions[j] + solutions[depth][j]->agent_delta;
         }
 
-        // Apply box movements for push/pull actions
+        // Apply box movements for push/pull actions, looking boxes up before the step so swapped boxes stay apart
         for (size_t j = 0; j < solutions[0].size(); ++j) {
             const Action *action = solutions[depth][j];
             Cell2D agent_pos = previous_agent_positions[j];
@@ -277,7 +1224,7 @@ FullConflict CBS::findFirstConflict(const std::vector<std::vector<const Action *
 
                 // Find and move the box
                 for (size_t box_idx = 0; box_idx < current_box_positions.size(); ++box_idx) {
-                    if (current_box_positions[box_idx] == box_initial_pos) {
+                    if (previous_box_positions[box_idx] == box_initial_pos) {
                         current_box_positions[box_idx] = box_final_pos;
                         break;
                     }
@@ -288,7 +1235,7 @@ FullConflict CBS::findFirstConflict(const std::vector<std::vector<const Action *
 
                 // Find and move the box
                 for (size_t box_idx = 0; box_idx < current_box_positions.size(); ++box_idx) {
-                    if (current_box_positions[box_idx] == box_initial_pos) {
+                    if (previous_box_positions[box_idx] == box_initial_pos) {
                         current_box_positions[box_idx] = box_final_pos;
                         break;
                     }
@@ -296,53 +1243,59 @@ FullConflict CBS::findFirstConflict(const std::vector<std::vector<const Action *
             }
         }
 
+        const size_t t = depth + 1;
+        auto group_of = [&](char symbol) { return agent_symbol_to_group_info_.at(symbol).first; };
+        auto relevant = [&](char symbol1, char symbol2) {
+            if (!mergeable_only) {
+                return true;
+            }
+            const StaticLevel &static_level = initial_level.static_level;
+            return static_level.getAgentColor(symbol1) == static_level.getAgentColor(symbol2) &&
+                   initial_agents_states_[group_of(symbol1)]->box_bulks.empty() &&
+                   initial_agents_states_[group_of(symbol2)]->box_bulks.empty();
+        };
+
         // 1. Agent-Agent Vertex conflicts
         for (size_t j = 0; j < solutions[0].size(); ++j) {
             for (size_t k = j + 1; k < solutions[0].size(); ++k) {
-                if (current_agent_positions[j] == current_agent_positions[k]) {
-                    return FullConflict(j + FIRST_AGENT, k + FIRST_AGENT, Constraint(current_agent_positions[j], depth + 1));
+                if (current_agent_positions[j] == current_agent_positions[k] && relevant(j + FIRST_AGENT, k + FIRST_AGENT)) {
+                    return FullConflict(j + FIRST_AGENT, k + FIRST_AGENT, Constraint(current_agent_positions[j], t));
                 }
             }
         }
 
-        // 2. Agent-Agent Follow/trailing conflicts
+        // 2. Agent-Agent Follow conflicts: the follower may not be there at t, the leader may not be there at t - 1
         for (size_t j = 0; j < solutions[0].size(); ++j) {
-            for (size_t k = j + 1; k < solutions[0].size(); ++k) {
-                if (previous_agent_positions[k] == current_agent_positions[j]) {
-                    return FullConflict(k + FIRST_AGENT, j + FIRST_AGENT, Constraint(current_agent_positions[j], depth + 1));
-                }
-                if (previous_agent_positions[j] == current_agent_positions[k]) {
-                    return FullConflict(j + FIRST_AGENT, k + FIRST_AGENT, Constraint(current_agent_positions[k], depth + 1));
+            for (size_t k = 0; k < solutions[0].size(); ++k) {
+                if (j != k && previous_agent_positions[k] == current_agent_positions[j] && relevant(j + FIRST_AGENT, k + FIRST_AGENT)) {
+                    const Cell2D &cell = current_agent_positions[j];
+                    return FullConflict(j + FIRST_AGENT, Constraint(cell, t), k + FIRST_AGENT, Constraint(cell, depth));
                 }
             }
         }
 
-        // 3. Box-Box Vertex conflicts
+        // 3. Box-Box Vertex conflicts, including boxes of other groups that did not move
         for (size_t j = 0; j < current_box_positions.size(); ++j) {
             for (size_t k = j + 1; k < current_box_positions.size(); ++k) {
-                if (current_box_positions[j] == current_box_positions[k]) {
-                    // Return conflict between the agents that moved these boxes
-                    // Note: We need to find which agents are responsible for these box movements
-                    size_t agent_j = findAgentResponsibleForBox(j, solutions[depth], previous_agent_positions, previous_box_positions);
-                    size_t agent_k = findAgentResponsibleForBox(k, solutions[depth], previous_agent_positions, previous_box_positions);
-                    if (agent_j != SIZE_MAX && agent_k != SIZE_MAX && agent_j != agent_k) {
-                        return FullConflict(agent_j + FIRST_AGENT, agent_k + FIRST_AGENT, Constraint(current_box_positions[j], depth + 1));
-                    }
+                const char owner_j = box_owner_symbols_[j];
+                const char owner_k = box_owner_symbols_[k];
+                if (current_box_positions[j] == current_box_positions[k] && owner_j && owner_k && group_of(owner_j) != group_of(owner_k) &&
+                    relevant(owner_j, owner_k)) {
+                    const Cell2D &cell = current_box_positions[j];
+                    return FullConflict(owner_j, Constraint::box(cell, t), owner_k, Constraint::box(cell, t));
                 }
             }
         }
 
-        // 4. Box-Box Follow conflicts
+        // 4. Box-Box Follow conflicts: box j moves into the cell box k left
         for (size_t j = 0; j < current_box_positions.size(); ++j) {
             for (size_t k = 0; k < current_box_positions.size(); ++k) {
-                if (j != k && previous_box_positions[k] == current_box_positions[j] &&
-                    previous_box_positions[j] == current_box_positions[k]) {
-                    // Box swap conflict
-                    size_t agent_j = findAgentResponsibleForBox(j, solutions[depth], previous_agent_positions, previous_box_positions);
-                    size_t agent_k = findAgentResponsibleForBox(k, solutions[depth], previous_agent_positions, previous_box_positions);
-                    if (agent_j != SIZE_MAX && agent_k != SIZE_MAX && agent_j != agent_k) {
-                        return FullConflict(agent_j + FIRST_AGENT, agent_k + FIRST_AGENT, Constraint(current_box_positions[j], depth + 1));
-                    }
+                const char owner_j = box_owner_symbols_[j];
+                const char owner_k = box_owner_symbols_[k];
+                if (j != k && previous_box_positions[k] == current_box_positions[j] && owner_j && owner_k &&
+                    group_of(owner_j) != group_of(owner_k) && relevant(owner_j, owner_k)) {
+                    const Cell2D &cell = current_box_positions[j];
+                    return FullConflict(owner_j, Constraint::box(cell, t), owner_k, Constraint::box(cell, depth));
                 }
             }
         }
@@ -350,24 +1303,29 @@ FullConflict CBS::findFirstConflict(const std::vector<std::vector<const Action *
         // 5. Agent-Box Vertex conflicts
         for (size_t j = 0; j < solutions[0].size(); ++j) {
             for (size_t k = 0; k < current_box_positions.size(); ++k) {
-                if (current_agent_positions[j] == current_box_positions[k]) {
-                    size_t agent_k = findAgentResponsibleForBox(k, solutions[depth], previous_agent_positions, previous_box_positions);
-                    if (agent_k != SIZE_MAX && j != agent_k) {
-                        return FullConflict(j + FIRST_AGENT, agent_k + FIRST_AGENT, Constraint(current_agent_positions[j], depth + 1));
-                    }
+                const char owner_k = box_owner_symbols_[k];
+                if (current_agent_positions[j] == current_box_positions[k] && owner_k && group_of(j + FIRST_AGENT) != group_of(owner_k) &&
+                    relevant(j + FIRST_AGENT, owner_k)) {
+                    const Cell2D &cell = current_agent_positions[j];
+                    return FullConflict(j + FIRST_AGENT, Constraint(cell, t), owner_k, Constraint::box(cell, t));
                 }
             }
         }
 
-        // 6. Agent-Box Follow conflicts
+        // 6. Agent-Box Follow conflicts, in both directions
         for (size_t j = 0; j < solutions[0].size(); ++j) {
             for (size_t k = 0; k < current_box_positions.size(); ++k) {
-                // Agent moving to where box was, box moving to where agent was
-                if (previous_box_positions[k] == current_agent_positions[j] && previous_agent_positions[j] == current_box_positions[k]) {
-                    size_t agent_k = findAgentResponsibleForBox(k, solutions[depth], previous_agent_positions, previous_box_positions);
-                    if (agent_k != SIZE_MAX && j != agent_k) {
-                        return FullConflict(j + FIRST_AGENT, agent_k + FIRST_AGENT, Constraint(current_agent_positions[j], depth + 1));
-                    }
+                const char owner_k = box_owner_symbols_[k];
+                if (!owner_k || group_of(j + FIRST_AGENT) == group_of(owner_k) || !relevant(j + FIRST_AGENT, owner_k)) {
+                    continue;
+                }
+                if (previous_box_positions[k] == current_agent_positions[j]) {
+                    const Cell2D &cell = current_agent_positions[j];
+                    return FullConflict(j + FIRST_AGENT, Constraint(cell, t), owner_k, Constraint::box(cell, depth));
+                }
+                if (previous_agent_positions[j] == current_box_positions[k]) {
+                    const Cell2D &cell = current_box_positions[k];
+                    return FullConflict(owner_k, Constraint::box(cell, t), j + FIRST_AGENT, Constraint(cell, depth));
                 }
             }
         }
@@ -0,0 +1,212 @@
+#include "constraint_table.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+ConstraintTable::ConstraintTable()
+    : horizon_(0),
+      last_goal_ban_(SIZE_MAX),
+      vertices_(),
+      boxes_(),
+      edges_(),
+      positive_vertices_(),
+      positive_boxes_(),
+      permanent_vertices_(),
+      landmarks_() {}
+
+void ConstraintTable::ensureHorizon(size_t t) {
+    if (t < horizon_) {
+        return;
+    }
+    horizon_ = t + 1;
+    vertices_.resize(horizon_);
+    boxes_.resize(horizon_);
+    edges_.resize(horizon_);
+    positive_vertices_.resize(horizon_);
+    positive_boxes_.resize(horizon_);
+}
+
+void ConstraintTable::build(const std::vector<Constraint> &constraints) {
+    horizon_ = 0;
+    last_goal_ban_ = SIZE_MAX;
+    vertices_.clear();
+    boxes_.clear();
+    edges_.clear();
+    positive_vertices_.clear();
+    positive_boxes_.clear();
+    permanent_vertices_.clear();
+    landmarks_.clear();
+
+    for (const auto &constraint : constraints) {
+        if (constraint.positive) {
+            landmarks_.push_back(constraint);
+        }
+        switch (constraint.type) {
+            case ConstraintType::Vertex:
+                ensureHorizon(constraint.g);
+                (constraint.positive ? positive_vertices_ : vertices_)[constraint.g].push_back(constraint.vertex);
+                break;
+            case ConstraintType::Box:
+                ensureHorizon(constraint.g);
+                (constraint.positive ? positive_boxes_ : boxes_)[constraint.g].push_back(constraint.vertex);
+                break;
+            case ConstraintType::Edge:
+                ensureHorizon(constraint.g);
+                edges_[constraint.g].emplace_back(constraint.from, constraint.vertex);
+                break;
+            case ConstraintType::Range:
+                if (constraint.g_end == Constraint::FOREVER) {
+                    ensureHorizon(constraint.g);
+                    permanent_vertices_.emplace_back(constraint.vertex, constraint.g);
+                    break;
+                }
+                ensureHorizon(constraint.g_end);
+                for (size_t t = constraint.g; t <= constraint.g_end; t++) {
+                    vertices_[t].push_back(constraint.vertex);
+                }
+                break;
+            case ConstraintType::Length:
+                ensureHorizon(constraint.g);
+                last_goal_ban_ = last_goal_ban_ == SIZE_MAX ? constraint.g : std::max(last_goal_ban_, constraint.g);
+                break;
+        }
+    }
+}
+
+bool ConstraintTable::hasAgentAt(const LowLevelState &state, const Cell2D &cell) {
+    for (const auto &agent : state.agents) {
+        if (agent.getPosition() == cell) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ConstraintTable::hasBoxAt(const LowLevelState &state, const Cell2D &cell) { return state.getBoxAt(cell) != 0; }
+
+bool ConstraintTable::isAllowed(const LowLevelState &state) const { return isAllowedAt(state, state.getG(), state.parent ? &state.parent->agents : nullptr);
+}
+
+bool ConstraintTable::isGoalAllowed(const LowLevelState &state) const { return isGoalAllowedAt(state, state.getG()); }
+
+bool ConstraintTable::isPlanAllowed(const LowLevelState &initial_state, const std::vector<std::vector<const Action *>> &plan) const {
+    LowLevelState state(initial_state);
+    if (!isAllowedAt(state, 0, nullptr)) {
+        return false;
+    }
+    for (size_t t = 0; t < plan.size(); t++) {
+        const std::vector<Agent> previous_agents = state.agents;
+        state.applyActions(plan[t]);
+        if (!isAllowedAt(state, t + 1, &previous_agents)) {
+            return false;
+        }
+    }
+    return isGoalAllowedAt(state, plan.size());
+}
+
+bool ConstraintTable::canReachLandmarks(const LowLevelState &state, size_t t) const {
+    auto manhattan = [](const Cell2D &a, const Cell2D &b) { return size_t(std::abs(a.r - b.r) + std::abs(a.c - b.c)); };
+    for (const auto &landmark : landmarks_) {
+        if (landmark.g <= t) {
+            continue;
+        }
+        const size_t time_left = landmark.g - t;
+        bool reachable = false;
+        if (landmark.type == ConstraintType::Box) {
+            for (const auto &bulk : state.box_bulks) {
+                for (size_t i = 0; i < bulk.size() && !reachable; i++) {
+                    reachable = manhattan(bulk.getPosition(i), landmark.vertex) <= time_left;
+                }
+            }
+        } else {
+            for (const auto &agent : state.agents) {
+                reachable |= manhattan(agent.getPosition(), landmark.vertex) <= time_left;
+            }
+        }
+        if (!reachable) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ConstraintTable::isAllowedAt(const LowLevelState &state, size_t t, const std::vector<Agent> *previous_agents) const {
+    for (const auto &[cell, from] : permanent_vertices_) {
+        if (t >= from && hasAgentAt(state, cell)) {
+            return false;
+        }
+    }
+    if (t >= horizon_) {
+        return true;
+    }
+    if (!landmarks_.empty() && !canReachLandmarks(state, t)) {
+        return false;
+    }
+
+    for (const auto &cell : vertices_[t]) {
+        if (hasAgentAt(state, cell)) {
+            return false;
+        }
+    }
+    for (const auto &cell : boxes_[t]) {
+        if (hasBoxAt(state, cell)) {
+            return false;
+        }
+    }
+    if (previous_agents) {
+        for (const auto &[from, to] : edges_[t]) {
+            for (size_t i = 0; i < state.agents.size(); i++) {
+                if ((*previous_agents)[i].getPosition() == from && state.agents[i].getPosition() == to) {
+                    return false;
+                }
+            }
+        }
+    }
+    for (const auto &cell : positive_vertices_[t]) {
+        if (!hasAgentAt(state, cell)) {
+            return false;
+        }
+    }
+    for (const auto &cell : positive_boxes_[t]) {
+        if (!hasBoxAt(state, cell)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ConstraintTable::isGoalAllowedAt(const LowLevelState &state, size_t g) const {
+    if (last_goal_ban_ != SIZE_MAX && g <= last_goal_ban_) {
+        return false;
+    }
+    for (const auto &[cell, from] : permanent_vertices_) {
+        if (hasAgentAt(state, cell)) {
+            return false;
+        }
+    }
+
+    // Edge constraints cannot be violated while standing still
+    for (size_t t = g; t < horizon_; t++) {
+        for (const auto &cell : vertices_[t]) {
+            if (hasAgentAt(state, cell)) {
+                return false;
+            }
+        }
+        for (const auto &cell : boxes_[t]) {
+            if (hasBoxAt(state, cell)) {
+                return false;
+            }
+        }
+        for (const auto &cell : positive_vertices_[t]) {
+            if (!hasAgentAt(state, cell)) {
+                return false;
+            }
+        }
+        for (const auto &cell : positive_boxes_[t]) {
+            if (!hasBoxAt(state, cell)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,108 @@
+#include "heuristic.hpp"
+
+#include <algorithm>
+
+// Row of the matching for a box on `position`: true distances to the goals, then the free columns
+static std::vector<long long> boxCosts(const std::vector<std::vector<size_t>> &goal_distances, size_t size, size_t cols,
+                                       const Cell2D &position) {
+    std::vector<long long> costs(size, 0);
+    for (size_t goal_idx = 0; goal_idx < goal_distances.size(); goal_idx++) {
+        const size_t distance = goal_distances[goal_idx][position.r * cols + position.c];
+        // Boxes walled off from a goal are matched elsewhere whenever possible. The matching stays a lower bound: its
+        // cost is at most that of any matching of reachable pairs, and without one the state is dead.
+        costs[goal_idx] = distance == SIZE_MAX ? (long long)goal_distances[goal_idx].size() : (long long)distance;
+    }
+    return costs;
+}
+
+HeuristicAStar::BulkMatching::BulkMatching(const StaticLevel &static_level, const BoxBulk &bulk)
+    : goals(bulk.getGoals()),
+      goal_distances(),
+      positions(bulk.getPositions()),
+      assignment(std::max(bulk.size(), goals.size())),
+      scratch(assignment.size()) {
+    goal_distances.reserve(goals.size());
+    for (const auto &goal : goals) {
+        goal_distances.push_back(static_level.computeDistances(goal));
+    }
+    const size_t cols = static_level.getSize().c;
+    for (size_t i = 0; i < positions.size(); i++) {
+        assignment.setRow(i, boxCosts(goal_distances, assignment.size(), cols, positions[i]));
+    }
+    assignment.solve();
+}
+
+const Assignment &HeuristicAStar::matchBoxes(const LowLevelState &state, size_t bulk_idx) const {
+    const BoxBulk &bulk = state.box_bulks[bulk_idx];
+    const StaticLevel &static_level = state.getStaticLevel();
+    while (matchings_.size() <= bulk_idx) {
+        matchings_.emplace_back(static_level, state.box_bulks[matchings_.size()]);
+    }
+    if (matchings_[bulk_idx].goals != bulk.getGoals() || matchings_[bulk_idx].positions.size() != bulk.size()) {
+        matchings_[bulk_idx] = BulkMatching(static_level, bulk);
+    }
+    BulkMatching &matching = matchings_[bulk_idx];
+    const size_t cols = static_level.getSize().c;
+
+    auto moved_boxes = [&](const std::vector<Cell2D> &positions) {
+        std::vector<size_t> moved;
+        for (size_t i = 0; i < positions.size(); i++) {
+            if (positions[i] != matching.positions[i]) {
+                moved.push_back(i);
+            }
+        }
+        return moved;
+    };
+
+    auto moved = moved_boxes(bulk.getPositions());
+    if (moved.size() > 1) {
+        // Re-base on the parent when this state is one box move away from it, so the parent's
+        // other children are cheap as well
+        const std::vector<Cell2D> *base = &bulk.getPositions();
+        if (state.parent && state.parent->box_bulks.size() == state.box_bulks.size()) {
+            const auto &parent_positions = state.parent->box_bulks[bulk_idx].getPositions();
+            size_t differences = 0;
+            for (size_t i = 0; i < parent_positions.size(); i++) {
+                differences += parent_positions[i] != bulk.getPosition(i);
+            }
+            if (differences <= 1) {
+                base = &parent_positions;
+            }
+        }
+        for (size_t i : moved_boxes(*base)) {
+            matching.assignment.setRow(i, boxCosts(matching.goal_distances, matching.assignment.size(), cols, (*base)[i]));
+        }
+        matching.assignment.solve();
+        matching.positions = *base;
+        moved = moved_boxes(bulk.getPositions());
+    }
+    if (moved.empty()) {
+        return matching.assignment;
+    }
+
+    matching.scratch = matching.assignment;
+    matching.scratch.setRow(moved[0], boxCosts(matching.goal_distances, matching.assignment.size(), cols, bulk.getPosition(moved[0])));
+    matching.scratch.solve();
+    return matching.scratch;
+}
+
+size_t HeuristicAStar::walkingDistance(const StaticLevel &static_level, const Cell2D &from, const Cell2D &to) const {
+#ifdef USE_HIERARCHICAL_HEURISTIC
+    const HierarchicalMap &hierarchy = static_level.getHierarchy();
+    // Within a cluster's reach walls rarely force long detours, and Manhattan spares a local BFS
+    if (abstract_distances_ && !hierarchy.empty() && manhattanDistance(from, to) > HierarchicalMap::CLUSTER_SIZE) {
+        const size_t key = to.r * static_level.getSize().c + to.c;
+        auto cached = portal_distances_.find(key);
+        if (cached == portal_distances_.end()) {
+            cached = portal_distances_.emplace(key, hierarchy.computePortalDistances(to)).first;
+        }
+        const size_t distance = hierarchy.getDistance(cached->second, from, to);
+        if (distance != SIZE_MAX) {
+            return distance;
+        }
+    }
+#else
+    (void)static_level;
+#endif
+    return manhattanDistance(from, to);
+}
@@ -0,0 +1,200 @@
+#include "hierarchical_map.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+HierarchicalMap::HierarchicalMap(size_t rows, size_t cols, const std::vector<bool> &free_cells, size_t cluster_size)
+    : rows_(rows),
+      cols_(cols),
+      free_(free_cells),
+      cluster_size_(cluster_size),
+      cluster_cols_((cols + cluster_size - 1) / cluster_size),
+      portals_(),
+      cluster_portals_(((rows + cluster_size - 1) / cluster_size) * cluster_cols_),
+      portal_at_(rows * cols, SIZE_MAX) {
+    // Entrances along the east and south border of every cluster
+    for (size_t r0 = 0; r0 < rows_; r0 += cluster_size_) {
+        for (size_t c0 = 0; c0 < cols_; c0 += cluster_size_) {
+            const size_t height = std::min(cluster_size_, rows_ - r0), width = std::min(cluster_size_, cols_ - c0);
+            if (c0 + width < cols_) {
+                addEntrances(Cell2D(r0, c0 + width - 1), Cell2D(1, 0), Cell2D(0, 1), height);
+            }
+            if (r0 + height < rows_) {
+                addEntrances(Cell2D(r0 + height - 1, c0), Cell2D(0, 1), Cell2D(1, 0), width);
+            }
+        }
+    }
+
+    // Cached distances between the portals of each cluster
+    for (auto &portal : portals_) {
+        portal.local_distances = searchCluster(portal.cell);
+        for (size_t other : cluster_portals_[portal.cluster]) {
+            const size_t distance = portal.local_distances[localIndex(portals_[other].cell)];
+            if (portals_[other].cell != portal.cell && distance != SIZE_MAX) {
+                portal.edges.emplace_back(other, distance);
+            }
+        }
+    }
+}
+
+size_t HierarchicalMap::addPortal(const Cell2D &cell) {
+    size_t &portal_idx = portal_at_[cell.r * cols_ + cell.c];
+    if (portal_idx == SIZE_MAX) {
+        portal_idx = portals_.size();
+        portals_.emplace_back(cell, clusterOf(cell));
+        cluster_portals_[clusterOf(cell)].push_back(portal_idx);
+    }
+    return portal_idx;
+}
+
+void HierarchicalMap::addEntrances(const Cell2D &first, const Cell2D &step, const Cell2D &across, size_t length) {
+    auto connect = [&](const Cell2D &cell) {
+        const size_t inside = addPortal(cell), outside = addPortal(cell + across);
+        portals_[inside].edges.emplace_back(outside, 1);
+        portals_[outside].edges.emplace_back(inside, 1);
+    };
+    // Split the border into runs of cells that are free on both sides
+    std::vector<Cell2D> run;
+    Cell2D cell = first;
+    for (size_t i = 0; i <= length; i++, cell += step) {
+        if (i < length && isFree(cell) && isFree(cell + across)) {
+            run.push_back(cell);
+            continue;
+        }
+        if (run.size() >= WIDE_ENTRANCE) {
+            connect(run.front());
+            connect(run.back());
+        } else if (!run.empty()) {
+            connect(run[run.size() / 2]);
+        }
+        run.clear();
+    }
+}
+
+std::vector<size_t> HierarchicalMap::searchCluster(const Cell2D &from, std::vector<Cell2D> *parents) const {
+    const size_t cluster = clusterOf(from);
+    std::vector<size_t> distances(cluster_size_ * cluster_size_, SIZE_MAX);
+    if (parents) {
+        parents->assign(distances.size(), from);
+    }
+    std::queue<Cell2D> queue;
+    distances[localIndex(from)] = 0;
+    queue.push(from);
+    while (!queue.empty()) {
+        const Cell2D cell = queue.front();
+        queue.pop();
+        for (const Cell2D &next : {Cell2D(cell.r - 1, cell.c), Cell2D(cell.r + 1, cell.c), Cell2D(cell.r, cell.c - 1),
+                                   Cell2D(cell.r, cell.c + 1)}) {
+            if (!isFree(next) || clusterOf(next) != cluster || distances[localIndex(next)] != SIZE_MAX) {
+                continue;
+            }
+            distances[localIndex(next)] = distances[localIndex(cell)] + 1;
+            if (parents) {
+                (*parents)[localIndex(next)] = cell;
+            }
+            queue.push(next);
+        }
+    }
+    return distances;
+}
+
+void HierarchicalMap::appendLocalPath(const Cell2D &from, const Cell2D &to, std::vector<Cell2D> &path) const {
+    std::vector<Cell2D> parents;
+    searchCluster(to, &parents);
+    // Parents lead back to `to`, so walking them from `from` gives the path in order
+    for (Cell2D cell = from; cell != to;) {
+        cell = parents[localIndex(cell)];
+        path.push_back(cell);
+    }
+}
+
+std::vector<size_t> HierarchicalMap::computePortalDistances(const Cell2D &to) const {
+    using Entry = std::pair<size_t, size_t>;  // (distance, portal)
+    std::vector<size_t> distances(portals_.size(), SIZE_MAX);
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    if (!isFree(to)) {
+        return distances;
+    }
+    for (size_t portal_idx : cluster_portals_[clusterOf(to)]) {
+        const size_t distance = portals_[portal_idx].local_distances[localIndex(to)];
+        if (distance != SIZE_MAX) {
+            distances[portal_idx] = distance;
+            queue.emplace(distance, portal_idx);
+        }
+    }
+    while (!queue.empty()) {
+        const auto [distance, portal_idx] = queue.top();
+        queue.pop();
+        if (distance > distances[portal_idx]) {
+            continue;
+        }
+        // Edges are symmetric, so distances from the neighbours to `to` relax the same way
+        for (const auto &[next, cost] : portals_[portal_idx].edges) {
+            if (distance + cost < distances[next]) {
+                distances[next] = distance + cost;
+                queue.emplace(distances[next], next);
+            }
+        }
+    }
+    return distances;
+}
+
+size_t HierarchicalMap::getDistance(const std::vector<size_t> &portal_distances, const Cell2D &from, const Cell2D &to) const {
+    if (!isFree(from) || !isFree(to)) {
+        return SIZE_MAX;
+    }
+    size_t best = SIZE_MAX;
+    if (clusterOf(from) == clusterOf(to)) {
+        best = searchCluster(from)[localIndex(to)];
+    }
+    for (size_t portal_idx : cluster_portals_[clusterOf(from)]) {
+        const size_t to_portal = portals_[portal_idx].local_distances[localIndex(from)];
+        if (to_portal != SIZE_MAX && portal_distances[portal_idx] != SIZE_MAX) {
+            best = std::min(best, to_portal + portal_distances[portal_idx]);
+        }
+    }
+    return best;
+}
+
+std::vector<Cell2D> HierarchicalMap::findPath(const Cell2D &from, const Cell2D &to) const {
+    const auto portal_distances = computePortalDistances(to);
+    const size_t distance = getDistance(portal_distances, from, to);
+    if (distance == SIZE_MAX) {
+        return {};
+    }
+    std::vector<Cell2D> path = {from};
+    if (clusterOf(from) == clusterOf(to) && searchCluster(from)[localIndex(to)] == distance) {
+        appendLocalPath(from, to, path);
+        return path;
+    }
+
+    // Enter the portal graph where getDistance did, then follow edges that keep the remaining distance tight
+    size_t current = SIZE_MAX;
+    for (size_t portal_idx : cluster_portals_[clusterOf(from)]) {
+        const size_t to_portal = portals_[portal_idx].local_distances[localIndex(from)];
+        if (to_portal != SIZE_MAX && portal_distances[portal_idx] != SIZE_MAX && to_portal + portal_distances[portal_idx] == distance) {
+            current = portal_idx;
+            break;
+        }
+    }
+    appendLocalPath(from, portals_[current].cell, path);
+    while (true) {
+        const Portal &portal = portals_[current];
+        if (portal.cluster == clusterOf(to) && portal.local_distances[localIndex(to)] == portal_distances[current]) {
+            appendLocalPath(portal.cell, to, path);
+            return path;
+        }
+        for (const auto &[next, cost] : portal.edges) {
+            if (portal_distances[next] != SIZE_MAX && cost + portal_distances[next] == portal_distances[current]) {
+                if (portals_[next].cluster == portal.cluster) {
+                    appendLocalPath(portal.cell, portals_[next].cell, path);
+                } else {
+                    path.push_back(portals_[next].cell);  // Stepping over the border
+                }
+                current = next;
+                break;
+            }
+        }
+    }
+}
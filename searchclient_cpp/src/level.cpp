@@ -1,16 +1,124 @@
 #include "level.hpp"
 
+#include <algorithm>
+#include <array>
+#include <deque>
 #include <iostream>
+#include <limits>
+#include <queue>
 #include <set>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "utils.hpp"
 
 StaticLevel::StaticLevel(std::string name, std::string domain, CharGrid walls, std::map<char, Color> agent_colors,
-                         std::map<char, Color> box_colors)
-    : name_(name), domain_(domain), walls_(walls), agent_colors_(agent_colors), box_colors_(box_colors) {}
+                         std::map<char, Color> box_colors, bool analyse)
+    : name_(name),
+      domain_(domain),
+      walls_(walls),
+      agent_colors_(agent_colors),
+      box_colors_(box_colors),
+      dead_squares_(LAST_BOX - FIRST_BOX + 1),
+      corridor_share_(0),
+      segments_(),
+      segment_of_(walls_.size_rows() * walls_.size_cols(), SIZE_MAX),
+      hierarchy_() {
+    if (!analyse) {
+        return;
+    }
+    size_t free_count = 0, corridor_count = 0;
+    for (size_t r = 1; r + 1 < walls_.size_rows(); r++) {
+        for (size_t c = 1; c + 1 < walls_.size_cols(); c++) {
+            if (!isCellFree(Cell2D(r, c))) {
+                continue;
+            }
+            const int free_neighbours = isCellFree(Cell2D(r - 1, c)) + isCellFree(Cell2D(r + 1, c)) + isCellFree(Cell2D(r, c - 1)) +
+                                        isCellFree(Cell2D(r, c + 1));
+            free_count++;
+            corridor_count += free_neighbours <= 2;
+        }
+    }
+    corridor_share_ = free_count ? double(corridor_count) / free_count : 0;
+    buildCorridorGraph();
+
+    if (walls_.size_rows() * walls_.size_cols() >= HIERARCHY_MIN_CELLS) {
+        std::vector<bool> free_cells(walls_.size_rows() * walls_.size_cols());
+        for (size_t i = 0; i < free_cells.size(); i++) {
+            free_cells[i] = walls_.data[i] != WALL;
+        }
+        hierarchy_ = HierarchicalMap(walls_.size_rows(), walls_.size_cols(), free_cells);
+    }
+}
+
+void StaticLevel::buildCorridorGraph() {
+    const size_t rows = walls_.size_rows(), cols = walls_.size_cols();
+    auto freeNeighbours = [&](const Cell2D &cell) {
+        std::vector<Cell2D> neighbours;
+        for (const Cell2D &next : {Cell2D(cell.r - 1, cell.c), Cell2D(cell.r + 1, cell.c), Cell2D(cell.r, cell.c - 1),
+                                   Cell2D(cell.r, cell.c + 1)}) {
+            if (isCellFree(next)) {
+                neighbours.push_back(next);
+            }
+        }
+        return neighbours;
+    };
+    // Room corners have two free neighbours as well, but those touch each other diagonally
+    auto isCorridor = [&](const Cell2D &cell) {
+        const bool interior = cell.r > 0 && cell.c > 0 && cell.r + 1u < rows && cell.c + 1u < cols;
+        if (!interior || !isCellFree(cell)) {
+            return false;
+        }
+        const auto neighbours = freeNeighbours(cell);
+        if (neighbours.size() != 2) {
+            return false;
+        }
+        const Cell2D diagonal = neighbours[0] + neighbours[1] - cell;
+        return diagonal == cell || !isCellFree(diagonal);
+    };
+
+    std::vector<bool> visited(rows * cols, false);
+    for (size_t r = 1; r + 1 < rows; r++) {
+        for (size_t c = 1; c + 1 < cols; c++) {
+            const Cell2D start(r, c);
+            if (visited[r * cols + c] || !isCorridor(start)) {
+                continue;
+            }
+            // Follow the chain out of `start` on both sides until it leaves the corridor
+            std::deque<Cell2D> chain = {start};
+            CorridorSegment segment;
+            bool is_loop = false;
+            const auto start_neighbours = freeNeighbours(start);
+            for (size_t side = 0; side < 2 && !is_loop; side++) {
+                Cell2D previous = start;
+                Cell2D current = start_neighbours[side];
+                while (isCorridor(current) && current != start) {
+                    side == 0 ? chain.push_front(current) : chain.push_back(current);
+                    const auto neighbours = freeNeighbours(current);
+                    const Cell2D next = neighbours[0] == previous ? neighbours[1] : neighbours[0];
+                    previous = current;
+                    current = next;
+                }
+                is_loop = current == start;
+                segment.ends[side] = current;
+            }
+            for (const auto &cell : chain) {
+                visited[cell.r * cols + cell.c] = true;
+            }
+            if (is_loop) {
+                continue;  // A ring without junctions has nowhere to lead
+            }
+            segment.cells.assign(chain.begin(), chain.end());
+            for (const auto &cell : segment.cells) {
+                segment_of_[cell.r * cols + cell.c] = segments_.size();
+            }
+            segments_.push_back(std::move(segment));
+        }
+    }
+}
 
 bool StaticLevel::isCellFree(const Cell2D &cell) const {
     // if (cell.r < 0 || cell.r >= walls.size_rows() || cell.c < 0 || cell.c >= walls.size_cols()) {
@@ -22,6 +130,114 @@ bool StaticLevel::isCellFree(const Cell2D &cell) const {
     return true;
 }
 
+std::vector<size_t> StaticLevel::computeDistances(const Cell2D &from) const {
+    const size_t cols = walls_.size_cols();
+    std::vector<size_t> distances(walls_.size_rows() * cols, SIZE_MAX);
+    std::queue<Cell2D> queue;
+    distances[from.r * cols + from.c] = 0;
+    queue.push(from);
+    while (!queue.empty()) {
+        const Cell2D cell = queue.front();
+        queue.pop();
+        for (const Cell2D &next : {Cell2D(cell.r - 1, cell.c), Cell2D(cell.r + 1, cell.c), Cell2D(cell.r, cell.c - 1),
+                                   Cell2D(cell.r, cell.c + 1)}) {
+            if (isCellFree(next) && distances[next.r * cols + next.c] == SIZE_MAX) {
+                distances[next.r * cols + next.c] = distances[cell.r * cols + cell.c] + 1;
+                queue.push(next);
+            }
+        }
+    }
+    return distances;
+}
+
+std::vector<bool> StaticLevel::computeLiveSquares(const std::vector<Cell2D> &goals, bool allow_pulls) const {
+    const size_t cols = walls_.size_cols();
+    std::vector<bool> live(walls_.size_rows() * cols, false);
+    std::queue<Cell2D> queue;
+    for (const auto &goal : goals) {
+        live[goal.r * cols + goal.c] = true;
+        queue.push(goal);
+    }
+
+    auto neighbours = [](const Cell2D &cell) {
+        return std::array<Cell2D, 4>{Cell2D(cell.r - 1, cell.c), Cell2D(cell.r + 1, cell.c), Cell2D(cell.r, cell.c - 1), Cell2D(cell.r, cell.c + 1)};
+    };
+    // Some free neighbour of `cell` other than `excluded`
+    auto hasFreeNeighbour = [&](const Cell2D &cell, const Cell2D &excluded) {
+        for (const auto &neighbour : neighbours(cell)) {
+            if (neighbour != excluded && isCellFree(neighbour)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Backwards from the goals: the box moves from `from` onto the live cell `to`
+    while (!queue.empty()) {
+        const Cell2D to = queue.front();
+        queue.pop();
+        for (const auto &from : neighbours(to)) {
+            if (!isCellFree(from) || live[from.r * cols + from.c]) {
+                continue;
+            }
+            // Pushed by an agent on another side of `from`, or pulled by an agent leaving `to` on another side
+            if (hasFreeNeighbour(from, to) || (allow_pulls && hasFreeNeighbour(to, from))) {
+                live[from.r * cols + from.c] = true;
+                queue.push(from);
+            }
+        }
+    }
+    return live;
+}
+
+std::pair<size_t, size_t> StaticLevel::computeDeadSquares(const std::vector<BoxBulk> &boxes) {
+    std::map<char, std::vector<Cell2D>> goals;
+    std::map<char, size_t> boxes_count;
+    for (const auto &bulk : boxes) {
+        goals[bulk.getSymbol()].insert(goals[bulk.getSymbol()].end(), bulk.getGoals().begin(), bulk.getGoals().end());
+        boxes_count[bulk.getSymbol()] += bulk.size();
+    }
+
+    const size_t cols = walls_.size_cols();
+    size_t dead_count = 0, push_dead_count = 0;
+    for (auto &[symbol, letter_goals] : goals) {
+        std::sort(letter_goals.begin(), letter_goals.end());
+        letter_goals.erase(std::unique(letter_goals.begin(), letter_goals.end()), letter_goals.end());
+        if (letter_goals.empty() || boxes_count[symbol] > letter_goals.size()) {
+            continue;
+        }
+
+        const auto live = computeLiveSquares(letter_goals, true);
+        const auto push_live = computeLiveSquares(letter_goals, false);
+        // Cells walled off from every goal are dead trivially and left out of the counts
+        std::vector<bool> connected(live.size(), false);
+        for (const auto &goal : letter_goals) {
+            if (connected[goal.r * cols + goal.c]) {
+                continue;
+            }
+            const auto distances = computeDistances(goal);
+            for (size_t i = 0; i < distances.size(); i++) {
+                connected[i] = connected[i] || distances[i] != SIZE_MAX;
+            }
+        }
+
+        auto &dead = dead_squares_[symbol - FIRST_BOX];
+        dead.assign(live.size(), false);
+        for (size_t r = 0; r < walls_.size_rows(); r++) {
+            for (size_t c = 0; c < cols; c++) {
+                const size_t idx = r * cols + c;
+                if (!isCellFree(Cell2D(r, c))) {
+                    continue;
+                }
+                dead[idx] = !live[idx];
+                dead_count += connected[idx] && !live[idx];
+                push_dead_count += connected[idx] && !push_live[idx];
+            }
+        }
+    }
+    return {dead_count, push_dead_count};
+}
+
 std::string StaticLevel::toString() const {
     std::stringstream ss;
     ss << domain_ << ", " << name_ << ", " << walls_.size_rows() << "x" << walls_.size_cols();
@@ -32,7 +248,7 @@ std::string StaticLevel::toString() const {
 Color StaticLevel::getAgentColor(const char &agent_symbol) const { return agent_colors_.at(agent_symbol); }
 
 Level::Level(StaticLevel static_level, const std::vector<Agent> &agents, const std::vector<BoxBulk> &boxes)
-    : static_level(static_level), agents(agents), boxes(boxes) {}
+    : static_level(std::move(static_level)), agents(agents), boxes(boxes) {}
 
 std::string Level::toString() const {
     std::stringstream ss;
@@ -40,180 +256,240 @@ std::string Level::toString() const {
     return ss.str();
 }
 
-Level loadLevel(std::istream &serverMessages) {
-    // Read domain (skip)
-    std::string line;
-    getline(serverMessages, line);  // #domain
-    assert(line == "#domain");
-    getline(serverMessages, line);  // hospital
-    std::string domain = line;
+// Cuts the next line off the front of `text`, without its line break. False once the text is used up.
+static bool nextLine(std::string_view &text, std::string_view &line) {
+    if (text.empty()) {
+        return false;
+    }
+    const size_t end = text.find('\n');
+    line = text.substr(0, end);
+    text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    return true;
+}
 
-    // Read level name (skip)
-    getline(serverMessages, line);  // #levelname
-    assert(line == "#levelname");
-    getline(serverMessages, line);  // <name>
-    std::string name = line;
+static std::string_view trimView(std::string_view text) {
+    const size_t first = text.find_first_not_of(utils::whitespaces);
+    if (first == std::string_view::npos) {
+        return std::string_view();
+    }
+    return text.substr(first, text.find_last_not_of(utils::whitespaces) - first + 1);
+}
 
-    // Read colors
-    getline(serverMessages, line);  // #colors
-    assert(line == "#colors");
-    getline(serverMessages, line);
+[[noreturn]] static void malformed(const std::string &reason) { throw std::invalid_argument("Malformed level: " + reason); }
 
-    std::vector<std::string> colorSection;
-    colorSection.reserve(10);
-    while (line.find("#") == std::string::npos) {
-        colorSection.push_back(utils::trim(line));
-        getline(serverMessages, line);
+static std::string_view readLine(std::string_view &text) {
+    std::string_view line;
+    if (!nextLine(text, line)) {
+        malformed("unexpected end of input");
     }
+    return line;
+}
 
-    std::map<char, Color> agent_colors;
-    std::map<char, Color> box_colors;
-
-    for (const std::string &line : colorSection) {
-        std::string colorStr, entitiesStr;
-        std::stringstream ss(line);
+static void expectLine(std::string_view &text, std::string_view expected) {
+    if (readLine(text) != expected) {
+        malformed("expected " + std::string(expected));
+    }
+}
 
-        getline(ss, colorStr, ':');
-        getline(ss, entitiesStr);
+// Reads the lines of a grid section up to the next section header, which is returned in `header`
+static std::vector<std::string_view> readSection(std::string_view &text, std::string_view &header) {
+    std::vector<std::string_view> lines;
+    while (nextLine(text, header)) {
+        if (!header.empty() && header[0] == '#') {
+            return lines;
+        }
+        lines.push_back(header);
+    }
+    malformed("unexpected end of input");
+}
 
-        const Color color = from_string(colorStr);
+ParsedLevel parseLevelText(std::string_view text) {
+    expectLine(text, "#domain");
+    const std::string domain(readLine(text));
+    expectLine(text, "#levelname");
+    const std::string name(readLine(text));
+    expectLine(text, "#colors");
 
-        // Reads agents, colors with ids and box, colors with ids with unnormilized whitespaces
-        std::stringstream entitiesStream(entitiesStr);
-        std::string entity;
-        while (getline(entitiesStream, entity, ',')) {
-            entity = utils::normalizeWhitespace(entity);
-            entity = utils::trim(entity);
-            if (entity.length() != 1) {
+    // Colors, e.g. "red: 0, A, B"
+    std::map<char, Color> agent_colors;
+    std::map<char, Color> box_colors;
+    std::string_view line;
+    while (nextLine(text, line) && (line.empty() || line[0] != '#')) {
+        const size_t colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            malformed("color line without ':'");
+        }
+        const Color color = from_string(std::string(trimView(line.substr(0, colon))));
+        std::string_view entities = line.substr(colon + 1);
+        while (!entities.empty()) {
+            const size_t comma = entities.find(',');
+            const std::string_view entity = trimView(entities.substr(0, comma));
+            entities.remove_prefix(comma == std::string_view::npos ? entities.size() : comma + 1);
+            if (entity.empty()) {
                 continue;
             }
-
-            const char entityChar = entity[0];
-            if (FIRST_AGENT <= entityChar && entityChar <= LAST_AGENT) {
-                agent_colors.insert({entityChar, color});
-                continue;
+            const char symbol = entity[0];
+            if (entity.size() != 1 || !((FIRST_AGENT <= symbol && symbol <= LAST_AGENT) || (FIRST_BOX <= symbol && symbol <= LAST_BOX))) {
+                malformed("unknown entity in colors: " + std::string(entity));
             }
-
-            if (FIRST_BOX <= entityChar && entityChar <= LAST_BOX) {
-                box_colors.insert({entityChar, color});
-                continue;
+            auto &colors = symbol <= LAST_AGENT ? agent_colors : box_colors;
+            if (!colors.emplace(symbol, color).second) {
+                malformed(std::string("color given twice for ") + symbol);
             }
         }
     }
-
-    // Read initial state
-    std::vector<std::string> levelLines;
-    levelLines.reserve(100);
-
-    getline(serverMessages, line);
-    while (line.find("#") == std::string::npos) {
-        levelLines.push_back(line);
-        getline(serverMessages, line);
+    if (line != "#initial") {
+        malformed("expected #initial");
     }
 
-    const size_t numRows = levelLines.size();
-    const size_t numCols = std::max_element(levelLines.begin(), levelLines.end(), [](const std::string &a, const std::string &b) {
-                               return a.length() < b.length();
-                           })->length();
-
-    CharGrid walls(numRows, numCols);
-    // Level::box_goals = CharGrid(numRows, numCols);
-    // std::vector<Cell2D> agents(LAST_AGENT - FIRST_AGENT + 1);
-    std::vector<Agent> agents;
-    agents.reserve(LAST_AGENT - FIRST_AGENT + 1);
+    std::string_view header;
+    const std::vector<std::string_view> initial_lines = readSection(text, header);
+    if (header != "#goal") {
+        malformed("expected #goal");
+    }
+    const std::vector<std::string_view> goal_lines = readSection(text, header);
+    if (header != "#end") {
+        malformed("expected #end");
+    }
+    if (initial_lines.empty()) {
+        malformed("empty initial state");
+    }
 
-    std::map<char, Cell2D> agent_positions;
-    std::map<char, std::vector<Cell2D>> agent_goals;
-    std::map<char, std::vector<Cell2D>> box_positions;
-    std::map<char, std::vector<Cell2D>> box_goals;
+    const size_t num_rows = initial_lines.size();
+    size_t num_cols = 0;
+    for (const auto &row : initial_lines) {
+        num_cols = std::max(num_cols, row.size());
+    }
+    // Cell2D coordinates are one byte wide
+    if (num_rows > std::numeric_limits<decltype(Cell2D::r)>::max() || num_cols > std::numeric_limits<decltype(Cell2D::c)>::max()) {
+        malformed("levels are limited to " + std::to_string(std::numeric_limits<decltype(Cell2D::r)>::max()) + " rows and columns");
+    }
+    if (goal_lines.size() > num_rows) {
+        malformed("goal state has more rows than the initial state");
+    }
 
-    for (size_t row = 0; row < numRows; row++) {
-        const std::string &line = levelLines[row];
-        for (size_t col = 0; col < line.length(); col++) {
-            const char c = line[col];
+    CharGrid walls(num_rows, num_cols);
+    constexpr size_t agent_count = LAST_AGENT - FIRST_AGENT + 1, box_letters = LAST_BOX - FIRST_BOX + 1;
+    std::array<Cell2D, agent_count> agent_positions;
+    std::array<bool, agent_count> agent_found{};
+    std::array<std::vector<Cell2D>, agent_count> agent_goals;
+    std::array<std::vector<Cell2D>, box_letters> box_positions;
+    std::array<std::vector<Cell2D>, box_letters> box_goals;
+
+    for (size_t row = 0; row < num_rows; row++) {
+        for (size_t col = 0; col < initial_lines[row].size(); col++) {
+            const char c = initial_lines[row][col];
             if (FIRST_AGENT <= c && c <= LAST_AGENT) {
-                agent_positions[c] = Cell2D(row, col);
-                continue;
-            }
-            if (FIRST_BOX <= c && c <= LAST_BOX) {
-                box_positions[c].push_back(Cell2D(row, col));
-                continue;
-            }
-            if (c == WALL) {
+                if (agent_found[c - FIRST_AGENT] || agent_colors.find(c) == agent_colors.end()) {
+                    malformed(std::string("agent placed twice or without a color: ") + c);
+                }
+                agent_found[c - FIRST_AGENT] = true;
+                agent_positions[c - FIRST_AGENT] = Cell2D(row, col);
+            } else if (FIRST_BOX <= c && c <= LAST_BOX) {
+                if (box_colors.find(c) == box_colors.end()) {
+                    malformed(std::string("box without a color: ") + c);
+                }
+                box_positions[c - FIRST_BOX].emplace_back(row, col);
+            } else if (c == WALL) {
                 walls(row, col) = c;
-                continue;
+            } else if (c != EMPTY) {
+                malformed(std::string("unknown character in initial state: ") + c);
             }
-            if (c == EMPTY) {
-                continue;
-            }
-
-            fprintf(stderr, "Unknown character while reading initial state: %c\n", c);
         }
     }
 
-    // Read goal state
-    std::vector<std::string> goalLines;
-    getline(serverMessages, line);  // first line of goal state
-    while (line.find("#") == std::string::npos) {
-        goalLines.push_back(line);
-        getline(serverMessages, line);
-    }
-
-    for (size_t row = 0; row < numRows; row++) {
-        const std::string &line = goalLines[row];
-        for (size_t col = 0; col < line.length(); col++) {
-            char c = line[col];
-            if (FIRST_AGENT <= c && c <= LAST_AGENT) {
-                agent_goals[c].push_back(Cell2D(row, col));
-                continue;
-            }
-            if (FIRST_BOX <= c && c <= LAST_BOX) {
-                box_goals[c].push_back(Cell2D(row, col));
-                continue;
+    for (size_t row = 0; row < goal_lines.size(); row++) {
+        for (size_t col = 0; col < goal_lines[row].size(); col++) {
+            const char c = goal_lines[row][col];
+            if (col >= num_cols && c != EMPTY) {
+                malformed("goal state is wider than the initial state");
             }
-            if (c == WALL) {
-                continue;
-            }
-            if (c == EMPTY) {
-                continue;
+            if (FIRST_AGENT <= c && c <= LAST_AGENT) {
+                agent_goals[c - FIRST_AGENT].emplace_back(row, col);
+            } else if (FIRST_BOX <= c && c <= LAST_BOX) {
+                box_goals[c - FIRST_BOX].emplace_back(row, col);
+            } else if (c != WALL && c != EMPTY) {
+                malformed(std::string("unknown character in goal state: ") + c);
             }
+        }
+    }
 
-            fprintf(stderr, "Unknown character while reading goal state: %c\n", c);
+    ParsedLevel parsed{domain, name, std::move(walls), std::move(agent_colors), std::move(box_colors), {}, {}};
+    parsed.agents.reserve(agent_count);
+    std::set<Color> agent_colors_set;
+    for (const auto &[agent_char, agent_color] : parsed.agent_colors) {
+        agent_colors_set.insert(agent_color);
+        if (agent_found[agent_char - FIRST_AGENT]) {
+            parsed.agents.push_back(Agent(agent_positions[agent_char - FIRST_AGENT], agent_goals[agent_char - FIRST_AGENT], agent_char));
         }
     }
 
-    for (const auto &[agent_char, agent_color] : agent_colors) {
-        if (agent_positions.find(agent_char) != agent_positions.end()) {
-            agents.push_back(Agent(agent_positions[agent_char], agent_goals[agent_char], agent_char));
+    // Boxes without an agent of their color can never move, they are walls
+    for (const auto &[box_char, box_color] : parsed.box_colors) {
+        const auto &positions = box_positions[box_char - FIRST_BOX];
+        if (positions.empty()) {
+            continue;
+        }
+        if (agent_colors_set.count(box_color)) {
+            parsed.boxes.push_back(BoxBulk(positions, box_goals[box_char - FIRST_BOX], box_color, box_char));
+        } else {
+            for (const auto &position : positions) {
+                parsed.walls(position.r, position.c) = WALL;
+            }
         }
     }
+    return parsed;
+}
 
-    // Get set of agent colors
-    std::set<Color> agent_colors_set;
-    for (const auto &[agent_char, agent_color] : agent_colors) {
-        agent_colors_set.insert(agent_color);
+Level parseLevel(std::string_view text) {
+    ParsedLevel parsed = parseLevelText(text);
+    StaticLevel static_level(parsed.name, parsed.domain, std::move(parsed.walls), std::move(parsed.agent_colors),
+                             std::move(parsed.box_colors));
+    const auto [dead_count, push_dead_count] = static_level.computeDeadSquares(parsed.boxes);
+    fprintf(stderr, "Dead squares: %zu with pulls, %zu with pushes only.\n", dead_count, push_dead_count);
+    size_t corridor_cells = 0;
+    for (const auto &segment : static_level.getCorridorSegments()) {
+        corridor_cells += segment.cells.size();
+    }
+    fprintf(stderr, "Level graph: %zu corridor segments covering %zu cells.\n", static_level.getCorridorSegments().size(), corridor_cells);
+    if (!static_level.getHierarchy().empty()) {
+        fprintf(stderr, "Hierarchy: %zu clusters, %zu portals.\n", static_level.getHierarchy().getClusterCount(),
+                static_level.getHierarchy().getPortalCount());
     }
+    return Level(std::move(static_level), parsed.agents, parsed.boxes);
+}
 
-    // Create BoxBulk objects and mark orphaned boxes as walls
-    std::vector<BoxBulk> boxes;
-    for (const auto &[box_char, box_color] : box_colors) {
-        if (box_positions.find(box_char) != box_positions.end()) {
-            // Check if there's an agent with the same color
-            if (agent_colors_set.find(box_color) != agent_colors_set.end()) {
-                // Box has corresponding agent - add to boxes
-                std::vector<Cell2D> goals;
-                if (box_goals.find(box_char) != box_goals.end()) {
-                    goals = box_goals[box_char];
-                }
-                boxes.push_back(BoxBulk(box_positions[box_char], goals, box_color, box_char));
-            } else {
-                // Box has no corresponding agent - add as walls
-                for (const auto &position : box_positions[box_char]) {
-                    walls(position.r, position.c) = WALL;
-                }
-            }
+std::string readLevelText(std::istream &serverMessages) {
+    // The server keeps the stream open after the level, so read up to #end into one buffer
+    std::string text, line;
+    while (getline(serverMessages, line)) {
+        text += line;
+        text += '\n';
+        if (line == "#end" || line == "#end\r") {
+            break;
         }
     }
+    return text;
+}
+
+Level loadLevel(std::istream &serverMessages) { return parseLevel(readLevelText(serverMessages)); }
 
-    return Level(StaticLevel(name, domain, walls, agent_colors, box_colors), agents, boxes);
+std::string readLevelFile(const std::string &path) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file) {
+        throw std::invalid_argument("Cannot open level file: " + path);
+    }
+    std::string text;
+    char buffer[1 << 16];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        text.append(buffer, read);
+    }
+    fclose(file);
+    return text;
 }
+
+Level loadLevelFile(const std::string &path) { return parseLevel(readLevelFile(path)); }
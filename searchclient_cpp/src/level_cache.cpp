@@ -0,0 +1,405 @@
+#include "level_cache.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+static_assert(sizeof(size_t) == sizeof(uint64_t), "Snapshots store sizes as 64-bit values");
+
+// Appends fixed width little-endian values to one buffer, written out at once
+struct LevelCache::Writer {
+    std::string bytes;
+
+    Writer() : bytes() {}
+
+    template <typename T>
+    void put(const T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain values are written as is");
+        bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+    void putSize(size_t value) { put<uint64_t>(value); }
+    void putString(const std::string &value) {
+        putSize(value.size());
+        bytes.append(value);
+    }
+    void putCell(const Cell2D &cell) {
+        put<uint8_t>(cell.r);
+        put<uint8_t>(cell.c);
+    }
+    void putCells(const std::vector<Cell2D> &cells) {
+        putSize(cells.size());
+        for (const auto &cell : cells) {
+            putCell(cell);
+        }
+    }
+    // Distance tables are the bulk of a snapshot, they are copied as one block
+    void putSizes(const std::vector<size_t> &values) {
+        putSize(values.size());
+        bytes.append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(size_t));
+    }
+    // Packed eight to a byte
+    void putBits(const std::vector<bool> &bits) {
+        putSize(bits.size());
+        for (size_t i = 0; i < bits.size(); i += 8) {
+            uint8_t byte = 0;
+            for (size_t j = i; j < std::min(i + 8, bits.size()); j++) {
+                byte |= bits[j] << (j - i);
+            }
+            put(byte);
+        }
+    }
+};
+
+// Reads the values back from the mapped file. Running past the end clears `ok` and yields zeros, so a
+// truncated file is only noticed once, after reading.
+struct LevelCache::Reader {
+    const char *position;
+    const char *end;
+    bool ok;
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (size_t(end - position) < sizeof(T)) {
+            ok = false;
+            position = end;
+            return value;
+        }
+        memcpy(&value, position, sizeof(T));
+        position += sizeof(T);
+        return value;
+    }
+    // Counts are checked against the bytes left, a corrupt count must not allocate gigabytes
+    size_t getCount(size_t min_element_size) {
+        const size_t count = get<uint64_t>();
+        if (count > size_t(end - position) / min_element_size) {
+            ok = false;
+            position = end;
+            return 0;
+        }
+        return count;
+    }
+    std::string getString() {
+        const size_t size = getCount(1);
+        std::string value(position, size);
+        position += size;
+        return value;
+    }
+    Cell2D getCell() {
+        const uint8_t r = get<uint8_t>();
+        return Cell2D(r, get<uint8_t>());
+    }
+    std::vector<Cell2D> getCells() {
+        std::vector<Cell2D> cells(getCount(2));
+        for (auto &cell : cells) {
+            cell = getCell();
+        }
+        return cells;
+    }
+    std::vector<size_t> getSizes() {
+        std::vector<size_t> values(getCount(sizeof(size_t)));
+        memcpy(values.data(), position, values.size() * sizeof(size_t));
+        position += values.size() * sizeof(size_t);
+        return values;
+    }
+    std::vector<bool> getBits() {
+        const size_t size = get<uint64_t>();
+        if (size > size_t(end - position) * 8) {
+            ok = false;
+            position = end;
+            return {};
+        }
+        std::vector<bool> bits(size);
+        for (size_t i = 0; i < size; i++) {
+            bits[i] = (uint8_t(position[i / 8]) >> (i % 8)) & 1;
+        }
+        position += (size + 7) / 8;
+        return bits;
+    }
+};
+
+LevelCache::LevelCache(std::string directory) : directory_(std::move(directory)) {}
+
+uint64_t LevelCache::hashText(std::string_view text) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char c : text) {
+        hash = (hash ^ uint8_t(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string LevelCache::getPath(uint64_t hash) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.lvlc", static_cast<unsigned long long>(hash));
+    return directory_.empty() ? name : directory_ + "/" + name;
+}
+
+void LevelCache::writeHierarchy(Writer &out, const HierarchicalMap &hierarchy) {
+    out.putSize(hierarchy.rows_);
+    out.putSize(hierarchy.cols_);
+    out.putBits(hierarchy.free_);
+    out.putSize(hierarchy.cluster_size_);
+    out.putSize(hierarchy.cluster_cols_);
+    out.putSize(hierarchy.portals_.size());
+    for (const auto &portal : hierarchy.portals_) {
+        out.putCell(portal.cell);
+        out.putSize(portal.cluster);
+        out.putSizes(portal.local_distances);
+        out.putSize(portal.edges.size());
+        for (const auto &[to, cost] : portal.edges) {
+            out.putSize(to);
+            out.putSize(cost);
+        }
+    }
+    out.putSize(hierarchy.cluster_portals_.size());
+    for (const auto &portals : hierarchy.cluster_portals_) {
+        out.putSizes(portals);
+    }
+    out.putSizes(hierarchy.portal_at_);
+}
+
+void LevelCache::readHierarchy(Reader &in, HierarchicalMap &hierarchy) {
+    hierarchy.rows_ = in.get<uint64_t>();
+    hierarchy.cols_ = in.get<uint64_t>();
+    hierarchy.free_ = in.getBits();
+    hierarchy.cluster_size_ = in.get<uint64_t>();
+    hierarchy.cluster_cols_ = in.get<uint64_t>();
+    hierarchy.portals_.resize(in.getCount(8));
+    for (auto &portal : hierarchy.portals_) {
+        portal.cell = in.getCell();
+        portal.cluster = in.get<uint64_t>();
+        portal.local_distances = in.getSizes();
+        portal.edges.resize(in.getCount(16));
+        for (auto &[to, cost] : portal.edges) {
+            to = in.get<uint64_t>();
+            cost = in.get<uint64_t>();
+        }
+    }
+    hierarchy.cluster_portals_.resize(in.getCount(8));
+    for (auto &portals : hierarchy.cluster_portals_) {
+        portals = in.getSizes();
+    }
+    hierarchy.portal_at_ = in.getSizes();
+}
+
+void LevelCache::writeStaticLevel(Writer &out, const StaticLevel &level) {
+    out.putString(level.name_);
+    out.putString(level.domain_);
+    out.putSize(level.walls_.size_rows());
+    out.putSize(level.walls_.size_cols());
+    std::vector<bool> walls(level.walls_.data.size());
+    for (size_t i = 0; i < walls.size(); i++) {
+        walls[i] = level.walls_.data[i] == WALL;
+    }
+    out.putBits(walls);
+    for (const auto *colors : {&level.agent_colors_, &level.box_colors_}) {
+        out.putSize(colors->size());
+        for (const auto &[symbol, color] : *colors) {
+            out.put<char>(symbol);
+            out.put<uint8_t>(static_cast<uint8_t>(color));
+        }
+    }
+    out.putSize(level.dead_squares_.size());
+    for (const auto &dead : level.dead_squares_) {
+        out.putBits(dead);
+    }
+    out.put<double>(level.corridor_share_);
+    out.putSize(level.segments_.size());
+    for (const auto &segment : level.segments_) {
+        out.putCells(segment.cells);
+        out.putCell(segment.ends[0]);
+        out.putCell(segment.ends[1]);
+    }
+    out.putSizes(level.segment_of_);
+    writeHierarchy(out, level.hierarchy_);
+}
+
+StaticLevel *LevelCache::readStaticLevel(Reader &in) {
+    std::string name = in.getString();
+    std::string domain = in.getString();
+    const size_t rows = in.get<uint64_t>(), cols = in.get<uint64_t>();
+    const std::vector<bool> wall_bits = in.getBits();
+    if (!in.ok || wall_bits.size() != rows * cols) {
+        return nullptr;
+    }
+    CharGrid walls(rows, cols);
+    for (size_t i = 0; i < wall_bits.size(); i++) {
+        walls.data[i] = wall_bits[i] ? WALL : 0;
+    }
+    std::map<char, Color> colors[2];
+    for (auto &symbol_colors : colors) {
+        const size_t count = in.getCount(2);
+        for (size_t i = 0; i < count; i++) {
+            const char symbol = in.get<char>();
+            symbol_colors.emplace(symbol, static_cast<Color>(in.get<uint8_t>()));
+        }
+    }
+
+    StaticLevel *level = new StaticLevel(std::move(name), std::move(domain), std::move(walls), colors[0], colors[1], false);
+    level->dead_squares_.resize(in.getCount(8));
+    for (auto &dead : level->dead_squares_) {
+        dead = in.getBits();
+    }
+    level->corridor_share_ = in.get<double>();
+    level->segments_.resize(in.getCount(12));
+    for (auto &segment : level->segments_) {
+        segment.cells = in.getCells();
+        segment.ends[0] = in.getCell();
+        segment.ends[1] = in.getCell();
+    }
+    level->segment_of_ = in.getSizes();
+    readHierarchy(in, level->hierarchy_);
+    if (!in.ok || !isConsistent(*level)) {
+        delete level;
+        return nullptr;
+    }
+    return level;
+}
+
+bool LevelCache::isConsistent(const StaticLevel &level) {
+    const size_t rows = level.walls_.size_rows(), cols = level.walls_.size_cols();
+    auto in_grid = [&](const Cell2D &cell) { return size_t(cell.r) < rows && size_t(cell.c) < cols; };
+    // Every entry indexes `size` elements, or is SIZE_MAX where `unset` allows it
+    auto in_range = [](const std::vector<size_t> &indices, size_t size, bool unset) {
+        return std::all_of(indices.begin(), indices.end(), [&](size_t idx) { return idx < size || (unset && idx == SIZE_MAX); });
+    };
+
+    if (level.dead_squares_.size() != LAST_BOX - FIRST_BOX + 1) {
+        return false;
+    }
+    for (const auto &dead : level.dead_squares_) {
+        if (!dead.empty() && dead.size() != rows * cols) {
+            return false;
+        }
+    }
+    if (level.segment_of_.size() != rows * cols || !in_range(level.segment_of_, level.segments_.size(), true)) {
+        return false;
+    }
+    for (const auto &segment : level.segments_) {
+        if (!std::all_of(segment.cells.begin(), segment.cells.end(), in_grid) || !in_grid(segment.ends[0]) || !in_grid(segment.ends[1])) {
+            return false;
+        }
+    }
+
+    const HierarchicalMap &hierarchy = level.hierarchy_;
+    if (hierarchy.empty()) {
+        return hierarchy.portals_.empty() && hierarchy.portal_at_.empty();
+    }
+    const size_t cluster_size = hierarchy.cluster_size_;
+    if (cluster_size == 0 || hierarchy.rows_ != rows || hierarchy.cols_ != cols || hierarchy.free_.size() != rows * cols ||
+        hierarchy.cluster_cols_ != (cols + cluster_size - 1) / cluster_size ||
+        hierarchy.cluster_portals_.size() != (rows + cluster_size - 1) / cluster_size * hierarchy.cluster_cols_ ||
+        hierarchy.portal_at_.size() != rows * cols || !in_range(hierarchy.portal_at_, hierarchy.portals_.size(), true)) {
+        return false;
+    }
+    for (const auto &portals : hierarchy.cluster_portals_) {
+        if (!in_range(portals, hierarchy.portals_.size(), false)) {
+            return false;
+        }
+    }
+    for (const auto &portal : hierarchy.portals_) {
+        if (!in_grid(portal.cell) || portal.cluster != hierarchy.clusterOf(portal.cell) ||
+            portal.local_distances.size() != cluster_size * cluster_size) {
+            return false;
+        }
+        for (const auto &edge : portal.edges) {
+            if (edge.first >= hierarchy.portals_.size()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+Level *LevelCache::load(std::string_view text) const {
+    const uint64_t hash = hashText(text);
+    const std::string path = getPath(hash);
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        return nullptr;
+    }
+    const size_t size = file_stat.st_size;
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return nullptr;
+    }
+
+    Reader in{static_cast<const char *>(mapped), static_cast<const char *>(mapped) + size, true};
+    Level *level = nullptr;
+    // The text length guards against hash collisions between levels of different sizes
+    if (in.get<uint32_t>() == MAGIC && in.get<uint32_t>() == VERSION && in.get<uint64_t>() == hash && in.get<uint64_t>() == text.size()) {
+        StaticLevel *static_level = readStaticLevel(in);
+        if (static_level) {
+            std::vector<Agent> agents;
+            const size_t agent_count = in.getCount(3);
+            for (size_t i = 0; i < agent_count; i++) {
+                const char symbol = in.get<char>();
+                const Cell2D position = in.getCell();
+                agents.emplace_back(position, in.getCells(), symbol);
+            }
+            std::vector<BoxBulk> boxes;
+            const size_t box_count = in.getCount(4);
+            for (size_t i = 0; i < box_count; i++) {
+                const char symbol = in.get<char>();
+                const Color color = static_cast<Color>(in.get<uint8_t>());
+                std::vector<Cell2D> positions = in.getCells();
+                boxes.emplace_back(positions, in.getCells(), color, symbol);
+            }
+            if (in.ok && in.position == in.end) {
+                level = new Level(std::move(*static_level), agents, boxes);
+            }
+            delete static_level;
+        }
+    }
+    munmap(mapped, size);
+    return level;
+}
+
+bool LevelCache::store(std::string_view text, const Level &level) const {
+    Writer out;
+    out.put<uint32_t>(MAGIC);
+    out.put<uint32_t>(VERSION);
+    out.put<uint64_t>(hashText(text));
+    out.put<uint64_t>(text.size());
+    writeStaticLevel(out, level.static_level);
+    out.putSize(level.agents.size());
+    for (const auto &agent : level.agents) {
+        out.put<char>(agent.getSymbol());
+        out.putCell(agent.getPosition());
+        out.putCells(agent.getGoalPositions());
+    }
+    out.putSize(level.boxes.size());
+    for (const auto &box_bulk : level.boxes) {
+        out.put<char>(box_bulk.getSymbol());
+        out.put<uint8_t>(static_cast<uint8_t>(box_bulk.getColor()));
+        out.putCells(box_bulk.getPositions());
+        out.putCells(box_bulk.getGoals());
+    }
+
+    // Written under a temporary name and renamed, so concurrent runs never map a half written file
+    const std::string path = getPath(hashText(text));
+    const std::string temporary_path = path + "." + std::to_string(getpid()) + ".tmp";
+    FILE *file = fopen(temporary_path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    const bool written = fwrite(out.bytes.data(), 1, out.bytes.size(), file) == out.bytes.size();
+    if (fclose(file) != 0 || !written || rename(temporary_path.c_str(), path.c_str()) != 0) {
+        remove(temporary_path.c_str());
+        return false;
+    }
+    return true;
+}
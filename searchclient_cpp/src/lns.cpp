@@ -0,0 +1,224 @@
+#include "lns.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+
+#include "memory.hpp"
+#include "utils.hpp"
+
+// Share of the latest improvement blended into a neighborhood type's weight
+static constexpr double WEIGHT_REACTION = 0.1;
+// Keeps every neighborhood type selectable after a long streak of failures
+static constexpr double MIN_WEIGHT = 1e-3;
+
+const char *neighborhoodTypeToString(NeighborhoodType type) {
+    switch (type) {
+        case NeighborhoodType::Random:
+            return "random";
+        case NeighborhoodType::AgentBased:
+            return "agent";
+        case NeighborhoodType::MapBased:
+            return "map";
+    }
+    return "unknown";
+}
+
+LargeNeighborhoodSearch::LargeNeighborhoodSearch(const Level &level, const std::vector<LowLevelState *> &group_states,
+                                                 size_t neighborhood_size, unsigned int seed)
+    : group_states_(group_states),
+      planner_(level, group_states, seed),
+      rows_(level.static_level.getSize().r),
+      cols_(level.static_level.getSize().c),
+      neighborhood_size_(std::max<size_t>(1, std::min(neighborhood_size, group_states.size() - 1))),
+      deadline_(std::chrono::steady_clock::time_point::max()),
+      weights_(),
+      tabu_(),
+      improvement_curve_(),
+      iterations_count_(0) {
+    weights_.fill(1.0);
+}
+
+void LargeNeighborhoodSearch::setDeadline(const std::chrono::steady_clock::time_point &deadline) {
+    deadline_ = deadline;
+    planner_.setDeadline(deadline);
+}
+
+std::vector<std::vector<bool>> LargeNeighborhoodSearch::getVisitedCells(
+    const std::vector<std::vector<std::vector<const Action *>>> &solutions) const {
+    std::vector<std::vector<bool>> visited(group_states_.size(), std::vector<bool>(rows_ * cols_, false));
+    for (size_t group_idx = 0; group_idx < group_states_.size(); group_idx++) {
+        LowLevelState state(*group_states_[group_idx]);
+        for (size_t t = 0; t <= solutions[group_idx].size(); t++) {
+            for (const auto &cell : state.getOccupiedCells()) {
+                visited[group_idx][cell.r * cols_ + cell.c] = true;
+            }
+            if (t < solutions[group_idx].size()) {
+                state.applyActions(solutions[group_idx][t]);
+            }
+        }
+    }
+    return visited;
+}
+
+NeighborhoodType LargeNeighborhoodSearch::selectNeighborhoodType() {
+    std::discrete_distribution<size_t> distribution(weights_.begin(), weights_.end());
+    return static_cast<NeighborhoodType>(distribution(planner_.getRandomGenerator()));
+}
+
+std::vector<size_t> LargeNeighborhoodSearch::randomNeighborhood() {
+    std::vector<size_t> groups(group_states_.size());
+    std::iota(groups.begin(), groups.end(), 0);
+    std::shuffle(groups.begin(), groups.end(), planner_.getRandomGenerator());
+    groups.resize(neighborhood_size_);
+    return groups;
+}
+
+// Seeds the neighborhood with the longest plan (it sets the makespan) and adds groups whose paths cross it
+std::vector<size_t> LargeNeighborhoodSearch::agentBasedNeighborhood(const std::vector<std::vector<std::vector<const Action *>>> &solutions) {
+    if (tabu_.size() >= group_states_.size()) {
+        tabu_.clear();
+    }
+
+    size_t seed_group = SIZE_MAX;
+    for (size_t group_idx = 0; group_idx < group_states_.size(); group_idx++) {
+        if (std::find(tabu_.begin(), tabu_.end(), group_idx) != tabu_.end()) {
+            continue;
+        }
+        if (seed_group == SIZE_MAX || solutions[group_idx].size() > solutions[seed_group].size()) {
+            seed_group = group_idx;
+        }
+    }
+    tabu_.push_back(seed_group);
+
+    const auto visited = getVisitedCells(solutions);
+    std::vector<size_t> crossing;
+    std::vector<size_t> others;
+    for (size_t group_idx = 0; group_idx < group_states_.size(); group_idx++) {
+        if (group_idx == seed_group) {
+            continue;
+        }
+        bool crosses = false;
+        for (size_t cell_idx = 0; cell_idx < visited[group_idx].size() && !crosses; cell_idx++) {
+            crosses = visited[group_idx][cell_idx] && visited[seed_group][cell_idx];
+        }
+        (crosses ? crossing : others).push_back(group_idx);
+    }
+    std::shuffle(crossing.begin(), crossing.end(), planner_.getRandomGenerator());
+    std::shuffle(others.begin(), others.end(), planner_.getRandomGenerator());
+    crossing.insert(crossing.end(), others.begin(), others.end());
+
+    std::vector<size_t> groups = {seed_group};
+    groups.insert(groups.end(), crossing.begin(), crossing.begin() + (neighborhood_size_ - 1));
+    return groups;
+}
+
+// Picks a random cell on some group's path and takes the groups whose paths pass closest to it
+std::vector<size_t> LargeNeighborhoodSearch::mapBasedNeighborhood(const std::vector<std::vector<std::vector<const Action *>>> &solutions) {
+    const auto visited = getVisitedCells(solutions);
+    auto &random_generator = planner_.getRandomGenerator();
+
+    const size_t center_group = std::uniform_int_distribution<size_t>(0, group_states_.size() - 1)(random_generator);
+    std::vector<size_t> center_candidates;
+    for (size_t cell_idx = 0; cell_idx < visited[center_group].size(); cell_idx++) {
+        if (visited[center_group][cell_idx]) {
+            center_candidates.push_back(cell_idx);
+        }
+    }
+    const size_t center = center_candidates[std::uniform_int_distribution<size_t>(0, center_candidates.size() - 1)(random_generator)];
+    const int center_r = center / cols_;
+    const int center_c = center % cols_;
+
+    std::vector<std::pair<size_t, size_t>> distances;  // (distance, group_idx)
+    distances.reserve(group_states_.size());
+    for (size_t group_idx = 0; group_idx < group_states_.size(); group_idx++) {
+        size_t distance = SIZE_MAX;
+        for (size_t cell_idx = 0; cell_idx < visited[group_idx].size(); cell_idx++) {
+            if (visited[group_idx][cell_idx]) {
+                const size_t d = std::abs(int(cell_idx / cols_) - center_r) + std::abs(int(cell_idx % cols_) - center_c);
+                distance = std::min(distance, d);
+            }
+        }
+        distances.emplace_back(distance, group_idx);
+    }
+    // Shuffle first so that ties are broken randomly
+    std::shuffle(distances.begin(), distances.end(), random_generator);
+    std::stable_sort(distances.begin(), distances.end(),
+                     [](const auto &a, const auto &b) { return a.first < b.first; });
+
+    std::vector<size_t> groups;
+    groups.reserve(neighborhood_size_);
+    for (size_t i = 0; i < neighborhood_size_; i++) {
+        groups.push_back(distances[i].second);
+    }
+    return groups;
+}
+
+std::vector<std::vector<std::vector<const Action *>>> LargeNeighborhoodSearch::improve(
+    std::vector<std::vector<std::vector<const Action *>>> solutions) {
+    const auto start = std::chrono::steady_clock::now();
+    size_t best_cost = utils::CBS_cost(solutions);
+    improvement_curve_.push_back({0.0, 0, best_cost});
+
+    // A lone group is only ever replanned by itself, with no other plans to avoid, which repeats the search that
+    // planned it. That plan need not be optimal, LNS just has no other neighborhood to try.
+    if (group_states_.size() < 2) {
+        fprintf(stderr, "LNS skipped, a single group has no other plans to repair against.\n");
+        return solutions;
+    }
+    fprintf(stderr, "LNS started from cost %zu with neighborhood size %zu.\n", best_cost, neighborhood_size_);
+
+    size_t last_improvement_iteration = 0;
+    while (std::chrono::steady_clock::now() < deadline_ && !planner_.isCancelled()) {
+        if (iterations_count_ - last_improvement_iteration >= MAX_ITERATIONS_WITHOUT_IMPROVEMENT) {
+            fprintf(stderr, "LNS stopped, no improvement in %zu iterations.\n", MAX_ITERATIONS_WITHOUT_IMPROVEMENT);
+            break;
+        }
+        if (Memory::getUsage() > Memory::maxUsage) {
+            fprintf(stderr, "Maximum memory usage exceeded in LNS.\n");
+            break;
+        }
+        iterations_count_++;
+
+        const NeighborhoodType type = selectNeighborhoodType();
+        std::vector<size_t> neighborhood;
+        switch (type) {
+            case NeighborhoodType::Random:
+                neighborhood = randomNeighborhood();
+                break;
+            case NeighborhoodType::AgentBased:
+                neighborhood = agentBasedNeighborhood(solutions);
+                break;
+            case NeighborhoodType::MapBased:
+                neighborhood = mapBasedNeighborhood(solutions);
+                break;
+        }
+        std::shuffle(neighborhood.begin(), neighborhood.end(), planner_.getRandomGenerator());
+
+        // replan() leaves its argument partially replanned on failure, so work on a copy
+        auto candidate = solutions;
+        size_t improvement = 0;
+        if (planner_.replan(neighborhood, candidate)) {
+            const size_t cost = utils::CBS_cost(candidate);
+            if (cost < best_cost) {
+                improvement = best_cost - cost;
+                best_cost = cost;
+                solutions = std::move(candidate);
+                last_improvement_iteration = iterations_count_;
+
+                const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                improvement_curve_.push_back({seconds, iterations_count_, best_cost});
+                fprintf(stderr, "LNS improvement: %.3f s, iteration %zu, cost %zu (%s neighborhood).\n", seconds, iterations_count_,
+                        best_cost, neighborhoodTypeToString(type));
+            }
+        }
+
+        double &weight = weights_[static_cast<size_t>(type)];
+        weight = (1 - WEIGHT_REACTION) * weight + WEIGHT_REACTION * double(improvement) / neighborhood.size();
+        weight = std::max(weight, MIN_WEIGHT);
+    }
+
+    fprintf(stderr, "LNS finished after %zu iterations, cost %zu -> %zu.\n", iterations_count_, improvement_curve_.front().cost,
+            best_cost);
+    return solutions;
+}
@@ -10,6 +10,8 @@
 #else
 #include <sys/resource.h>
 #include <unistd.h>
+
+#include <cstdio>
 #endif
 
 uint32_t Memory::maxUsage = 1024;  // Max memory usage in MB
@@ -21,6 +23,16 @@ uint32_t Memory::getUsage() {
         return pmc.WorkingSetSize / (1024 * 1024);  // Convert bytes to MB
     }
 #else
+    // Current resident set where /proc has it: the peak from getrusage never drops, so searches run after a
+    // memory heavy one would all be refused
+    if (FILE *statm = fopen("/proc/self/statm", "r")) {
+        unsigned long size_pages = 0, resident_pages = 0;
+        const int read = fscanf(statm, "%lu %lu", &size_pages, &resident_pages);
+        fclose(statm);
+        if (read == 2) {
+            return resident_pages * sysconf(_SC_PAGESIZE) / (1024 * 1024);
+        }
+    }
     struct rusage usage;
     if (getrusage(RUSAGE_SELF, &usage) == 0) {
         return usage.ru_maxrss / 1024;  // Convert KB to MB
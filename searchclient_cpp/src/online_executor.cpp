@@ -0,0 +1,155 @@
+#include "online_executor.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#include "cancellation_token.hpp"
+#include "cbs.hpp"
+#include "plan_writer.hpp"
+
+void OnlineExecutor::stream(const Level &level, std::chrono::steady_clock::time_point deadline, size_t window) {
+    PlanWriter writer(out_, in_);
+    writer.start();
+    const Level *current = new Level(level);
+    std::vector<std::vector<const Action *>> remainder;
+    size_t committed = 0, rounds = 0;
+    size_t previous_plan_size = SIZE_MAX;
+    size_t next_window = window;
+    bool first_round = true;
+    while (!writer.hasFailed()) {
+        const bool improving = !first_round && !window;
+        const auto round_deadline = improving ? std::min(deadline, std::chrono::steady_clock::now() + STREAM_ROUND_TIME_LIMIT) : deadline;
+        CBS cbs(*current, round_deadline);
+        cbs.setWarmStart(first_round);
+        if (window) {
+            cbs.setConflictWindow(window);
+        }
+        // Improving rounds only search while the server still has committed actions to execute
+        CancellationToken executed;
+        std::thread watcher;
+        if (improving) {
+            cbs.setCancellationToken(&executed);
+            watcher = std::thread([&] {
+                while (!executed.isCancelled() && writer.getUnfinished() > 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                executed.cancel();
+            });
+        }
+        cbs.solve();
+        if (watcher.joinable()) {
+            executed.cancel();
+            watcher.join();
+        }
+        if (!cbs.getSolutions().empty()) {
+            auto plan = cbs.mergePlans(cbs.getSolutions());
+            if (window && !first_round && plan.size() >= previous_plan_size) {
+                // The committed steps brought the goals no closer, a wider window from the next cycle on breaks such livelocks
+                next_window = window * 2;
+                fprintf(stderr, "Windowed CBS made no progress, window widened to %zu.\n", next_window);
+            }
+            previous_plan_size = plan.size();
+            if (!improving || plan.size() < remainder.size()) {
+                remainder = std::move(plan);
+            }
+        } else if (window) {
+            remainder.clear();  // Steps past the last window were never checked
+        }
+        first_round = false;
+        rounds++;
+        if (remainder.empty()) {
+            break;
+        }
+        const bool last_part = window ? remainder.size() <= window
+                                      : remainder.size() <= STREAM_MIN_REMAINDER || std::chrono::steady_clock::now() >= deadline;
+        if (last_part) {
+            writer.append(remainder);
+            committed += remainder.size();
+            break;
+        }
+        const size_t prefix_size = window ? window : remainder.size() / 2;
+        const std::vector<std::vector<const Action *>> prefix(remainder.begin(), remainder.begin() + prefix_size);
+        const Level *next = cbs.advanceLevel(prefix);
+        if (!next) {
+            break;  // Not expected: the prefix is conflict free and was planned from this state
+        }
+        writer.append(prefix);
+        committed += prefix.size();
+        remainder.erase(remainder.begin(), remainder.begin() + prefix.size());
+        delete current;
+        current = next;
+        window = next_window;
+    }
+    delete current;
+    rounds_ += rounds;
+
+    if (committed == 0) {
+        writer.finish();
+        fprintf(stderr, "Unable to solve level.\n");
+        return;
+    }
+    fprintf(stderr, "Sent %zu joint actions in %zu rounds.\n", committed, rounds);
+    if (!writer.finish()) {
+        fprintf(stderr, "Server rejected joint action %zu: %s\n", writer.getFailedStep(), writer.getFailedResponse().c_str());
+    }
+    executed_.insert(executed_.end(), writer.getExecuted().begin(), writer.getExecuted().end());
+    fprintf(stderr, "--------------------------------\n");
+}
+
+void OnlineExecutor::execute(const Level &level, const CBS &cbs, std::vector<std::vector<const Action *>> plan,
+                             std::chrono::steady_clock::time_point deadline) {
+    const Level *current = &level;
+    const CBS *planner = &cbs;
+    size_t sent = 0;
+    for (size_t repairs = 0;; repairs++) {
+        const auto sending_start = std::chrono::steady_clock::now();
+        PlanWriter writer(out_, in_);
+        const bool accepted = writer.send(plan);
+        executed_.insert(executed_.end(), writer.getExecuted().begin(), writer.getExecuted().end());
+        if (accepted) {
+            sent += plan.size();
+            fprintf(stderr, "Sent %zu joint actions in %.1f ms.\n", plan.size(),
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sending_start).count());
+            break;
+        }
+        fprintf(stderr, "Server rejected joint action %zu (%s): %s\n", sent + writer.getFailedStep(),
+                formatJointAction(plan[std::min(writer.getFailedStep(), plan.size() - 1)], false).c_str(), writer.getFailedResponse().c_str());
+        sent += writer.getExecuted().size();
+        // The rejected action itself is answered, a server that stopped answering is not
+        const bool rejected = writer.getExecuted().size() > writer.getFailedStep();
+        if (!rejected || repairs == MAX_REPAIRS || std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+
+        const auto repair_start = std::chrono::steady_clock::now();
+        const Level *actual = planner->advanceLevel(writer.getExecuted());
+        if (!actual) {
+            fprintf(stderr, "Unable to rebuild the state the server reached.\n");
+            break;
+        }
+        CBS *repair = new CBS(*actual, std::min(deadline, repair_start + REPAIR_TIME_LIMIT), planner);
+        repair->setWarmStart(false);
+        repair->solve();
+        repairs_++;
+        plan.clear();
+        if (!repair->getSolutions().empty()) {
+            plan = repair->mergePlans(repair->getSolutions());
+        }
+        if (planner != &cbs) {
+            delete planner;
+            delete current;
+        }
+        current = actual;
+        planner = repair;
+        if (plan.empty()) {
+            fprintf(stderr, "Unable to repair the plan.\n");
+            break;
+        }
+        fprintf(stderr, "Repaired plan of length %zu in %.1f ms.\n", plan.size(),
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - repair_start).count());
+    }
+    if (planner != &cbs) {
+        delete planner;
+        delete current;
+    }
+}
@@ -0,0 +1,251 @@
+#include "plan_validator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+PlanValidator::PlanValidator(const Level &level)
+    : level_(level),
+      rows_(level.static_level.getSize().r),
+      cols_(level.static_level.getSize().c),
+      walls_(rows_ * cols_),
+      agent_colors_(),
+      box_colors_() {
+    for (size_t r = 0; r < rows_; r++) {
+        for (size_t c = 0; c < cols_; c++) {
+            walls_[r * cols_ + c] = !level.static_level.isCellFree(Cell2D(r, c));
+        }
+    }
+    for (const auto &agent : level.agents) {
+        agent_colors_.push_back(level.static_level.getAgentColor(agent.getSymbol()));
+    }
+    for (const auto &box_bulk : level.boxes) {
+        box_colors_[box_bulk.getSymbol() - FIRST_BOX] = box_bulk.getColor();
+    }
+}
+
+static std::string describe(size_t step, size_t agent_idx, const Action &action, const char *reason) {
+    return "Step " + std::to_string(step) + ": agent " + std::to_string(agent_idx) + " " + action.name + " " + reason;
+}
+
+static std::string describeCell(const Cell2D &cell) {
+    return "(" + std::to_string(cell.r) + ", " + std::to_string(cell.c) + ")";
+}
+
+PlanReport PlanValidator::validate(const std::vector<std::vector<const Action *>> &plan) const {
+    const size_t agents_count = level_.agents.size();
+    const size_t cells_count = rows_ * cols_;
+
+    // Occupancy grids of the simulated state, agents stored as index + 1 and boxes as their letter
+    std::vector<uint8_t> agent_at(cells_count, 0);
+    std::vector<char> box_at(cells_count, 0);
+    std::vector<Cell2D> agent_positions(agents_count);
+    std::vector<size_t> agent_cells(agents_count);
+    for (size_t i = 0; i < agents_count; i++) {
+        const Cell2D &position = agent_positions[i] = level_.agents[i].getPosition();
+        agent_cells[i] = position.r * cols_ + position.c;
+        agent_at[agent_cells[i]] = i + 1;
+    }
+    for (const auto &box_bulk : level_.boxes) {
+        for (const auto &position : box_bulk.getPositions()) {
+            box_at[position.r * cols_ + position.c] = box_bulk.getSymbol();
+        }
+    }
+
+    // Cells entered and boxes moved in the current joint action, tagged with its step + 1 so they never need clearing
+    std::vector<uint32_t> entered_in(cells_count, 0), box_moved_in(cells_count, 0);
+    std::vector<uint8_t> entered_by(cells_count, 0), box_moved_by(cells_count, 0);
+
+    struct Effect {
+        size_t agent_to;
+        size_t box_from;  // SIZE_MAX without a box
+        size_t box_to;
+    };
+    std::vector<Effect> effects(agents_count);
+    std::vector<size_t> last_active(agents_count, 0);
+    auto is_free = [&](size_t cell) { return !walls_[cell] && !box_at[cell] && !agent_at[cell]; };
+
+    PlanReport report;
+    report.makespan = plan.size();
+    for (size_t step = 0; step < plan.size(); step++) {
+        const auto &joint_action = plan[step];
+        if (joint_action.size() != agents_count) {
+            report.valid = false;
+            report.failed_step = step;
+            report.error = "Step " + std::to_string(step) + ": " + std::to_string(joint_action.size()) + " actions for " +
+                           std::to_string(agents_count) + " agents";
+            return report;
+        }
+        const uint32_t stamp = step + 1;
+
+        for (size_t i = 0; i < agents_count; i++) {
+            const Action &action = *joint_action[i];
+            Effect &effect = effects[i];
+            effect = {agent_cells[i], SIZE_MAX, SIZE_MAX};
+            if (action.type == ActionType::NoOp) {
+                continue;
+            }
+            const Cell2D &position = agent_positions[i];
+            const Cell2D agent_to = position + action.agent_delta;
+            // Walls enclose every level, this only guards against malformed ones
+            if (agent_to.r >= rows_ || agent_to.c >= cols_) {
+                report.error = describe(step, i, action, "leaves the level");
+            } else if (action.type == ActionType::Move) {
+                effect.agent_to = agent_to.r * cols_ + agent_to.c;
+                if (!is_free(effect.agent_to)) {
+                    report.error = describe(step, i, action, "moves into an occupied cell");
+                }
+            } else if (action.type == ActionType::Push) {
+                const Cell2D box_to = agent_to + action.box_delta;
+                effect.agent_to = effect.box_from = agent_to.r * cols_ + agent_to.c;
+                effect.box_to = box_to.r * cols_ + box_to.c;
+                const char box = box_at[effect.box_from];
+                if (!box || box_colors_[box - FIRST_BOX] != agent_colors_[i]) {
+                    report.error = describe(step, i, action, "has no box of its color to push");
+                } else if (box_to.r >= rows_ || box_to.c >= cols_ || !is_free(effect.box_to)) {
+                    report.error = describe(step, i, action, "pushes the box into an occupied cell");
+                }
+            } else {
+                const Cell2D box_from = position - action.box_delta;
+                effect.agent_to = agent_to.r * cols_ + agent_to.c;
+                effect.box_to = agent_cells[i];
+                char box = 0;
+                if (box_from.r < rows_ && box_from.c < cols_) {
+                    effect.box_from = box_from.r * cols_ + box_from.c;
+                    box = box_at[effect.box_from];
+                }
+                if (!box || box_colors_[box - FIRST_BOX] != agent_colors_[i]) {
+                    report.error = describe(step, i, action, "has no box of its color to pull");
+                } else if (!is_free(effect.agent_to)) {
+                    report.error = describe(step, i, action, "moves into an occupied cell");
+                }
+            }
+            if (report.error.empty()) {
+                // Two actions conflict when they enter the same cell or move the same box
+                for (const size_t cell : {effect.agent_to, effect.box_to}) {
+                    if (cell == SIZE_MAX || cell == agent_cells[i]) {
+                        continue;
+                    }
+                    if (entered_in[cell] == stamp) {
+                        report.error = "Step " + std::to_string(step) + ": agents " + std::to_string(entered_by[cell]) + " and " +
+                                       std::to_string(i) + " both move into " + describeCell(Cell2D(cell / cols_, cell % cols_));
+                        break;
+                    }
+                    entered_in[cell] = stamp;
+                    entered_by[cell] = i;
+                }
+            }
+            if (report.error.empty() && effect.box_from != SIZE_MAX) {
+                if (box_moved_in[effect.box_from] == stamp) {
+                    report.error = "Step " + std::to_string(step) + ": agents " + std::to_string(box_moved_by[effect.box_from]) +
+                                   " and " + std::to_string(i) + " both move the box at " +
+                                   describeCell(Cell2D(effect.box_from / cols_, effect.box_from % cols_));
+                }
+                box_moved_in[effect.box_from] = stamp;
+                box_moved_by[effect.box_from] = i;
+            }
+            if (!report.error.empty()) {
+                report.valid = false;
+                report.failed_step = step;
+                return report;
+            }
+            last_active[i] = step + 1;
+            report.fuel++;
+        }
+
+        // Every destination was free before the joint action and no two coincide, so lifting everything
+        // that moves and setting it down again applies the joint action
+        char moved_boxes[LAST_AGENT - FIRST_AGENT + 1];
+        for (size_t i = 0; i < agents_count; i++) {
+            agent_at[agent_cells[i]] = 0;
+            if (effects[i].box_from != SIZE_MAX) {
+                moved_boxes[i] = box_at[effects[i].box_from];
+                box_at[effects[i].box_from] = 0;
+            }
+        }
+        for (size_t i = 0; i < agents_count; i++) {
+            agent_cells[i] = effects[i].agent_to;
+            agent_positions[i] = agent_positions[i] + joint_action[i]->agent_delta;
+            agent_at[agent_cells[i]] = i + 1;
+            if (effects[i].box_from != SIZE_MAX) {
+                box_at[effects[i].box_to] = moved_boxes[i];
+            }
+        }
+    }
+    for (const size_t cost : last_active) {
+        report.sum_of_costs += cost;
+    }
+
+    for (size_t i = 0; i < agents_count && report.error.empty(); i++) {
+        const auto &goals = level_.agents[i].getGoalPositions();
+        if (!goals.empty() && std::find(goals.begin(), goals.end(), agent_positions[i]) == goals.end()) {
+            report.error = "Agent " + std::to_string(i) + " ends at " + describeCell(agent_positions[i]) + ", not on its goal";
+        }
+    }
+    for (const auto &box_bulk : level_.boxes) {
+        for (const auto &goal : box_bulk.getGoals()) {
+            if (report.error.empty() && box_at[goal.r * cols_ + goal.c] != box_bulk.getSymbol()) {
+                report.error = std::string("Goal ") + box_bulk.getSymbol() + " at " + describeCell(goal) + " has no box";
+            }
+        }
+    }
+    report.solved = report.error.empty();
+    return report;
+}
+
+static std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+std::vector<std::vector<const Action *>> PlanValidator::parsePlan(std::string_view text, size_t agents_count) {
+    static const std::unordered_map<std::string_view, const Action *> actions_by_name = [] {
+        std::unordered_map<std::string_view, const Action *> actions;
+        for (const Action *action : Action::allValues()) {
+            actions.emplace(action->name, action);
+        }
+        return actions;
+    }();
+
+    std::vector<std::vector<const Action *>> plan;
+    size_t line_number = 0;
+    while (!text.empty()) {
+        const size_t end = text.find('\n');
+        const std::string_view line = trim(text.substr(0, end));
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        line_number++;
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+
+        std::vector<const Action *> joint_action;
+        joint_action.reserve(agents_count);
+        for (std::string_view rest = line;;) {
+            const size_t separator = rest.find('|');
+            std::string_view name = rest.substr(0, separator);
+            name = trim(name.substr(0, name.find('@')));
+            const auto it = actions_by_name.find(name);
+            if (it == actions_by_name.end()) {
+                throw std::invalid_argument("Malformed plan: line " + std::to_string(line_number) + ": unknown action '" +
+                                            std::string(name) + "'");
+            }
+            joint_action.push_back(it->second);
+            if (separator == std::string_view::npos) {
+                break;
+            }
+            rest.remove_prefix(separator + 1);
+        }
+        if (joint_action.size() != agents_count) {
+            throw std::invalid_argument("Malformed plan: line " + std::to_string(line_number) + ": " +
+                                        std::to_string(joint_action.size()) + " actions for " + std::to_string(agents_count) +
+                                        " agents");
+        }
+        plan.push_back(std::move(joint_action));
+    }
+    return plan;
+}
@@ -0,0 +1,168 @@
+#include "plan_writer.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+PlanWriter::PlanWriter(FILE *out, std::istream &in, size_t window)
+    : out_(out),
+      in_(in),
+      window_(std::max<size_t>(window, 1)),
+      writer_(),
+      reader_(),
+      mutex_(),
+      changed_(),
+      pending_(),
+      sent_actions_(),
+      executed_(),
+      sent_(0),
+      acknowledged_(0),
+      appending_(true),
+      done_sending_(false),
+      failed_(false),
+      failed_step_(SIZE_MAX),
+      failed_response_() {}
+
+PlanWriter::~PlanWriter() {
+    if (writer_.joinable()) {
+        finish();
+    }
+}
+
+// The server answers each joint action with one result per agent, e.g. "true|false". Agents whose action
+// failed stay where they are, the others move.
+static std::vector<bool> parseResults(const std::string &response) {
+    std::vector<bool> results;
+    std::istringstream fields(response);
+    std::string field;
+    while (std::getline(fields, field, '|')) {
+        results.push_back(field != "false");
+    }
+    return results;
+}
+
+void PlanWriter::writeActions() {
+    std::string buffer;
+    std::vector<std::vector<const Action *>> batch;
+    while (true) {
+        {
+            // Refill the window once half of it is answered, so batches stay large
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [&] { return failed_ || (!pending_.empty() && sent_ - acknowledged_ <= window_ / 2) || (!appending_ && pending_.empty()); });
+            if (failed_ || pending_.empty()) {
+                break;
+            }
+            const size_t count = std::min(pending_.size(), window_ - (sent_ - acknowledged_));
+            batch.assign(pending_.begin(), pending_.begin() + count);
+            pending_.erase(pending_.begin(), pending_.begin() + count);
+        }
+        buffer.clear();
+        for (const auto &joint_action : batch) {
+            buffer += formatJointAction(joint_action, false);
+            buffer += '\n';
+        }
+        {
+            // Recorded first, the reader looks actions up by their response
+            std::lock_guard<std::mutex> lock(mutex_);
+            sent_actions_.insert(sent_actions_.end(), batch.begin(), batch.end());
+        }
+        fwrite(buffer.data(), 1, buffer.size(), out_);
+        fflush(out_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            sent_ += batch.size();
+        }
+        changed_.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_sending_ = true;
+    }
+    changed_.notify_all();
+}
+
+void PlanWriter::readResponses() {
+    std::string response;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [&] { return acknowledged_ < sent_ || done_sending_; });
+            if (acknowledged_ == sent_) {
+                return;
+            }
+        }
+        const bool received = static_cast<bool>(std::getline(in_, response));
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!received) {
+                if (!failed_) {
+                    failed_ = true;
+                    failed_step_ = acknowledged_;
+                    failed_response_ = "<no response>";
+                }
+                acknowledged_ = sent_;  // The server is gone, nothing more will be answered
+            } else {
+                const std::vector<bool> results = parseResults(response);
+                std::vector<const Action *> executed = sent_actions_[acknowledged_];
+                for (size_t agent = 0; agent < executed.size(); agent++) {
+                    if (agent < results.size() && !results[agent]) {
+                        executed[agent] = &Action::NoOp;
+                    }
+                }
+                if (executed != sent_actions_[acknowledged_] && !failed_) {
+                    failed_ = true;
+                    failed_step_ = acknowledged_;
+                    failed_response_ = response;
+                }
+                executed_.push_back(std::move(executed));
+                acknowledged_++;
+            }
+        }
+        changed_.notify_all();
+        if (!received) {
+            return;
+        }
+    }
+}
+
+void PlanWriter::start() {
+    writer_ = std::thread(&PlanWriter::writeActions, this);
+    reader_ = std::thread(&PlanWriter::readResponses, this);
+}
+
+void PlanWriter::append(const std::vector<std::vector<const Action *>> &joint_actions) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (failed_) {
+            return;
+        }
+        pending_.insert(pending_.end(), joint_actions.begin(), joint_actions.end());
+    }
+    changed_.notify_all();
+}
+
+bool PlanWriter::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        appending_ = false;
+    }
+    changed_.notify_all();
+    writer_.join();
+    reader_.join();
+    return !failed_;
+}
+
+bool PlanWriter::send(const std::vector<std::vector<const Action *>> &plan) {
+    start();
+    append(plan);
+    return finish();
+}
+
+bool PlanWriter::hasFailed() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return failed_;
+}
+
+size_t PlanWriter::getUnfinished() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size() + sent_ - acknowledged_;
+}
@@ -0,0 +1,130 @@
+#include "portfolio.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "heuristic.hpp"
+#include "prioritized_planner.hpp"
+#include "utils.hpp"
+
+// Inflation of h in the weighted A* CBS configuration
+static constexpr size_t WEIGHTED_ASTAR_WEIGHT = 2;
+
+PortfolioSolver::PortfolioSolver(const Level &level, PortfolioMode mode, std::chrono::steady_clock::time_point deadline)
+    : level_(level),
+      mode_(mode),
+      deadline_(deadline),
+      strategies_(),
+      threads_count_(0),
+      validator_(level),
+      cancellation_token_(),
+      results_mutex_(),
+      results_changed_(),
+      results_(),
+      finished_count_(0),
+      winner_idx_(SIZE_MAX) {}
+
+void PortfolioSolver::addStrategy(const std::string &name, PortfolioRunner runner) { strategies_.emplace_back(name, std::move(runner)); }
+
+void PortfolioSolver::addDefaultStrategies() {
+    addStrategy("cbs", [](const Level &level, const CancellationToken &token, std::chrono::steady_clock::time_point deadline) {
+        CBS cbs(level, deadline);
+        cbs.setCancellationToken(&token);
+        return cbs.solve();
+    });
+    addStrategy("cbs+wastar", [](const Level &level, const CancellationToken &token, std::chrono::steady_clock::time_point deadline) {
+        CBS cbs(level, deadline);
+        cbs.setCancellationToken(&token);
+        cbs.setHeuristicFactory([]() -> Heuristic * { return new HeuristicWeightedAStar(WEIGHTED_ASTAR_WEIGHT); });
+        return cbs.solve();
+    });
+    addStrategy("pp", [](const Level &level, const CancellationToken &token, std::chrono::steady_clock::time_point deadline) {
+        CBS cbs(level, deadline);  // Only owns the color groups
+        PrioritizedPlanner prioritized_planner(level, cbs.getGroupStates());
+        prioritized_planner.setDeadline(deadline);
+        prioritized_planner.setCancellationToken(&token);
+        const auto solutions = prioritized_planner.solveWithRestarts();
+        return solutions.empty() ? std::vector<std::vector<const Action *>>() : cbs.mergePlans(solutions);
+    });
+}
+
+void PortfolioSolver::run(size_t strategy_idx) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto plan = strategies_[strategy_idx].second(level_, cancellation_token_, deadline_);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::lock_guard<std::mutex> lock(results_mutex_);
+    PortfolioResult &result = results_[strategy_idx];
+    result.seconds = seconds;
+    result.finished = true;
+    finished_count_++;
+
+    // A cancelled strategy may still return its fallback plan, it only counts if it is valid
+    if (!plan.empty() && validator_.isConflictFree(plan)) {
+        result.solutions = validator_.splitPlan(plan);
+        result.cost = utils::CBS_cost(result.solutions);
+
+        const bool is_first = winner_idx_ == SIZE_MAX;
+        if (is_first || (mode_ == PortfolioMode::BestAtDeadline && result.cost < results_[winner_idx_].cost)) {
+            winner_idx_ = strategy_idx;
+        }
+        if (mode_ == PortfolioMode::FirstValid) {
+            cancellation_token_.cancel();
+        }
+    }
+    results_changed_.notify_all();
+}
+
+std::vector<std::vector<std::vector<const Action *>>> PortfolioSolver::solve() {
+    results_.clear();
+    for (const auto &[name, runner] : strategies_) {
+        results_.push_back({name, {}, SIZE_MAX, 0.0, false});
+    }
+    const size_t threads_count = threads_count_ ? std::min(threads_count_, strategies_.size()) : strategies_.size();
+    fprintf(stderr, "Portfolio racing %zu strategies on %zu threads.\n", strategies_.size(), threads_count);
+
+    // Each thread takes the next strategy when its own finishes. Strategies never started once the portfolio is
+    // cancelled still count as finished.
+    std::atomic<size_t> next_strategy(0);
+    std::vector<std::thread> threads;
+    threads.reserve(threads_count);
+    for (size_t t = 0; t < threads_count; t++) {
+        threads.emplace_back([this, &next_strategy]() {
+            for (size_t i = next_strategy++; i < strategies_.size(); i = next_strategy++) {
+                if (cancellation_token_.isCancelled()) {
+                    std::lock_guard<std::mutex> lock(results_mutex_);
+                    finished_count_++;
+                    continue;
+                }
+                run(i);
+            }
+        });
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(results_mutex_);
+        results_changed_.wait_until(lock, deadline_, [this]() {
+            return finished_count_ == strategies_.size() || (mode_ == PortfolioMode::FirstValid && winner_idx_ != SIZE_MAX);
+        });
+    }
+    cancellation_token_.cancel();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (const auto &result : results_) {
+        if (result.cost == SIZE_MAX) {
+            fprintf(stderr, "Portfolio strategy %s failed after %.3f s.\n", result.name.c_str(), result.seconds);
+        } else {
+            fprintf(stderr, "Portfolio strategy %s found cost %zu after %.3f s.\n", result.name.c_str(), result.cost, result.seconds);
+        }
+    }
+
+    const PortfolioResult *winner = getWinner();
+    if (!winner) {
+        return {};
+    }
+    fprintf(stderr, "Portfolio winner: %s.\n", winner->name.c_str());
+    return winner->solutions;
+}
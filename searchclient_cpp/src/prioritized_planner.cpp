@@ -0,0 +1,121 @@
+#include "prioritized_planner.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <set>
+
+#include "search_config.hpp"
+
+// Above this many orders, random restarts stop tracking which orders were already tried
+static constexpr size_t MAX_TRACKED_ORDERS = 100'000;
+
+PrioritizedPlanner::PrioritizedPlanner(const Level &level, const std::vector<LowLevelState *> &group_states, unsigned int seed)
+    : group_states_(group_states),
+      group_searches_(),
+      reservations_(level.static_level),
+      random_generator_(seed),
+      deadline_(std::chrono::steady_clock::time_point::max()),
+      cancellation_token_(nullptr),
+      generated_states_count_(0),
+      attempts_count_(0) {
+    group_searches_.reserve(group_states_.size());
+    for (auto group_state : group_states_) {
+        group_searches_.push_back(new Graphsearch(group_state, SearchConfig::active.makeFrontier(SearchConfig::active.makeHeuristic())));
+    }
+}
+
+PrioritizedPlanner::~PrioritizedPlanner() {
+    for (auto search : group_searches_) {
+        delete search;
+    }
+}
+
+void PrioritizedPlanner::setDeadline(const std::chrono::steady_clock::time_point &deadline) {
+    deadline_ = deadline;
+    for (auto search : group_searches_) {
+        search->setDeadline(deadline);
+    }
+}
+
+void PrioritizedPlanner::setCancellationToken(const CancellationToken *cancellation_token) {
+    cancellation_token_ = cancellation_token;
+    for (auto search : group_searches_) {
+        search->setCancellationToken(cancellation_token);
+    }
+}
+
+bool PrioritizedPlanner::replan(const std::vector<size_t> &order, std::vector<std::vector<std::vector<const Action *>>> &solutions) {
+    attempts_count_++;
+    reservations_.clear();
+
+    std::vector<bool> is_replanned(group_states_.size(), false);
+    for (size_t group_idx : order) {
+        is_replanned[group_idx] = true;
+    }
+
+    for (size_t group_idx = 0; group_idx < group_states_.size(); group_idx++) {
+        if (is_replanned[group_idx]) {
+            for (const auto &cell : group_states_[group_idx]->getOccupiedCells()) {
+                reservations_.block(cell);
+            }
+            continue;
+        }
+        reservations_.reservePlan(*group_states_[group_idx], solutions[group_idx]);
+    }
+
+    for (size_t group_idx : order) {
+        for (const auto &cell : group_states_[group_idx]->getOccupiedCells()) {
+            reservations_.unblock(cell);
+        }
+
+        Graphsearch *search = group_searches_[group_idx];
+        auto plan = search->solve({}, &reservations_);
+        generated_states_count_ += search->getGeneratedStatesCount();
+        if (!search->wasSolutionFound()) {
+            return false;
+        }
+
+        reservations_.reservePlan(*group_states_[group_idx], plan);
+        solutions[group_idx] = std::move(plan);
+    }
+    return true;
+}
+
+std::vector<std::vector<std::vector<const Action *>>> PrioritizedPlanner::solve(const std::vector<size_t> &order) {
+    std::vector<std::vector<std::vector<const Action *>>> solutions(group_states_.size());
+    if (!replan(order, solutions)) {
+        return {};
+    }
+    return solutions;
+}
+
+std::vector<std::vector<std::vector<const Action *>>> PrioritizedPlanner::solveWithRestarts() {
+    std::vector<size_t> order(group_states_.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    // Number of distinct orders, saturated well above anything reachable in time
+    size_t orders_count = 1;
+    for (size_t i = 2; i <= order.size() && orders_count < MAX_TRACKED_ORDERS; i++) {
+        orders_count *= i;
+    }
+    std::set<std::vector<size_t>> tried_orders;
+
+    while (std::chrono::steady_clock::now() < deadline_ && !isCancelled()) {
+        tried_orders.insert(order);
+        auto solutions = solve(order);
+        if (!solutions.empty()) {
+            return solutions;
+        }
+        if (tried_orders.size() >= orders_count) {
+            return {};  // Every order failed
+        }
+        if (Memory::getUsage() > Memory::maxUsage) {
+            fprintf(stderr, "Maximum memory usage exceeded in prioritized planning.\n");
+            return {};
+        }
+        do {
+            std::shuffle(order.begin(), order.end(), random_generator_);
+        } while (orders_count < MAX_TRACKED_ORDERS && tried_orders.count(order));
+    }
+    return {};
+}
@@ -0,0 +1,88 @@
+#include "reservation_table.hpp"
+
+#include <algorithm>
+
+ReservationTable::ReservationTable(const StaticLevel &static_level)
+    : cols_(static_level.getSize().c),
+      cells_count_(static_level.getSize().r * static_level.getSize().c),
+      words_per_step_((cells_count_ + BITS_PER_WORD - 1) / BITS_PER_WORD),
+      horizon_(0),
+      steps_(),
+      blocked_(words_per_step_, 0),
+      permanent_from_(cells_count_, SIZE_MAX),
+      last_reserved_at_(cells_count_, SIZE_MAX) {}
+
+void ReservationTable::clear() {
+    horizon_ = 0;
+    steps_.clear();
+    std::fill(blocked_.begin(), blocked_.end(), 0);
+    std::fill(permanent_from_.begin(), permanent_from_.end(), SIZE_MAX);
+    std::fill(last_reserved_at_.begin(), last_reserved_at_.end(), SIZE_MAX);
+}
+
+void ReservationTable::ensureHorizon(size_t t) {
+    if (t < horizon_) {
+        return;
+    }
+    horizon_ = t + 1;
+    steps_.resize(horizon_ * words_per_step_, 0);
+}
+
+void ReservationTable::reserve(const Cell2D &cell, size_t t) {
+    ensureHorizon(t);
+    const size_t idx = index(cell);
+    steps_[t * words_per_step_ + idx / BITS_PER_WORD] |= uint64_t(1) << (idx % BITS_PER_WORD);
+
+    size_t &last = last_reserved_at_[idx];
+    if (last == SIZE_MAX || last < t) {
+        last = t;
+    }
+}
+
+void ReservationTable::reserveFrom(const Cell2D &cell, size_t t) {
+    ensureHorizon(t);
+    size_t &from = permanent_from_[index(cell)];
+    from = std::min(from, t);
+}
+
+void ReservationTable::block(const Cell2D &cell) {
+    const size_t idx = index(cell);
+    blocked_[idx / BITS_PER_WORD] |= uint64_t(1) << (idx % BITS_PER_WORD);
+}
+
+void ReservationTable::unblock(const Cell2D &cell) {
+    const size_t idx = index(cell);
+    blocked_[idx / BITS_PER_WORD] &= ~(uint64_t(1) << (idx % BITS_PER_WORD));
+}
+
+void ReservationTable::reservePlan(const LowLevelState &initial_state, const std::vector<std::vector<const Action *>> &plan) {
+    LowLevelState state(initial_state);
+    for (size_t t = 0; t < plan.size(); t++) {
+        for (const auto &cell : state.getOccupiedCells()) {
+            reserve(cell, t);
+        }
+        state.applyActions(plan[t]);
+    }
+    for (const auto &cell : state.getOccupiedCells()) {
+        reserveFrom(cell, plan.size());
+    }
+}
+
+bool ReservationTable::isReserved(const Cell2D &cell, size_t t) const {
+    const size_t idx = index(cell);
+    if (testBit(blocked_.data(), idx) || permanent_from_[idx] <= t) {
+        return true;
+    }
+    if (t >= horizon_) {
+        return false;
+    }
+    return testBit(steps_.data() + t * words_per_step_, idx);
+}
+
+bool ReservationTable::isReservedFrom(const Cell2D &cell, size_t t) const {
+    const size_t idx = index(cell);
+    if (testBit(blocked_.data(), idx) || permanent_from_[idx] != SIZE_MAX) {
+        return true;
+    }
+    return last_reserved_at_[idx] != SIZE_MAX && last_reserved_at_[idx] >= t;
+}
@@ -0,0 +1,178 @@
+#include "search_config.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+
+#include "memory.hpp"
+#include "utils.hpp"
+
+SearchConfig SearchConfig::active;
+
+static const std::vector<std::string> SOLVERS = {"cbs", "pp", "portfolio", "portfolio-best", "stream", "windowed"};
+static const std::vector<std::string> FRONTIERS = {"bestfirst", "bfs", "dfs"};
+static const std::vector<std::string> HEURISTICS = {"astar", "wastar", "greedy"};
+
+static bool isOneOf(const std::string &value, const std::vector<std::string> &names) {
+    return std::find(names.begin(), names.end(), value) != names.end();
+}
+
+// A non-negative integer no larger than `max`
+static size_t parseCount(const std::string &key, const std::string &value, size_t max = SIZE_MAX) {
+    size_t parsed_chars = 0;
+    size_t count = 0;
+    try {
+        count = std::stoul(value, &parsed_chars);
+    } catch (const std::logic_error &) {
+        parsed_chars = 0;
+    }
+    if (parsed_chars == 0 || parsed_chars != value.size() || value[0] == '-' || count > max) {
+        throw std::invalid_argument("Invalid value for " + key + ": '" + value + "'");
+    }
+    return count;
+}
+
+SearchConfig::SearchConfig()
+    : solver("cbs"),
+      frontier("bestfirst"),
+      heuristic("astar"),
+      weight(2),
+      threads(0),
+      memory_mb(Memory::maxUsage),
+      time_limit(150),  // Keeps headroom below the server timeout
+      window(DEFAULT_CONFLICT_WINDOW),
+      level_cache(),
+      stats() {}
+
+void SearchConfig::set(const std::string &key, const std::string &raw_value) {
+    const std::string value = utils::trim(raw_value);
+    if (key == "solver" && isOneOf(utils::toLower(value), SOLVERS)) {
+        solver = utils::toLower(value);
+    } else if (key == "frontier" && isOneOf(utils::toLower(value), FRONTIERS)) {
+        frontier = utils::toLower(value);
+    } else if (key == "heuristic" && isOneOf(utils::toLower(value), HEURISTICS)) {
+        heuristic = utils::toLower(value);
+    } else if (key == "weight") {
+        weight = std::max<size_t>(parseCount(key, value), 1);
+    } else if (key == "threads") {
+        threads = parseCount(key, value);
+    } else if (key == "memory") {
+        memory_mb = parseCount(key, value, UINT32_MAX);
+    } else if (key == "timeout") {
+        time_limit = std::chrono::seconds(parseCount(key, value));
+    } else if (key == "window") {
+        window = std::max<size_t>(parseCount(key, value), 1);
+    } else if (key == "level-cache") {
+        level_cache = value;
+    } else if (key == "stats") {
+        stats = value;
+    } else if (key == "solver" || key == "frontier" || key == "heuristic") {
+        throw std::invalid_argument("Invalid value for " + key + ": '" + value + "'");
+    } else {
+        throw std::invalid_argument("Unknown setting: " + key);
+    }
+}
+
+void SearchConfig::loadFile(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::invalid_argument("Cannot open config file: " + path);
+    }
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        line = utils::trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+        const size_t separator = line.find('=');
+        if (separator == std::string::npos) {
+            throw std::invalid_argument(path + ":" + std::to_string(line_number) + ": expected key = value");
+        }
+        set(utils::trim(line.substr(0, separator)), line.substr(separator + 1));
+    }
+}
+
+void SearchConfig::parseArgs(const std::vector<std::string> &args) {
+    for (size_t i = 0; i + 1 < args.size(); i++) {
+        if (args[i] == "--config") {
+            loadFile(args[i + 1]);
+        }
+    }
+
+    std::vector<std::string> positional;
+    for (size_t i = 0; i < args.size(); i++) {
+        if (args[i].rfind("--", 0) != 0) {
+            positional.push_back(args[i]);
+            continue;
+        }
+        if (i + 1 == args.size()) {
+            throw std::invalid_argument("Missing value for " + args[i]);
+        }
+        const std::string key = args[i].substr(2);
+        const std::string &value = args[++i];
+        if (key != "config") {
+            set(key, value);
+        }
+    }
+    if (positional.empty()) {
+        return;
+    }
+
+    // The strategy names of earlier versions: a solver, frontier or heuristic, or several joined by '+'
+    const std::string strategy = utils::toLower(positional[0]);
+    for (size_t start = 0; start <= strategy.size();) {
+        const size_t end = std::min(strategy.find('+', start), strategy.size());
+        const std::string part = strategy.substr(start, end - start);
+        start = end + 1;
+        if (isOneOf(part, SOLVERS)) {
+            solver = part;
+        } else if (isOneOf(part, FRONTIERS)) {
+            frontier = part;
+        } else if (isOneOf(part, HEURISTICS)) {
+            heuristic = part;
+        } else {
+            fprintf(stderr, "Unknown strategy part '%s' ignored.\n", part.c_str());
+        }
+    }
+    if (positional.size() > 1) {
+        set(solver == "windowed" ? "window" : "weight", positional[1]);
+    }
+}
+
+Heuristic *SearchConfig::makeHeuristic() const {
+    if (heuristic == "wastar") {
+        return new HeuristicWeightedAStar(weight);
+    }
+    if (heuristic == "greedy") {
+        return new HeuristicGreedy();
+    }
+    return new HeuristicAStar();
+}
+
+Frontier *SearchConfig::makeFrontier(Heuristic *ordering) const {
+    if (frontier == "bfs") {
+        delete ordering;
+        return new FrontierBFS();
+    }
+    if (frontier == "dfs") {
+        delete ordering;
+        return new FrontierDFS();
+    }
+    return new FrontierBestFirst(ordering);
+}
+
+std::string SearchConfig::toString() const {
+    std::string result = "solver " + solver + ", " + frontier;
+    if (frontier == "bestfirst") {
+        result += " with " + heuristic + (heuristic == "wastar" ? " (weight " + std::to_string(weight) + ")" : "");
+    }
+    if (solver == "windowed") {
+        result += ", window " + std::to_string(window);
+    }
+    result += ", " + (threads ? std::to_string(threads) : std::string("all")) + " portfolio threads";
+    result += ", " + std::to_string(memory_mb) + " MB, " + std::to_string(time_limit.count()) + " s";
+    return result;
+}
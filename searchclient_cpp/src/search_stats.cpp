@@ -0,0 +1,153 @@
+#include "search_stats.hpp"
+
+#ifdef USE_SEARCH_STATS
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <mutex>
+
+#include "low_level_state.hpp"
+
+namespace SearchStats {
+bool enabled = false;
+
+struct Replans {
+    uint64_t calls;
+    std::chrono::steady_clock::duration time;
+};
+
+struct Totals {
+    uint64_t counters[COUNTERS_COUNT];
+    std::chrono::steady_clock::duration timers[TIMERS_COUNT];
+    uint64_t peaks[PEAKS_COUNT];
+    std::map<std::string, Replans> replans;  // By the agents of the group
+
+    Totals() : counters(), timers(), peaks(), replans() {}
+
+    void merge(const Totals &other) {
+        for (size_t i = 0; i < COUNTERS_COUNT; i++) {
+            counters[i] += other.counters[i];
+        }
+        for (size_t i = 0; i < TIMERS_COUNT; i++) {
+            timers[i] += other.timers[i];
+        }
+        for (size_t i = 0; i < PEAKS_COUNT; i++) {
+            peaks[i] = std::max(peaks[i], other.peaks[i]);
+        }
+        for (const auto &[group, group_replans] : other.replans) {
+            Replans &merged = replans.try_emplace(group, Replans{0, {}}).first->second;
+            merged.calls += group_replans.calls;
+            merged.time += group_replans.time;
+        }
+    }
+};
+
+static std::mutex totals_mutex;
+static Totals totals;
+
+// Merged into the totals when its thread ends
+struct ThreadStats : Totals {
+    ~ThreadStats() {
+        std::lock_guard<std::mutex> lock(totals_mutex);
+        totals.merge(*this);
+    }
+};
+
+static ThreadStats &local() {
+    thread_local ThreadStats stats;
+    return stats;
+}
+
+void addToLocal(Counter counter, uint64_t count) { local().counters[counter] += count; }
+
+void addTimeToLocal(Timer timer, std::chrono::steady_clock::duration time) { local().timers[timer] += time; }
+
+void addReplanToLocal(const LowLevelState &group, std::chrono::steady_clock::duration time) {
+    std::string name;
+    for (const auto &agent : group.agents) {
+        name += agent.getSymbol();
+    }
+    Replans &replans = local().replans.try_emplace(name, Replans{0, {}}).first->second;
+    replans.calls++;
+    replans.time += time;
+}
+
+void updateLocalPeak(Peak peak, uint64_t value) { local().peaks[peak] = std::max(local().peaks[peak], value); }
+
+static double toMs(std::chrono::steady_clock::duration time) { return std::chrono::duration<double, std::milli>(time).count(); }
+
+std::string toJson() {
+    Totals run;
+    {
+        std::lock_guard<std::mutex> lock(totals_mutex);
+        run = totals;
+    }
+    run.merge(local());
+
+    struct rusage usage;
+    const long peak_memory_kb = getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+
+    char buffer[1024];
+    snprintf(buffer, sizeof(buffer),
+             "{\n"
+             "    \"ct_nodes_expanded\": %llu,\n"
+             "    \"ct_nodes_generated\": %llu,\n"
+             "    \"ct_duplicates_pruned\": %llu,\n"
+             "    \"low_level_calls\": %llu,\n"
+             "    \"low_level_expanded\": %llu,\n"
+             "    \"low_level_generated\": %llu,\n"
+             "    \"low_level_duplicates_pruned\": %llu,\n"
+             "    \"heuristic_ms\": %.3f,\n"
+             "    \"conflict_detection_ms\": %.3f,\n"
+             "    \"low_level_search_ms\": %.3f,\n"
+             "    \"peak_states_held\": %llu,\n"
+             "    \"peak_memory_kb\": %ld,\n"
+             "    \"replans\": {",
+             static_cast<unsigned long long>(run.counters[CT_NODES_EXPANDED]),
+             static_cast<unsigned long long>(run.counters[CT_NODES_GENERATED]),
+             static_cast<unsigned long long>(run.counters[CT_DUPLICATES_PRUNED]),
+             static_cast<unsigned long long>(run.counters[LOW_LEVEL_CALLS]),
+             static_cast<unsigned long long>(run.counters[LOW_LEVEL_EXPANDED]),
+             static_cast<unsigned long long>(run.counters[LOW_LEVEL_GENERATED]),
+             static_cast<unsigned long long>(run.counters[LOW_LEVEL_DUPLICATES_PRUNED]), toMs(run.timers[HEURISTIC]),
+             toMs(run.timers[CONFLICT_DETECTION]), toMs(run.timers[LOW_LEVEL_SEARCH]),
+             static_cast<unsigned long long>(run.peaks[STATES_HELD]), peak_memory_kb);
+    std::string json = buffer;
+
+    // Agent symbols are digits, the group names need no escaping
+    bool first = true;
+    for (const auto &[group, replans] : run.replans) {
+        snprintf(buffer, sizeof(buffer), "%s\n        \"%s\": {\"calls\": %llu, \"ms\": %.3f}", first ? "" : ",", group.c_str(),
+                 static_cast<unsigned long long>(replans.calls), toMs(replans.time));
+        json += buffer;
+        first = false;
+    }
+    json += first ? "}\n}" : "\n    }\n}";
+    return json;
+}
+
+bool exportJson(const std::string &path) {
+    const std::string json = toJson();
+    if (path == "-") {
+        fprintf(stderr, "Search statistics: %s\n", json.c_str());
+        return true;
+    }
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    fprintf(file, "%s\n", json.c_str());
+    return fclose(file) == 0;
+}
+
+void reset() {
+    std::lock_guard<std::mutex> lock(totals_mutex);
+    totals = Totals();
+    static_cast<Totals &>(local()) = Totals();
+}
+}  // namespace SearchStats
+
+#endif
@@ -1,5 +1,7 @@
 // C++ related
 #include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <iostream>
 #include <limits>
 #include <sstream>
@@ -11,9 +13,18 @@
 #include <cctype>
 
 // Own code
+#include "batch_runner.hpp"
 #include "cbs.hpp"
 #include "feature_flags.hpp"
 #include "level.hpp"
+#include "level_cache.hpp"
+#include "memory.hpp"
+#include "online_executor.hpp"
+#include "plan_validator.hpp"
+#include "search_config.hpp"
+#include "search_stats.hpp"
+#include "solver.hpp"
+#include "utils.hpp"
 
 /*
 For a text to be treated as a comment, it must be sent via:
@@ -21,22 +32,146 @@ For a text to be treated as a comment, it must be sent via:
 - stdout - starting with #
 */
 
-int main(int argc, char *argv[]) {
-    (void)argc;
-    (void)argv;
-    fprintf(stderr, "C++ SearchClient initializing.\n");
+// Malformed levels end the client, there is nothing to plan. With a cache, a level seen before is restored from its
+// snapshot instead of being parsed and analysed, and new levels are added to it.
+static Level readLevel(const LevelCache *cache) {
+    try {
+        const std::string text = readLevelText(std::cin);
+        if (!cache) {
+            return parseLevel(text);
+        }
+        const auto start = std::chrono::steady_clock::now();
+        Level *cached = cache->load(text);
+        if (cached) {
+            Level level(std::move(*cached));
+            delete cached;
+            fprintf(stderr, "Level restored from %s in %.2f ms.\n", cache->getPath(LevelCache::hashText(text)).c_str(),
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            return level;
+        }
+        const Level level = parseLevel(text);
+        if (!cache->store(text, level)) {
+            fprintf(stderr, "Unable to write the level cache %s.\n", cache->getPath(LevelCache::hashText(text)).c_str());
+        }
+        return level;
+    } catch (const std::invalid_argument &e) {
+        fprintf(stderr, "%s\n", e.what());
+        exit(1);
+    }
+}
 
-    // Send client name to server.
-    fprintf(stdout, "SearchClient\n");
+// Writes the snapshots of level files ahead of a benchmark sweep
+static int precompileLevels(const LevelCache &cache, const std::vector<std::string> &paths) {
+    for (const auto &path : paths) {
+        try {
+            const std::string text = readLevelFile(path);
+            if (!cache.store(text, parseLevel(text))) {
+                fprintf(stderr, "Unable to write the level cache for %s.\n", path.c_str());
+                return 1;
+            }
+            fprintf(stderr, "%s -> %s\n", path.c_str(), cache.getPath(LevelCache::hashText(text)).c_str());
+        } catch (const std::invalid_argument &e) {
+            fprintf(stderr, "%s: %s\n", path.c_str(), e.what());
+            return 1;
+        }
+    }
+    return 0;
+}
 
-    fprintf(stderr, "Feature flags: %s\n", getFeatureFlags());
+// Checks a saved plan against a level file, without the server
+static int validatePlan(const std::string &level_path, const std::string &plan_path) {
+    try {
+        const Level level = loadLevelFile(level_path);
+        std::ifstream plan_file(plan_path);
+        if (!plan_file) {
+            throw std::invalid_argument("Cannot open plan file: " + plan_path);
+        }
+        std::stringstream plan_text;
+        plan_text << plan_file.rdbuf();
+        const auto plan = PlanValidator::parsePlan(plan_text.str(), level.agents.size());
+        const auto start = std::chrono::steady_clock::now();
+        const PlanReport report = PlanValidator(level).validate(plan);
+        const double elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        if (!report.solved) {
+            fprintf(stdout, "%s: %s.\n", report.valid ? "Unsolved" : "Invalid", report.error.c_str());
+            return 1;
+        }
+        fprintf(stdout, "Solved: makespan %zu, sum of costs %zu, fuel %zu (validated in %.1f us).\n", report.makespan,
+                report.sum_of_costs, report.fuel, elapsed_us);
+        return 0;
+    } catch (const std::invalid_argument &e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+}
 
-    Level level = loadLevel(std::cin);
-    fprintf(stderr, "Loaded %s\n", level.toString().c_str());
+// searchclient --batch DIR|LEVEL [--workers N] [--output FILE] [search options] [strategy]
+// The search options are those of SearchConfig, the forked workers inherit them. The timeout defaults to the
+// shorter BatchOptions one.
+static int runBatch(const std::vector<std::string> &args) {
+    BatchOptions options;
+    options.levels_dir = args[1];
+    std::string output;
+    std::vector<std::string> search_args;
+    SearchConfig &config = SearchConfig::active;
+    config.time_limit = options.timeout;
+    try {
+        for (size_t i = 2; i < args.size(); i++) {
+            const bool has_value = i + 1 < args.size();
+            if (args[i] == "--workers" && has_value) {
+                options.workers = std::max<size_t>(std::stoul(args[++i]), 1);
+            } else if (args[i] == "--output" && has_value) {
+                output = args[++i];
+            } else {
+                search_args.push_back(args[i]);
+            }
+        }
+        config.parseArgs(search_args);
+    } catch (const std::logic_error &e) {
+        fprintf(stderr, "Invalid batch option: %s\n", e.what());
+        return 1;
+    }
+    options.strategy = config.solver;
+    options.timeout = config.time_limit;
+    options.memory_limit_mb = config.memory_mb;
+    options.cache_dir = config.level_cache;
+    if (!config.stats.empty()) {
+        fprintf(stderr, "Search statistics are only exported by single runs, --stats ignored.\n");
+    }
+    fprintf(stderr, "Search config: %s\n", config.toString().c_str());
+
+    FILE *out = output.empty() ? stdout : fopen(output.c_str(), "w");
+    if (!out) {
+        fprintf(stderr, "Unable to write %s.\n", output.c_str());
+        return 1;
+    }
+    const int status = BatchRunner(options).run(out);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return status;
+}
 
-    fprintf(stderr, "Starting CBS...\n");
-    CBS cbs = CBS(level);
-    std::vector<std::vector<const Action *>> plan = cbs.solve();
+// Plans the loaded level with `config` and sends the plan to the server
+static int searchLevel(const Level &level, const SearchConfig &config) {
+    const auto deadline = std::chrono::steady_clock::now() + config.time_limit;
+    if (config.solver == "stream") {
+        fprintf(stderr, "Starting CBS with streaming execution...\n");
+        OnlineExecutor(stdout, std::cin).stream(level, deadline);
+        return 0;
+    }
+    if (config.solver == "windowed") {
+        fprintf(stderr, "Starting windowed CBS, window %zu...\n", config.window);
+        OnlineExecutor(stdout, std::cin).stream(level, deadline, config.window);
+        return 0;
+    }
+    CBS cbs(level, deadline);
+    SolveStats stats;
+    const std::vector<std::vector<const Action *>> plan = solveLevel(level, cbs, config.solver, deadline, &stats);
+    if (!stats.portfolio_winner.empty()) {
+        // Picked up by the benchmarks for per-strategy win statistics
+        fprintf(stdout, "#portfolio-winner: %s\n", stats.portfolio_winner.c_str());
+    }
 
     // Print plan to server
     if (plan.empty()) {
@@ -47,17 +182,58 @@ int main(int argc, char *argv[]) {
 
 #ifdef DISABLE_ACTION_PRINTING
 #else
-    for (const auto &joint_action : plan) {
-        auto s = formatJointAction(joint_action, false);
-
-        fprintf(stdout, "%s\n", s.c_str());
-        fflush(stdout);
-
-        // Read server's response to not fill up the stdin buffer and block the server.
-        std::string response;
-        getline(std::cin, response);
-    }
+    OnlineExecutor(stdout, std::cin).execute(level, cbs, plan, deadline);
     fprintf(stderr, "--------------------------------\n");
 #endif
     return 0;
+}
+
+int main(int argc, char *argv[]) {
+    // searchclient [--config FILE] [--solver S] [--frontier F] [--heuristic H] [--weight W] [--threads N]
+    //              [--memory MB] [--timeout S] [--window W] [--level-cache DIR] [--stats FILE|-] [strategy [window|weight]]
+    // searchclient --precompile DIR level.lvl...
+    // searchclient --batch DIR|LEVEL [options] [strategy], see runBatch
+    // searchclient --validate level.lvl plan.txt
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (args.size() == 3 && args[0] == "--validate") {
+        return validatePlan(args[1], args[2]);
+    }
+    if (args.size() >= 2 && args[0] == "--batch") {
+        return runBatch(args);
+    }
+    if (args.size() >= 2 && args[0] == "--precompile") {
+        return precompileLevels(LevelCache(args[1]), std::vector<std::string>(args.begin() + 2, args.end()));
+    }
+    SearchConfig &config = SearchConfig::active;
+    try {
+        config.parseArgs(args);
+    } catch (const std::invalid_argument &e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    Memory::maxUsage = config.memory_mb;
+    LevelCache *cache = config.level_cache.empty() ? nullptr : new LevelCache(config.level_cache);
+    fprintf(stderr, "C++ SearchClient initializing.\n");
+
+    // Send client name to server.
+    fprintf(stdout, "SearchClient\n");
+
+    fprintf(stderr, "Feature flags: %s\n", getFeatureFlags());
+    fprintf(stderr, "Search config: %s\n", config.toString().c_str());
+
+    Level level = readLevel(cache);
+    delete cache;
+    fprintf(stderr, "Loaded %s\n", level.toString().c_str());
+
+    if (!config.stats.empty()) {
+#ifndef USE_SEARCH_STATS
+        fprintf(stderr, "Search statistics are compiled out, see USE_SEARCH_STATS.\n");
+#endif
+        SearchStats::enable();
+    }
+    const int status = searchLevel(level, config);
+    if (!config.stats.empty() && !SearchStats::exportJson(config.stats)) {
+        fprintf(stderr, "Unable to write the search statistics to %s.\n", config.stats.c_str());
+    }
+    return status;
 }
\ No newline at end of file
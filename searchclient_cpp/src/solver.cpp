@@ -0,0 +1,68 @@
+#include "solver.hpp"
+
+#include <algorithm>
+
+#include "feature_flags.hpp"
+#include "lns.hpp"
+#include "portfolio.hpp"
+#include "prioritized_planner.hpp"
+#include "search_config.hpp"
+
+// Time spent improving the first solution with LNS, still capped by the search deadline
+static constexpr std::chrono::seconds LNS_TIME_LIMIT(5);
+static constexpr size_t LNS_NEIGHBORHOOD_SIZE = 4;
+// Time spent shifting actions into earlier NoOps, still capped by the search deadline
+static constexpr std::chrono::seconds COMPRESSION_TIME_LIMIT(2);
+
+std::vector<std::vector<const Action *>> solveLevel(const Level &level, CBS &cbs, const std::string &strategy,
+                                                    std::chrono::steady_clock::time_point deadline, SolveStats *stats) {
+    std::vector<std::vector<std::vector<const Action *>>> solutions;
+    std::string portfolio_winner;
+    if (strategy == "portfolio" || strategy == "portfolio-best") {
+        fprintf(stderr, "Starting portfolio...\n");
+        PortfolioSolver portfolio(level, strategy == "portfolio" ? PortfolioMode::FirstValid : PortfolioMode::BestAtDeadline, deadline);
+        portfolio.addDefaultStrategies();
+        portfolio.setThreadsCount(SearchConfig::active.threads);
+        solutions = portfolio.solve();
+        if (portfolio.getWinner()) {
+            portfolio_winner = portfolio.getWinner()->name;
+        }
+    } else if (strategy == "pp") {
+        fprintf(stderr, "Starting prioritized planning...\n");
+        PrioritizedPlanner prioritized_planner(level, cbs.getGroupStates());
+        prioritized_planner.setDeadline(deadline);
+        solutions = prioritized_planner.solveWithRestarts();
+    } else {
+        fprintf(stderr, "Starting CBS...\n");
+        cbs.solve();
+        solutions = cbs.getSolutions();
+    }
+
+#ifdef USE_LNS_POST_OPTIMIZATION
+    if (!solutions.empty()) {
+        LargeNeighborhoodSearch lns(level, cbs.getGroupStates(), LNS_NEIGHBORHOOD_SIZE);
+        lns.setDeadline(std::min(deadline, std::chrono::steady_clock::now() + LNS_TIME_LIMIT));
+        solutions = lns.improve(std::move(solutions));
+    }
+#endif
+
+    std::vector<std::vector<const Action *>> plan;
+    if (!solutions.empty()) {
+        plan = cbs.mergePlans(solutions);
+    }
+
+#ifdef USE_PLAN_COMPRESSION
+    plan = cbs.compressPlan(std::move(plan), std::min(deadline, std::chrono::steady_clock::now() + COMPRESSION_TIME_LIMIT));
+#endif
+
+#ifdef USE_DEADLOCK_PRUNING
+    fprintf(stderr, "Deadlock pruning: %zu box moves into dead squares.\n", LowLevelState::dead_square_prunes.load());
+#endif
+
+    if (stats) {
+        stats->expanded = cbs.getExpandedStatesCount();
+        stats->generated = cbs.getGeneratedStatesCount();
+        stats->portfolio_winner = portfolio_winner;
+    }
+    return plan;
+}
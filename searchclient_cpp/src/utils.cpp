@@ -1,10 +1,13 @@
 #include "utils.hpp"
 
 #include <algorithm>
+#include <limits>
 #include <numeric>
 #include <string>
 #include <vector>
 
+#include "assignment.hpp"
+
 namespace utils {
 // Define the extern variable
 std::string whitespaces = " \t\n\r\f\v";
@@ -88,4 +91,35 @@ size_t CBS_cost(const std::vector<std::vector<std::vector<const Action *>>> &sol
     // return SIC(solutions);
 }
 
+/*
+    Hungarian algorithm with row and column potentials, O(rows^2 * cols).
+    Row i gets column assignment[i], no two rows share a column. Requires rows <= cols.
+*/
+std::vector<size_t> minCostAssignment(const std::vector<std::vector<size_t>> &costs) {
+    const size_t rows = costs.size();
+    if (rows == 0) {
+        return {};
+    }
+    const size_t cols = costs[0].size();
+    // Unreachable pairs stay expensive without overflowing the potentials
+    const long long forbidden = std::numeric_limits<long long>::max() / 4 / (long long)(cols + 1);
+
+    // Padding rows match the columns left over at no cost
+    Assignment assignment(cols);
+    std::vector<long long> row_costs(cols, 0);
+    for (size_t row = 0; row < cols; row++) {
+        for (size_t col = 0; col < cols; col++) {
+            row_costs[col] = row >= rows ? 0 : costs[row][col] == SIZE_MAX ? forbidden : (long long)costs[row][col];
+        }
+        assignment.setRow(row, row_costs);
+    }
+    assignment.solve();
+
+    std::vector<size_t> columns(rows);
+    for (size_t row = 0; row < rows; row++) {
+        columns[row] = assignment.getColumn(row);
+    }
+    return columns;
+}
+
 }  // namespace utils
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "assignment.hpp"
+#include "utils.hpp"
+
+void test_square_assignment() {
+    // Greedy would take the 1 in the first row and pay 100 for the second one
+    const std::vector<std::vector<size_t>> costs = {
+        {1, 2},
+        {2, 100},
+    };
+    const auto columns = utils::minCostAssignment(costs);
+    assert(columns.size() == 2);
+    assert(columns[0] == 1);
+    assert(columns[1] == 0);
+}
+
+void test_rectangular_assignment() {
+    const std::vector<std::vector<size_t>> costs = {
+        {7, 3, 9, 4},
+        {2, 3, 8, 9},
+    };
+    const auto columns = utils::minCostAssignment(costs);
+    assert(columns.size() == 2);
+    assert(columns[0] == 1);
+    assert(columns[1] == 0);
+}
+
+void test_forbidden_pairs() {
+    const std::vector<std::vector<size_t>> costs = {
+        {SIZE_MAX, 5, 1},
+        {4, SIZE_MAX, SIZE_MAX},
+        {1, 1, SIZE_MAX},
+    };
+    const auto columns = utils::minCostAssignment(costs);
+    assert(columns[0] == 2);
+    assert(columns[1] == 0);
+    assert(columns[2] == 1);
+    assert(utils::minCostAssignment({}).empty());
+}
+
+// Cheapest matching by trying every permutation
+static long long bruteForceCost(const std::vector<std::vector<long long>> &costs) {
+    std::vector<size_t> columns(costs.size());
+    for (size_t i = 0; i < columns.size(); i++) {
+        columns[i] = i;
+    }
+    long long best = -1;
+    do {
+        long long total = 0;
+        for (size_t row = 0; row < costs.size(); row++) {
+            total += costs[row][columns[row]];
+        }
+        if (best < 0 || total < best) {
+            best = total;
+        }
+    } while (std::next_permutation(columns.begin(), columns.end()));
+    return best;
+}
+
+void test_incremental_rows() {
+    std::mt19937 random_generator(7);
+    std::uniform_int_distribution<long long> cost_distribution(0, 20);
+    const size_t size = 6;
+    std::vector<std::vector<long long>> costs(size, std::vector<long long>(size));
+    Assignment assignment(size);
+    for (size_t row = 0; row < size; row++) {
+        for (auto &cost : costs[row]) {
+            cost = cost_distribution(random_generator);
+        }
+        assignment.setRow(row, costs[row]);
+    }
+    assignment.solve();
+    assert(assignment.getCost() == bruteForceCost(costs));
+
+    // Re-costing single rows keeps the matching optimal
+    for (size_t step = 0; step < 50; step++) {
+        const size_t row = random_generator() % size;
+        for (auto &cost : costs[row]) {
+            cost = cost_distribution(random_generator);
+        }
+        assignment.setRow(row, costs[row]);
+        assignment.solve();
+        assert(assignment.getCost() == bruteForceCost(costs));
+
+        std::vector<bool> taken(size, false);
+        for (size_t r = 0; r < size; r++) {
+            assert(!taken[assignment.getColumn(r)]);
+            taken[assignment.getColumn(r)] = true;
+        }
+    }
+}
+
+int main() {
+    test_square_assignment();
+    test_rectangular_assignment();
+    test_forbidden_pairs();
+    test_incremental_rows();
+    std::cout << "All assignment tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "batch_runner.hpp"
+
+static const std::string LEVEL =
+    "#domain\n"
+    "hospital\n"
+    "#levelname\n"
+    "BatchExample\n"
+    "#colors\n"
+    "blue: 0, A\n"
+    "#initial\n"
+    "+++++++\n"
+    "+0A   +\n"
+    "+++++++\n"
+    "#goal\n"
+    "+++++++\n"
+    "+    A+\n"
+    "+++++++\n"
+    "#end\n";
+
+static std::string makeDirectory() {
+    char directory[] = "/tmp/test_batch_runner_XXXXXX";
+    assert(mkdtemp(directory));
+    return directory;
+}
+
+static void writeFile(const std::string &path, const std::string &text) {
+    std::ofstream(path) << text;
+}
+
+static std::string runBatch(const BatchOptions &options, int &status) {
+    FILE *out = tmpfile();
+    assert(out);
+    status = BatchRunner(options).run(out);
+    rewind(out);
+    std::string json;
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), out)) > 0) {
+        json.append(buffer, read);
+    }
+    fclose(out);
+    return json;
+}
+
+void test_solves_levels_in_directory() {
+    const std::string directory = makeDirectory();
+    assert(mkdir((directory + "/nested").c_str(), 0755) == 0);
+    writeFile(directory + "/b.lvl", LEVEL);
+    writeFile(directory + "/nested/a.lvl", LEVEL);
+    writeFile(directory + "/notes.txt", "not a level");
+
+    BatchOptions options;
+    options.levels_dir = directory;
+    options.workers = 2;
+    options.timeout = std::chrono::seconds(5);
+    int status = -1;
+    const std::string json = runBatch(options, status);
+    assert(status == 0);
+
+    // Sorted by path, the text file is skipped
+    const size_t first = json.find("\"level\": \"b.lvl\"");
+    const size_t second = json.find("\"level\": \"nested/a.lvl\"");
+    assert(first != std::string::npos && second != std::string::npos && first < second);
+    assert(json.find("notes.txt") == std::string::npos);
+    assert(json.find("\"solution_length\": 3") != std::string::npos);
+    assert(json.find("\"expanded\": ") != std::string::npos);
+    assert(json.find("\"error\"") == std::string::npos);
+    std::cout << "test_solves_levels_in_directory passed!" << std::endl;
+}
+
+void test_reports_failed_levels() {
+    const std::string directory = makeDirectory();
+    writeFile(directory + "/broken.lvl", "#domain\nhospital\n#end\n");
+
+    BatchOptions options;
+    options.levels_dir = directory;
+    options.workers = 1;
+    options.timeout = std::chrono::seconds(5);
+    int status = -1;
+    const std::string json = runBatch(options, status);
+    assert(status == 0);
+    assert(json.find("\"error\": \"Malformed level") != std::string::npos);
+    assert(json.find("\"solution_length\": 0") != std::string::npos);
+    std::cout << "test_reports_failed_levels passed!" << std::endl;
+}
+
+void test_rejects_streaming_strategies() {
+    BatchOptions options;
+    options.levels_dir = makeDirectory();
+    options.strategy = "stream";
+    int status = 0;
+    runBatch(options, status);
+    assert(status == 1);
+    std::cout << "test_rejects_streaming_strategies passed!" << std::endl;
+}
+
+int main() {
+    test_solves_levels_in_directory();
+    test_reports_failed_levels();
+    test_rejects_streaming_strategies();
+    std::cout << "All batch runner tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,232 @@
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cbs.hpp"
+#include "constraint_table.hpp"
+#include "feature_flags.hpp"
+#include "level.hpp"
+#include "plan_validator.hpp"
+#include "test_helpers.hpp"
+#include "utils.hpp"
+
+using Plan = std::vector<std::vector<const Action *>>;
+
+static size_t groupOf(const CBS &cbs, char agent_symbol) {
+    const auto &groups = cbs.getGroupStates();
+    for (size_t i = 0; i < groups.size(); i++) {
+        for (const auto &agent : groups[i]->agents) {
+            if (agent.getSymbol() == agent_symbol) {
+                return i;
+            }
+        }
+    }
+    assert(false);
+    return SIZE_MAX;
+}
+
+// Solves without the warm start, so the plan is CBS's own, and checks it with the server's rules
+static Plan solveValid(const Level &level, CBS &cbs) {
+    cbs.setWarmStart(false);
+    const Plan plan = cbs.solve();
+    const PlanReport report = PlanValidator(level).validate(plan);
+    if (!report.solved) {
+        std::cerr << report.error << std::endl;
+    }
+    assert(report.solved);
+    return plan;
+}
+
+// Agent 0 walks right behind agent 1 and enters each cell as agent 1 leaves it
+void test_follow_conflict_positive_child() {
+    const Level level = makeLevel("red: 0\nblue: 1\n",
+                                  "+++++++\n"
+                                  "+01   +\n"
+                                  "+++++++\n",
+                                  "+++++++\n"
+                                  "+   01+\n"
+                                  "+++++++\n");
+    CBS cbs(level);
+    const size_t leader_group = groupOf(cbs, '1');
+    const Plan leader_plan = {{&Action::MoveE}, {&Action::MoveE}, {&Action::MoveE}};
+    ConstraintTable constraint_table;
+
+    // The positive child keeps the follower on (1, 2) at 1, the leader may no longer be there at 0
+    for (const Constraint &follower_constraint : {Constraint(Cell2D(1, 2), 1), Constraint::box(Cell2D(1, 2), 1)}) {
+        CTNode positive_child;
+        positive_child.one_sided_conflicts.insert(OneSidedConflict('0', follower_constraint.asPositive()));
+        constraint_table.build(cbs.getGroupConstraints(positive_child, leader_group));
+        assert(!constraint_table.isPlanAllowed(*cbs.getGroupStates()[leader_group], leader_plan));
+    }
+
+    // Agent 0 waits one step
+    assert(solveValid(level, cbs).size() == 4);
+    assert(utils::SIC(cbs.getSolutions()) == 3 + 4);
+    std::cout << "test_follow_conflict_positive_child passed!" << std::endl;
+}
+
+// Agent 1 runs into agent 0 after it finished on its goal. Agent 0 steps aside and comes back, a detour of
+// agent 1 would cost two more steps of makespan.
+void test_target_conflict() {
+    const Level level = makeLevel("red: 0\nblue: 1\n",
+                                  "+++++++++\n"
+                                  "+1 0    +\n"
+                                  "+       +\n"
+                                  "+++++++++\n",
+                                  "+++++++++\n"
+                                  "+   0  1+\n"
+                                  "+       +\n"
+                                  "+++++++++\n");
+    CBS cbs(level);
+    assert(solveValid(level, cbs).size() == 6);
+    assert(cbs.getTargetSplitsCount() == 1 && cbs.getCorridorSplitsCount() == 0 && cbs.getRectangleSplitsCount() == 0);
+    assert(utils::CBS_cost(cbs.getSolutions()) == 10 * 6 + (5 + 6) + 3 * (3 + 6));
+    std::cout << "test_target_conflict passed!" << std::endl;
+}
+
+// The agents swap rooms through a corridor of three cells. One waits beside the corridor until the other is
+// through, and the second one can enter it only after the first one left.
+void test_corridor_conflict() {
+    const Level level = makeLevel("red: 0\nblue: 1\n",
+                                  "+++++++++++\n"
+                                  "+   +++   +\n"
+                                  "+0       1+\n"
+                                  "+   +++   +\n"
+                                  "+++++++++++\n",
+                                  "+++++++++++\n"
+                                  "+   +++   +\n"
+                                  "+1       0+\n"
+                                  "+   +++   +\n"
+                                  "+++++++++++\n");
+    CBS cbs(level);
+    assert(solveValid(level, cbs).size() == 14);
+    assert(cbs.getTargetSplitsCount() == 0 && cbs.getCorridorSplitsCount() == 1 && cbs.getRectangleSplitsCount() == 0);
+    assert(utils::CBS_cost(cbs.getSolutions()) == 10 * 14 + (8 + 14) + 3 * (8 + 10));
+    std::cout << "test_corridor_conflict passed!" << std::endl;
+}
+
+// Agent 0 moves down and agent 1 right, every pair of their shortest paths meets in the rectangle between
+// (3, 3) and (4, 4). One of them has to wait two steps.
+void test_rectangle_conflict() {
+    const Level level = makeLevel("red: 0\nblue: 1\n",
+                                  "+++++++\n"
+                                  "+  0  +\n"
+                                  "+     +\n"
+                                  "+1    +\n"
+                                  "+     +\n"
+                                  "+     +\n"
+                                  "+++++++\n",
+                                  "+++++++\n"
+                                  "+     +\n"
+                                  "+     +\n"
+                                  "+     +\n"
+                                  "+    1+\n"
+                                  "+   0 +\n"
+                                  "+++++++\n");
+    CBS cbs(level);
+    assert(solveValid(level, cbs).size() == 7);
+    assert(cbs.getTargetSplitsCount() == 0 && cbs.getCorridorSplitsCount() == 0 && cbs.getRectangleSplitsCount() == 1);
+    assert(utils::CBS_cost(cbs.getSolutions()) == 10 * 7 + (7 + 5) + 3 * (5 + 5));
+    std::cout << "test_rectangle_conflict passed!" << std::endl;
+}
+
+// Both agents start with NoOps that can be shifted away, except the one step agent 0 has to wait behind agent 1
+void test_compress_plan() {
+    const Level level = makeLevel("red: 0\nblue: 1\n",
+                                  "+++++++\n"
+                                  "+01   +\n"
+                                  "+++++++\n",
+                                  "+++++++\n"
+                                  "+   01+\n"
+                                  "+++++++\n");
+    CBS cbs(level);
+    std::vector<Plan> solutions(2);
+    solutions[groupOf(cbs, '0')] = {{&Action::NoOp}, {&Action::NoOp}, {&Action::NoOp}, {&Action::MoveE}, {&Action::MoveE}, {&Action::MoveE}};
+    solutions[groupOf(cbs, '1')] = {{&Action::NoOp}, {&Action::MoveE}, {&Action::NoOp}, {&Action::MoveE}, {&Action::MoveE}};
+    const Plan merged = cbs.mergePlans(solutions);
+    assert(PlanValidator(level).validate(merged).solved);
+
+    const Plan compressed = cbs.compressPlan(merged, std::chrono::steady_clock::now() + std::chrono::seconds(10));
+    const PlanReport report = PlanValidator(level).validate(compressed);
+    assert(report.solved && report.makespan < merged.size());
+    assert(compressed.size() == 4);
+    assert(compressed[0][0] == &Action::NoOp && compressed[0][1] == &Action::MoveE);
+    std::cout << "test_compress_plan passed!" << std::endl;
+}
+
+#ifdef USE_INDEPENDENCE_DETECTION
+// Two red agents without boxes start in groups of their own. Walking along separate rows they stay apart, in a
+// corridor the follower runs into the leader and both end up in one group.
+void test_independence_detection() {
+    const Level independent = makeLevel("red: 0, 1\n",
+                                        "+++++++\n"
+                                        "+0    +\n"
+                                        "+     +\n"
+                                        "+1    +\n"
+                                        "+++++++\n",
+                                        "+++++++\n"
+                                        "+    0+\n"
+                                        "+     +\n"
+                                        "+    1+\n"
+                                        "+++++++\n");
+    CBS independent_cbs(independent);
+    assert(independent_cbs.getGroupStates().size() == 2);
+    assert(solveValid(independent, independent_cbs).size() == 4);
+    assert(independent_cbs.getGroupStates().size() == 2);
+
+    const Level conflicting = makeLevel("red: 0, 1\n",
+                                        "+++++++\n"
+                                        "+01   +\n"
+                                        "+++++++\n",
+                                        "+++++++\n"
+                                        "+   01+\n"
+                                        "+++++++\n");
+    CBS conflicting_cbs(conflicting);
+    assert(conflicting_cbs.getGroupStates().size() == 2);
+    assert(solveValid(conflicting, conflicting_cbs).size() == 4);
+    assert(conflicting_cbs.getGroupStates().size() == 1 && conflicting_cbs.getGroupStates()[0]->agents.size() == 2);
+    std::cout << "test_independence_detection passed!" << std::endl;
+}
+#endif
+
+#ifdef USE_TASK_ALLOCATION
+// Each red agent gets the box next to it. Undoing the allocation plans both agents and both boxes as one group again.
+void test_undo_task_allocation() {
+    const Level level = makeLevel("red: 0, 1, A\n",
+                                  "+++++++\n"
+                                  "+0A   +\n"
+                                  "+     +\n"
+                                  "+1A   +\n"
+                                  "+++++++\n",
+                                  "+++++++\n"
+                                  "+   A +\n"
+                                  "+     +\n"
+                                  "+   A +\n"
+                                  "+++++++\n");
+    CBS cbs(level);
+    assert(cbs.getGroupStates().size() == 2 && groupOf(cbs, '0') != groupOf(cbs, '1'));
+    assert(cbs.undoTaskAllocation());
+    assert(cbs.getGroupStates().size() == 1 && cbs.getGroupStates()[0]->agents.size() == 2);
+    assert(!cbs.undoTaskAllocation());
+    solveValid(level, cbs);
+    std::cout << "test_undo_task_allocation passed!" << std::endl;
+}
+#endif
+
+int main() {
+    test_follow_conflict_positive_child();
+    test_target_conflict();
+    test_corridor_conflict();
+    test_rectangle_conflict();
+    test_compress_plan();
+#ifdef USE_INDEPENDENCE_DETECTION
+    test_independence_detection();
+#endif
+#ifdef USE_TASK_ALLOCATION
+    test_undo_task_allocation();
+#endif
+    std::cout << "All CBS tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include <cassert>
+#include <iostream>
+#include <sstream>
+
+#include "constraint_table.hpp"
+#include "level.hpp"
+#include "low_level_state.hpp"
+
+static Level loadCorridorLevel() {
+    const std::string lvl =
+        "#domain\n"
+        "hospital\n"
+        "#levelname\n"
+        "corridor\n"
+        "#colors\n"
+        "red: 0, A\n"
+        "#initial\n"
+        "+++++++\n"
+        "+0 A  +\n"
+        "+++++++\n"
+        "#goal\n"
+        "+++++++\n"
+        "+    A+\n"
+        "+++++++\n"
+        "#end\n";
+    std::istringstream in(lvl);
+    return loadLevel(in);
+}
+
+// Child of `state` with the agent on `cell`, owned by the caller
+static LowLevelState *stepTo(const LowLevelState &state, const Cell2D &cell) {
+    LowLevelState *found = nullptr;
+    for (auto child : state.getExpandedStates()) {
+        if (!found && child->agents[0].getPosition() == cell) {
+            found = child;
+            continue;
+        }
+        delete child;
+    }
+    assert(found);
+    return found;
+}
+
+void test_vertex_and_edge_constraints() {
+    Level level = loadCorridorLevel();
+    LowLevelState initial(level.static_level, level.agents, level.boxes);
+    LowLevelState *moved = stepTo(initial, Cell2D(1, 2));
+    ConstraintTable table;
+
+    table.build({Constraint(Cell2D(1, 2), 1)});
+    assert(table.getHorizon() == 2);
+    assert(table.isAllowed(initial));
+    assert(!table.isAllowed(*moved));
+
+    table.build({Constraint::edge(Cell2D(1, 1), Cell2D(1, 2), 1)});
+    assert(!table.isAllowed(*moved));
+    table.build({Constraint::edge(Cell2D(1, 2), Cell2D(1, 1), 1)});
+    assert(table.isAllowed(*moved));
+
+    table.build({Constraint(Cell2D(1, 2), 1).asPositive()});
+    assert(table.isAllowed(*moved));
+    table.build({Constraint(Cell2D(1, 1), 1).asPositive()});
+    assert(!table.isAllowed(*moved));
+    delete moved;
+}
+
+void test_box_constraints() {
+    Level level = loadCorridorLevel();
+    LowLevelState initial(level.static_level, level.agents, level.boxes);
+    ConstraintTable table;
+
+    table.build({Constraint::box(Cell2D(1, 3), 0)});
+    assert(!table.isAllowed(initial));
+    table.build({Constraint(Cell2D(1, 3), 0)});
+    assert(table.isAllowed(initial));
+    table.build({Constraint::box(Cell2D(1, 3), 0).asPositive()});
+    assert(table.isAllowed(initial));
+}
+
+void test_goal_constraints() {
+    Level level = loadCorridorLevel();
+    LowLevelState initial(level.static_level, level.agents, level.boxes);
+    ConstraintTable table;
+
+    // The group would keep standing on its final cells when the constraint applies
+    table.build({Constraint(Cell2D(1, 1), 5)});
+    assert(table.isAllowed(initial));
+    assert(!table.isGoalAllowed(initial));
+
+    table.build({Constraint::range(Cell2D(1, 1), 3, Constraint::FOREVER)});
+    assert(table.isAllowed(initial));
+    assert(!table.isGoalAllowed(initial));
+
+    table.build({Constraint::length(Cell2D(1, 5), 0)});
+    assert(!table.isGoalAllowed(initial));
+
+    table.build({Constraint(Cell2D(1, 2), 4).asPositive()});
+    assert(!table.isGoalAllowed(initial));
+
+    table.build({});
+    assert(table.getHorizon() == 0);
+    assert(table.isGoalAllowed(initial));
+}
+
+void test_plan_and_landmarks() {
+    Level level = loadCorridorLevel();
+    LowLevelState initial(level.static_level, level.agents, level.boxes);
+    ConstraintTable table;
+
+    table.build({Constraint(Cell2D(1, 2), 1).asPositive()});
+    assert(table.isPlanAllowed(initial, {{&Action::MoveE}}));
+    assert(!table.isPlanAllowed(initial, {{&Action::NoOp}}));
+
+    // The agent cannot cover three cells in two steps
+    table.build({Constraint(Cell2D(1, 4), 3).asPositive()});
+    LowLevelState *waited = stepTo(initial, Cell2D(1, 1));
+    assert(!table.isAllowed(*waited));
+    delete waited;
+}
+
+int main() {
+    test_vertex_and_edge_constraints();
+    test_box_constraints();
+    test_goal_constraints();
+    test_plan_and_landmarks();
+    std::cout << "All ConstraintTable tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <cassert>
+#include <iostream>
+#include <sstream>
+
+#include "level.hpp"
+#include "low_level_state.hpp"
+
+// A room with the goal of A on its top wall, a dead end, and a closet that no box can leave
+static Level loadRoomLevel() {
+    const std::string lvl =
+        "#domain\n"
+        "hospital\n"
+        "#levelname\n"
+        "room\n"
+        "#colors\n"
+        "red: 0, A\n"
+        "#initial\n"
+        "+++++++++\n"
+        "+0   ++ +\n"
+        "+    ++++\n"
+        "+  A  +++\n"
+        "+++++++++\n"
+        "#goal\n"
+        "+++++++++\n"
+        "+  A ++ +\n"
+        "+    ++++\n"
+        "+     +++\n"
+        "+++++++++\n"
+        "#end\n";
+    std::istringstream in(lvl);
+    return loadLevel(in);
+}
+
+void test_pulls_rescue_dead_ends() {
+    Level level = loadRoomLevel();
+    const StaticLevel &static_level = level.static_level;
+
+    assert(!static_level.isDeadSquare('A', Cell2D(1, 3)));
+    // Pushes may turn the box, corners are fine
+    assert(!static_level.isDeadSquare('A', Cell2D(3, 1)));
+    assert(!static_level.isDeadSquare('A', Cell2D(1, 4)));
+    // No agent fits behind a box at the end of the dead end, but one can pull it out
+    assert(!static_level.isDeadSquare('A', Cell2D(3, 5)));
+    // Walled off from the goal
+    assert(static_level.isDeadSquare('A', Cell2D(1, 7)));
+
+    const auto [dead_count, push_dead_count] = StaticLevel(static_level).computeDeadSquares(level.boxes);
+    assert(dead_count == 0);
+    assert(push_dead_count == 1);
+}
+
+void test_spare_boxes_are_never_dead() {
+    const std::string lvl =
+        "#domain\n"
+        "hospital\n"
+        "#levelname\n"
+        "spare\n"
+        "#colors\n"
+        "red: 0, A\n"
+        "#initial\n"
+        "+++++++++\n"
+        "+0 A ++A+\n"
+        "+++++++++\n"
+        "#goal\n"
+        "+++++++++\n"
+        "+  A ++ +\n"
+        "+++++++++\n"
+        "#end\n";
+    std::istringstream in(lvl);
+    Level level = loadLevel(in);
+    assert(!level.static_level.isDeadSquare('A', Cell2D(1, 7)));
+}
+
+int main() {
+    test_pulls_rescue_dead_ends();
+    test_spare_boxes_are_never_dead();
+    std::cout << "All dead square tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "frontier.hpp"
+#include "heuristic.hpp"
+#include "level.hpp"
+#include "low_level_state.hpp"
+#include "reservation_table.hpp"
+
+static Level loadRoomLevel() {
+    const std::string lvl =
+        "#domain\n"
+        "hospital\n"
+        "#levelname\n"
+        "room\n"
+        "#colors\n"
+        "red: 0\n"
+        "#initial\n"
+        "+++++\n"
+        "+0  +\n"
+        "+   +\n"
+        "+++++\n"
+        "#goal\n"
+        "+++++\n"
+        "+   +\n"
+        "+ 0 +\n"
+        "+++++\n"
+        "#end\n";
+    std::istringstream in(lvl);
+    return loadLevel(in);
+}
+
+// The child of `parent` with its agent on `cell`, the other children are deleted
+static LowLevelState *childAt(const LowLevelState &parent, const Cell2D &cell) {
+    LowLevelState *found = nullptr;
+    for (LowLevelState *child : parent.getExpandedStates()) {
+        if (!found && child->agents[0].getPosition() == cell) {
+            found = child;
+        } else {
+            delete child;
+        }
+    }
+    assert(found);
+    return found;
+}
+
+// Moving east or south both reach the goal in two steps. The one into a cell another group holds at 1 pops last,
+// whichever order they were added in, but still before waiting, which costs more.
+void test_ties_go_to_fewer_conflicts() {
+    Level level = loadRoomLevel();
+    const Cell2D east(1, 2), south(2, 1), start(1, 1);
+
+    for (const Cell2D &reserved : {east, south}) {
+        ReservationTable conflict_avoidance_table(level.static_level);
+        conflict_avoidance_table.reserve(reserved, 1);
+        FrontierBestFirst frontier(new HeuristicAStar());
+        frontier.setConflictAvoidanceTable(&conflict_avoidance_table);
+
+        frontier.add(new LowLevelState(level.static_level, level.agents, level.boxes));
+        LowLevelState *root = frontier.pop();
+        frontier.add(childAt(*root, start));
+        frontier.add(childAt(*root, east));
+        frontier.add(childAt(*root, south));
+
+        const Cell2D expected_order[] = {reserved == east ? south : east, reserved, start};
+        for (const Cell2D &expected : expected_order) {
+            LowLevelState *state = frontier.pop();
+            assert(state->agents[0].getPosition() == expected);
+            delete state;
+        }
+        assert(frontier.isEmpty());
+        delete root;
+    }
+    std::cout << "test_ties_go_to_fewer_conflicts passed!" << std::endl;
+}
+
+// Conflicts add up along the path: a child of the conflicting state keeps losing ties against a clean one
+void test_conflicts_inherited_from_parent() {
+    Level level = loadRoomLevel();
+    ReservationTable conflict_avoidance_table(level.static_level);
+    conflict_avoidance_table.reserve(Cell2D(1, 2), 1);
+    FrontierBestFirst frontier(new HeuristicAStar());
+    frontier.setConflictAvoidanceTable(&conflict_avoidance_table);
+
+    frontier.add(new LowLevelState(level.static_level, level.agents, level.boxes));
+    LowLevelState *root = frontier.pop();
+    frontier.add(childAt(*root, Cell2D(1, 2)));
+    LowLevelState *conflicting = frontier.pop();
+    frontier.add(childAt(*conflicting, Cell2D(2, 2)));  // On the goal at 2, one conflict on the way
+    frontier.add(childAt(*root, Cell2D(2, 1)));         // Also f = 2, no conflict yet
+
+    LowLevelState *state = frontier.pop();
+    assert(state->agents[0].getPosition() == Cell2D(2, 1));
+    delete state;
+    state = frontier.pop();
+    assert(state->agents[0].getPosition() == Cell2D(2, 2));
+    delete state;
+    delete conflicting;
+    delete root;
+    std::cout << "test_conflicts_inherited_from_parent passed!" << std::endl;
+}
+
+// Agent 1 walks four cells to its goal while agent 0 walks two and pushes the box once, four joint steps in all
+void test_heuristic_is_admissible() {
+    const std::string lvl =
+        "#domain\n"
+        "hospital\n"
+        "#levelname\n"
+        "pushing\n"
+        "#colors\n"
+        "red: 0, A\n"
+        "blue: 1\n"
+        "#initial\n"
+        "+++++++\n"
+        "+0  A +\n"
+        "+1    +\n"
+        "+++++++\n"
+        "#goal\n"
+        "+++++++\n"
+        "+    A+\n"
+        "+    1+\n"
+        "+++++++\n"
+        "#end\n";
+    std::istringstream in(lvl);
+    Level level = loadLevel(in);
+    LowLevelState state(level.static_level, level.agents, level.boxes);
+    assert(HeuristicAStar().h(state) == 4);
+    std::cout << "test_heuristic_is_admissible passed!" << std::endl;
+}
+
+int main() {
+    test_ties_go_to_fewer_conflicts();
+    test_conflicts_inherited_from_parent();
+    test_heuristic_is_admissible();
+    std::cout << "All frontier tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+
+#include "level.hpp"
+
+// A hospital level spelled out by its colors, initial and goal sections
+inline Level makeLevel(const std::string &colors, const std::string &initial, const std::string &goal) {
+    return parseLevel("#domain\nhospital\n#levelname\ntest\n#colors\n" + colors + "#initial\n" + initial + "#goal\n" + goal + "#end\n");
+}
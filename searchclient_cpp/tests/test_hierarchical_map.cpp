@@ -0,0 +1,83 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "hierarchical_map.hpp"
+
+static std::vector<size_t> bfsDistances(size_t rows, size_t cols, const std::vector<bool> &free_cells, const Cell2D &from) {
+    std::vector<size_t> distances(rows * cols, SIZE_MAX);
+    std::queue<Cell2D> queue;
+    distances[from.r * cols + from.c] = 0;
+    queue.push(from);
+    while (!queue.empty()) {
+        const Cell2D cell = queue.front();
+        queue.pop();
+        for (const Cell2D &next : {Cell2D(cell.r - 1, cell.c), Cell2D(cell.r + 1, cell.c), Cell2D(cell.r, cell.c - 1),
+                                   Cell2D(cell.r, cell.c + 1)}) {
+            if (next.r < rows && next.c < cols && free_cells[next.r * cols + next.c] && distances[next.r * cols + next.c] == SIZE_MAX) {
+                distances[next.r * cols + next.c] = distances[cell.r * cols + cell.c] + 1;
+                queue.push(next);
+            }
+        }
+    }
+    return distances;
+}
+
+void test_open_grid() {
+    const size_t rows = 12, cols = 17;
+    const std::vector<bool> free_cells(rows * cols, true);
+    HierarchicalMap hierarchy(rows, cols, free_cells, 6);
+    assert(hierarchy.getClusterCount() == 2 * 3);
+
+    // Inside a cluster the distance is exact
+    assert(hierarchy.getDistance(Cell2D(0, 0), Cell2D(4, 4)) == 8);
+    // Wide entrances have portals at both ends, so going along a border costs nothing extra
+    assert(hierarchy.getDistance(Cell2D(0, 0), Cell2D(0, 16)) == 16);
+}
+
+void test_random_grids() {
+    std::mt19937 random_generator(3);
+    const size_t rows = 40, cols = 37;
+    for (size_t round = 0; round < 5; round++) {
+        std::vector<bool> free_cells(rows * cols);
+        for (size_t i = 0; i < free_cells.size(); i++) {
+            free_cells[i] = random_generator() % 100 >= 30;
+        }
+        HierarchicalMap hierarchy(rows, cols, free_cells, 8);
+        for (size_t query = 0; query < 50; query++) {
+            const Cell2D from(random_generator() % rows, random_generator() % cols);
+            const Cell2D to(random_generator() % rows, random_generator() % cols);
+            if (!free_cells[from.r * cols + from.c] || !free_cells[to.r * cols + to.c]) {
+                continue;
+            }
+            const size_t exact = bfsDistances(rows, cols, free_cells, from)[to.r * cols + to.c];
+            const size_t abstract = hierarchy.getDistance(from, to);
+            // Every entrance has a portal, so the abstraction finds a route whenever there is one
+            assert((exact == SIZE_MAX) == (abstract == SIZE_MAX));
+            if (exact == SIZE_MAX) {
+                assert(hierarchy.findPath(from, to).empty());
+                continue;
+            }
+            assert(abstract >= exact);
+
+            const auto path = hierarchy.findPath(from, to);
+            assert(path.size() == abstract + 1);
+            assert(path.front() == from && path.back() == to);
+            for (size_t i = 1; i < path.size(); i++) {
+                assert(free_cells[path[i].r * cols + path[i].c]);
+                assert(std::abs(path[i].r - path[i - 1].r) + std::abs(path[i].c - path[i - 1].c) == 1);
+            }
+        }
+    }
+}
+
+int main() {
+    test_open_grid();
+    test_random_grids();
+    std::cout << "All hierarchical map tests passed!\n";
+    return 0;
+}
@@ -1,102 +1,108 @@
 // tests/test_level.cpp
+#include <cassert>
 #include <iostream>
 #include <sstream>
-#include <cassert>
+#include <stdexcept>
 
-#include "level.hpp"   // brings in CharGrid, Cell2D, WALL, loadLevel
+#include "level.hpp"  // brings in CharGrid, Cell2D, WALL, loadLevel
 
-void test_loadLevel() {
-    // Prepare a fake .lvl file in a string
-    const std::string lvl = 
-        "#domain\n"
-        "hospital\n"
-        "#levelname\n"
-        "MAExample\n"
-        "#colors\n"
-        "red: 0, A\n"
-        "green: 1, B\n"
-        "#initial\n"
-        "+++++++\n"
-        "+0BB  +\n"
-        "+     +\n"
-        "+1AA  +\n"
-        "+++++++\n"
-        "#goal\n"
-        "+++++++\n"
-        "+1  AA+\n"
-        "+     +\n"
-        "+0  BB+\n"
-        "+++++++\n"
-        "#end\n";
+static const std::string EXAMPLE_LEVEL =
+    "#domain\n"
+    "hospital\n"
+    "#levelname\n"
+    "MAExample\n"
+    "#colors\n"
+    "red: 0, A\n"
+    "green: 1, B\n"
+    "#initial\n"
+    "+++++++\n"
+    "+0BB  +\n"
+    "+     +\n"
+    "+1AA  +\n"
+    "+++++++\n"
+    "#goal\n"
+    "+++++++\n"
+    "+1  AA+\n"
+    "+     +\n"
+    "+0  BB+\n"
+    "+++++++\n"
+    "#end\n";
 
-    std::istringstream in(lvl);
-    Level level = loadLevel(in);
+static bool isMalformed(const std::string &text) {
+    try {
+        parseLevelText(text);
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+    return false;
+}
 
-    // Domain & name (static members)
-    assert(Level::domain == "hospital");
-    assert(Level::name   == "MAExample");
+void test_loadLevel() {
+    // The server keeps the stream open, nothing after #end is read
+    std::istringstream in(EXAMPLE_LEVEL + "true\n");
+    Level level = loadLevel(in);
+    std::string rest;
+    assert(std::getline(in, rest) && rest == "true");
 
-    // Dimensions should be 5×7
-    assert(Level::walls.size_rows() == 5);
-    assert(Level::walls.size_cols() == 7);
-    assert(level.boxes.size_rows() == 5);
-    assert(level.boxes.size_cols() == 7);
+    assert(level.static_level.getDomain() == "hospital");
+    assert(level.static_level.getName() == "MAExample");
+    assert(level.static_level.getSize() == Cell2D(5, 7));
 
-    // Walls: border must be '+', interior must be untouched (0)
-    for(int r = 0; r < 5; ++r) {
-        for(int c = 0; c < 7; ++c) {
-            if(r==0||r==4||c==0||c==6)
-                assert(Level::walls(r,c) == WALL);
-            else
-                assert(Level::walls(r,c) == 0);
+    // Walls: the border is blocked, the interior is free
+    for (int r = 0; r < 5; ++r) {
+        for (int c = 0; c < 7; ++c) {
+            assert(level.static_level.isCellFree(Cell2D(r, c)) == !(r == 0 || r == 4 || c == 0 || c == 6));
         }
     }
 
-    // Agents: there should be exactly two, at (1,1) for '0' and (3,1) for '1'
     assert(level.agents.size() == 2);
-    assert(level.agents[0] == Cell2D(1,1));
-    assert(level.agents[1] == Cell2D(3,1));
-
-    // Agent colors:
-    assert(Level::agent_colors[0] == Color::Red);
-    assert(Level::agent_colors[1] == Color::Green);
+    assert(level.agents[0].getPosition() == Cell2D(1, 1));
+    assert(level.agents[0].getGoalPositions() == std::vector<Cell2D>{Cell2D(3, 1)});
+    assert(level.agents[1].getPosition() == Cell2D(3, 1));
+    assert(level.static_level.getAgentColor('0') == Color::Red);
+    assert(level.static_level.getAgentColor('1') == Color::Green);
 
-    // Box colors:
-    assert(Level::box_colors[0] == Color::Red);
-    assert(Level::box_colors[1] == Color::Green);
+    assert(level.boxes.size() == 2);
+    assert(level.boxes[0].getSymbol() == 'A' && level.boxes[0].getColor() == Color::Red);
+    assert((level.boxes[0].getPositions() == std::vector<Cell2D>{Cell2D(3, 2), Cell2D(3, 3)}));
+    assert((level.boxes[0].getGoals() == std::vector<Cell2D>{Cell2D(1, 4), Cell2D(1, 5)}));
+    assert(level.boxes[1].getSymbol() == 'B' && level.boxes[1].getColor() == Color::Green);
 
-    // Boxes in initial state: B at (1,2),(1,3); A at (3,2),(3,3)
-    assert(level.boxes(1,2) == 'B');
-    assert(level.boxes(1,3) == 'B');
-    assert(level.boxes(3,2) == 'A');
-    assert(level.boxes(3,3) == 'A');
-    // Check some empty cell
-    assert(level.boxes(2,2) == 0);
-    assert(level.boxes(2,3) == 0);
-    assert(level.boxes(4,2) == 0);
-    assert(level.boxes(4,3) == 0);
-    assert(level.boxes(3,4) == 0);
-    assert(level.boxes(3,5) == 0);
+    std::cout << "test_loadLevel passed!" << std::endl;
+}
 
-    // Goals: static Level::goals must have '1' at (1,1), 'A' at (1,4),(1,5);
-    //                     '0' at (3,1), 'B' at (3,4),(3,5)
-    assert(Level::agent_goals[1] == Cell2D(1,1));
-    assert(Level::box_goals(1,4) == 'A');
-    assert(Level::box_goals(1,5) == 'A');
-    assert(Level::agent_goals[0] == Cell2D(3,1));
-    assert(Level::box_goals(3,4) == 'B');
-    assert(Level::box_goals(3,5) == 'B');
-    // And interior zeros
-    assert(Level::box_goals(2,2) == 0);
-    assert(Level::box_goals(1,2) == 0);
-    assert(Level::box_goals(1,3) == 0);
-    assert(Level::box_goals(3,2) == 0);
-    assert(Level::box_goals(3,3) == 0);
+void test_boxes_without_agent_are_walls() {
+    std::string text = EXAMPLE_LEVEL;
+    text.replace(text.find("green: 1, B"), 11, "green: B\r\nblue: 1");
+    const ParsedLevel parsed = parseLevelText(text);
+    assert(parsed.boxes.size() == 1);
+    assert(parsed.walls(1, 2) == WALL && parsed.walls(1, 3) == WALL);
+    std::cout << "test_boxes_without_agent_are_walls passed!" << std::endl;
+}
 
-    std::cout << "test_loadLevel passed!" << std::endl;
+void test_rejects_malformed_levels() {
+    assert(!isMalformed(EXAMPLE_LEVEL));
+    assert(isMalformed(""));
+    assert(isMalformed(EXAMPLE_LEVEL.substr(0, EXAMPLE_LEVEL.find("#end"))));
+    std::string text = EXAMPLE_LEVEL;
+    assert(isMalformed(text.replace(text.find("red:"), 4, "rot:")));
+    text = EXAMPLE_LEVEL;
+    assert(isMalformed(text.replace(text.find("0, A"), 4, "0, AB")));
+    text = EXAMPLE_LEVEL;
+    assert(isMalformed(text.replace(text.find("+     +"), 7, "+  0  +")));  // Agent placed twice
+    text = EXAMPLE_LEVEL;
+    assert(isMalformed(text.replace(text.find("+     +"), 7, "+  C  +")));  // Box without a color
+    text = EXAMPLE_LEVEL;
+    assert(isMalformed(text.replace(text.find("+     +"), 7, "+  ?  +")));
+    text = EXAMPLE_LEVEL;
+    assert(isMalformed(text.replace(text.find("#end"), 0, "+++++++\n")));  // Goal taller than the initial state
+    std::cout << "test_rejects_malformed_levels passed!" << std::endl;
 }
 
 int main() {
     test_loadLevel();
+    test_boxes_without_agent_are_walls();
+    test_rejects_malformed_levels();
+    std::cout << "All level tests passed!\n";
     return 0;
 }
@@ -0,0 +1,135 @@
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "level_cache.hpp"
+
+static const std::string LEVEL =
+    "#domain\n"
+    "hospital\n"
+    "#levelname\n"
+    "CacheExample\n"
+    "#colors\n"
+    "red: 0, A\n"
+    "green: 1, B\n"
+    "#initial\n"
+    "+++++++++++\n"
+    "+0A      B+\n"
+    "+++++ +++++\n"
+    "+1       ++\n"
+    "+++++++++++\n"
+    "#goal\n"
+    "+++++++++++\n"
+    "+        A+\n"
+    "+++++ +++++\n"
+    "+       1++\n"
+    "+++++++++++\n"
+    "#end\n";
+
+static std::string makeDirectory() {
+    char directory[] = "/tmp/test_level_cache_XXXXXX";
+    assert(mkdtemp(directory));
+    return directory;
+}
+
+void test_round_trip() {
+    const std::string directory = makeDirectory();
+    LevelCache cache(directory);
+    assert(cache.load(LEVEL) == nullptr);
+
+    const Level level = parseLevel(LEVEL);
+    assert(cache.store(LEVEL, level));
+    const Level *restored = cache.load(LEVEL);
+    assert(restored);
+
+    const StaticLevel &expected = level.static_level, &actual = restored->static_level;
+    assert(actual.getName() == expected.getName() && actual.getSize() == expected.getSize());
+    assert(actual.getAgentColor('1') == Color::Green);
+    for (size_t r = 0; r < expected.getSize().r; r++) {
+        for (size_t c = 0; c < expected.getSize().c; c++) {
+            const Cell2D cell(r, c);
+            assert(actual.isCellFree(cell) == expected.isCellFree(cell));
+            assert(actual.getSegmentAt(cell) == expected.getSegmentAt(cell));
+            assert(actual.isDeadSquare('A', cell) == expected.isDeadSquare('A', cell));
+        }
+    }
+    assert(actual.getCorridorSegments().size() == expected.getCorridorSegments().size());
+    assert(actual.getCorridorSegments()[0].cells == expected.getCorridorSegments()[0].cells);
+    assert(restored->agents.size() == 2 && restored->agents[1] == level.agents[1]);
+    assert(restored->boxes.size() == 2);
+    assert(restored->boxes[0].getPositions() == level.boxes[0].getPositions());
+    assert(restored->boxes[0].getGoals() == level.boxes[0].getGoals());
+    assert(restored->boxes[1].getColor() == Color::Green);
+    delete restored;
+
+    // Another level, or the same one edited, misses
+    std::string edited = LEVEL;
+    edited.replace(edited.find("CacheExample"), 12, "CacheExamplf");
+    assert(cache.load(edited) == nullptr);
+
+    remove(cache.getPath(LevelCache::hashText(LEVEL)).c_str());
+    rmdir(directory.c_str());
+    std::cout << "test_round_trip passed!" << std::endl;
+}
+
+void test_rejects_damaged_files() {
+    const std::string directory = makeDirectory();
+    LevelCache cache(directory);
+    assert(cache.store(LEVEL, parseLevel(LEVEL)));
+    const std::string path = cache.getPath(LevelCache::hashText(LEVEL));
+    FILE *file = fopen(path.c_str(), "rb");
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fclose(file);
+    assert(truncate(path.c_str(), size - 5) == 0);
+    assert(cache.load(LEVEL) == nullptr);
+
+    remove(path.c_str());
+    rmdir(directory.c_str());
+    std::cout << "test_rejects_damaged_files passed!" << std::endl;
+}
+
+// An in-range file whose corridor table points past the segments is rejected as well
+void test_rejects_bad_indices() {
+    const std::string directory = makeDirectory();
+    LevelCache cache(directory);
+    const Level level = parseLevel(LEVEL);
+    assert(cache.store(LEVEL, level));
+    const std::string path = cache.getPath(LevelCache::hashText(LEVEL));
+    FILE *file = fopen(path.c_str(), "rb");
+    std::string bytes(1 << 12, '\0');
+    bytes.resize(fread(&bytes[0], 1, bytes.size(), file));
+    fclose(file);
+
+    // The corridor table: its cell count, then one index per cell, SIZE_MAX first since the corner is a wall
+    const size_t cells = level.static_level.getSize().r * level.static_level.getSize().c;
+    std::string table_start(reinterpret_cast<const char *>(&cells), sizeof(cells));
+    table_start.append(sizeof(size_t), '\xff');
+    const size_t table = bytes.find(table_start);
+    assert(table != std::string::npos);
+    size_t *segment_of = reinterpret_cast<size_t *>(&bytes[table + sizeof(size_t)]);
+    size_t corridor_cell = 0;
+    while (segment_of[corridor_cell] == SIZE_MAX) {
+        corridor_cell++;
+    }
+    segment_of[corridor_cell] = level.static_level.getCorridorSegments().size();
+    file = fopen(path.c_str(), "wb");
+    assert(fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size());
+    fclose(file);
+    assert(cache.load(LEVEL) == nullptr);
+
+    remove(path.c_str());
+    rmdir(directory.c_str());
+    std::cout << "test_rejects_bad_indices passed!" << std::endl;
+}
+
+int main() {
+    test_round_trip();
+    test_rejects_damaged_files();
+    test_rejects_bad_indices();
+    std::cout << "All level cache tests passed!\n";
+    return 0;
+}
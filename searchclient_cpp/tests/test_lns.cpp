@@ -0,0 +1,69 @@
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cbs.hpp"
+#include "level.hpp"
+#include "lns.hpp"
+#include "plan_validator.hpp"
+#include "utils.hpp"
+
+using Solutions = std::vector<std::vector<std::vector<const Action *>>>;
+
+// Agent 0 starts with a detour, agent 1 with its shortest plan
+void test_improves_and_stops() {
+    const Level level = parseLevel(
+        "#domain\nhospital\n#levelname\nlns\n#colors\nred: 0\nblue: 1\n#initial\n"
+        "+++++++\n"
+        "+0    +\n"
+        "+1    +\n"
+        "+++++++\n"
+        "#goal\n"
+        "+++++++\n"
+        "+  0  +\n"
+        "+  1  +\n"
+        "+++++++\n"
+        "#end\n");
+    CBS cbs(level);
+    const auto &groups = cbs.getGroupStates();
+    assert(groups.size() == 2);
+    Solutions solutions(2);
+    for (size_t i = 0; i < groups.size(); i++) {
+        if (groups[i]->agents[0].getSymbol() == '0') {
+            solutions[i] = {{&Action::MoveE}, {&Action::MoveW}, {&Action::MoveE}, {&Action::MoveE}};
+        } else {
+            solutions[i] = {{&Action::MoveE}, {&Action::MoveE}};
+        }
+    }
+    assert(PlanValidator(level).validate(cbs.mergePlans(solutions)).solved);
+    const size_t initial_cost = utils::CBS_cost(solutions);
+
+    for (unsigned int seed = 0; seed < 3; seed++) {
+        LargeNeighborhoodSearch lns(level, groups, 1, seed);
+        lns.setDeadline(std::chrono::steady_clock::now() + std::chrono::seconds(30));
+        const auto started = std::chrono::steady_clock::now();
+        const Solutions improved = lns.improve(solutions);
+
+        // Never costlier along the way, and still a valid plan
+        const auto &curve = lns.getImprovementCurve();
+        for (size_t i = 1; i < curve.size(); i++) {
+            assert(curve[i].cost < curve[i - 1].cost);
+        }
+        assert(utils::CBS_cost(improved) == curve.back().cost && curve.back().cost <= initial_cost);
+        assert(PlanValidator(level).validate(cbs.mergePlans(improved)).solved);
+        assert(utils::SIC(improved) == 2 + 2);
+
+        // Stopped by the iterations without improvement, long before the deadline
+        assert(lns.getIterationsCount() == curve.back().iteration + LargeNeighborhoodSearch::MAX_ITERATIONS_WITHOUT_IMPROVEMENT);
+        assert(std::chrono::steady_clock::now() - started < std::chrono::seconds(10));
+    }
+    std::cout << "test_improves_and_stops passed!" << std::endl;
+}
+
+int main() {
+    test_improves_and_stops();
+    std::cout << "All LNS tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include <cassert>
+#include <iostream>
+#include <sstream>
+
+#include "graphsearch.hpp"
+#include "level.hpp"
+#include "low_level_state.hpp"
+
+static Level loadCorridorLevel() {
+    const std::string lvl =
+        "#domain\n"
+        "hospital\n"
+        "#levelname\n"
+        "corridor\n"
+        "#colors\n"
+        "red: 0, A\n"
+        "#initial\n"
+        "+++++++\n"
+        "+0  A +\n"
+        "+++++++\n"
+        "#goal\n"
+        "+++++++\n"
+        "+0   A+\n"
+        "+++++++\n"
+        "#end\n";
+    std::istringstream in(lvl);
+    return loadLevel(in);
+}
+
+void test_walk_then_push() {
+    Level level = loadCorridorLevel();
+    LowLevelState initial(level.static_level, level.agents, level.boxes);
+
+    // Walking up to the box, then pushing it east or pulling it west
+    auto children = initial.getMacroExpandedStates();
+    assert(children.size() == 2);
+    LowLevelState *pushed = children[0]->actions[0]->type == ActionType::Push ? children[0] : children[1];
+    delete (pushed == children[0] ? children[1] : children[0]);
+    assert(pushed->getG() == 3);
+    assert(pushed->walk.size() == 2);
+    assert(pushed->getBoxAt(Cell2D(1, 5)) == 'A');
+
+    // Walking back onto the agent's goal, or pulling the box back west
+    auto grandchildren = pushed->getMacroExpandedStates();
+    LowLevelState *goal = nullptr;
+    for (auto state : grandchildren) {
+        if (state->isGoalState()) {
+            goal = state;
+        }
+    }
+    assert(goal);
+    const auto plan = goal->extractPlan();
+    assert(plan.size() == goal->getG());
+    assert(plan.size() == 6);
+    assert(plan[0][0] == &Action::MoveE && plan[2][0]->type == ActionType::Push && plan[5][0] == &Action::MoveW);
+
+    for (auto state : grandchildren) {
+        delete state;
+    }
+    delete pushed;
+}
+
+void test_macro_key_ignores_walking() {
+    Level level = loadCorridorLevel();
+    LowLevelState initial(level.static_level, level.agents, level.boxes);
+    LowLevelState walked(initial);
+    walked.agents[0].position() = Cell2D(1, 3);
+    assert(initial.getMacroKey() == walked.getMacroKey());
+
+    walked.moveBox(Cell2D(1, 4), Cell2D(1, 5));
+    assert(initial.getMacroKey() != walked.getMacroKey());
+}
+
+// Pushing the box east and pulling it back west returns to the initial key four steps later. Only a cheaper state
+// re-opens a key.
+void test_macro_key_keeps_lowest_g() {
+    Level level = loadCorridorLevel();
+    LowLevelState initial(level.static_level, level.agents, level.boxes);
+    auto children = initial.getMacroExpandedStates();
+    LowLevelState *pushed = children[0]->actions[0]->type == ActionType::Push ? children[0] : children[1];
+    LowLevelState *returned = nullptr;
+    auto grandchildren = pushed->getMacroExpandedStates();
+    for (auto state : grandchildren) {
+        if (state->actions[0]->type == ActionType::Pull) {
+            returned = state;
+        }
+    }
+    assert(returned && returned->getG() == 4 && returned->getMacroKey() == initial.getMacroKey());
+
+    Graphsearch search(&initial, new FrontierBFS());
+    assert(search.isNewMacroState(returned));
+    assert(search.isNewMacroState(&initial));
+    assert(!search.isNewMacroState(returned));
+    assert(!search.isNewMacroState(&initial));
+
+    for (auto state : grandchildren) {
+        delete state;
+    }
+    for (auto state : children) {
+        delete state;
+    }
+}
+
+// Two rooms joined by a corridor of three cells
+static Level loadTwoRoomLevel() {
+    const std::string lvl =
+        "#domain\n"
+        "hospital\n"
+        "#levelname\n"
+        "tworooms\n"
+        "#colors\n"
+        "red: 0, A\n"
+        "#initial\n"
+        "+++++++++\n"
+        "+0 +++  +\n"
+        "+       +\n"
+        "+  +++ A+\n"
+        "+++++++++\n"
+        "#goal\n"
+        "+++++++++\n"
+        "+  +++  +\n"
+        "+      0+\n"
+        "+  +++ A+\n"
+        "+++++++++\n"
+        "#end\n";
+    std::istringstream in(lvl);
+    return loadLevel(in);
+}
+
+void test_corridor_segments() {
+    Level level = loadTwoRoomLevel();
+    const auto &segments = level.static_level.getCorridorSegments();
+    // Room corners are not corridors
+    assert(segments.size() == 1);
+    assert(segments[0].cells.size() == 3);
+    assert(segments[0].cells.front() == Cell2D(2, 3) && segments[0].cells.back() == Cell2D(2, 5));
+    assert(segments[0].ends[0] == Cell2D(2, 2) && segments[0].ends[1] == Cell2D(2, 6));
+    assert(level.static_level.getSegmentAt(Cell2D(2, 4)) == 0);
+    assert(level.static_level.getSegmentAt(Cell2D(1, 1)) == SIZE_MAX);
+}
+
+void test_corridor_traversal() {
+    Level level = loadTwoRoomLevel();
+    LowLevelState initial(level.static_level, level.agents, level.boxes);
+    assert(initial.getCorridorTraversals().empty());
+
+    initial.agents[0].position() = Cell2D(2, 2);
+    auto traversals = initial.getCorridorTraversals();
+    assert(traversals.size() == 1);
+    assert(traversals[0]->agents[0].getPosition() == Cell2D(2, 6));
+    assert(traversals[0]->getG() == 4);
+    const auto plan = traversals[0]->extractPlan();
+    assert(plan.size() == 4 && plan[0][0] == &Action::MoveE && plan[3][0] == &Action::MoveE);
+    delete traversals[0];
+
+    // Boxes in the corridor block the traversal
+    LowLevelState blocked(initial);
+    blocked.moveBox(Cell2D(3, 7), Cell2D(2, 4));
+    assert(blocked.getCorridorTraversals().empty());
+}
+
+int main() {
+    test_walk_then_push();
+    test_macro_key_ignores_walking();
+    test_macro_key_keeps_lowest_g();
+    test_corridor_segments();
+    test_corridor_traversal();
+    std::cout << "All macro search tests passed!\n";
+    return 0;
+}
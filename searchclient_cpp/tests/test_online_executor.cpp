@@ -0,0 +1,146 @@
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cbs.hpp"
+#include "level.hpp"
+#include "online_executor.hpp"
+#include "plan_validator.hpp"
+#include "test_helpers.hpp"
+
+// Both agents cross a long room side by side, more steps than a streamed remainder that is committed whole
+static Level makeLongRoomLevel() {
+    return makeLevel("red: 0\nblue: 1\n",
+                     "+++++++++++++++++++++++\n"
+                     "+0                    +\n"
+                     "+1                    +\n"
+                     "+++++++++++++++++++++++\n",
+                     "+++++++++++++++++++++++\n"
+                     "+                    0+\n"
+                     "+                    1+\n"
+                     "+++++++++++++++++++++++\n");
+}
+
+// `count` answers of a scripted server
+static std::string responses(size_t count, const std::string &response) {
+    std::string all;
+    for (size_t i = 0; i < count; i++) {
+        all += response + "\n";
+    }
+    return all;
+}
+
+static size_t countLines(FILE *file) {
+    rewind(file);
+    size_t lines = 0;
+    for (int c = fgetc(file); c != EOF; c = fgetc(file)) {
+        lines += c == '\n';
+    }
+    return lines;
+}
+
+void test_stream() {
+    const Level level = makeLongRoomLevel();
+    FILE *out = tmpfile();
+    std::istringstream in(responses(100, "true|true"));
+    OnlineExecutor executor(out, in);
+    executor.stream(level, std::chrono::steady_clock::now() + std::chrono::seconds(30));
+
+    // The first half of the plan is committed, the remainder after the next round
+    assert(executor.getRoundsCount() >= 2);
+    const auto &executed = executor.getExecuted();
+    assert(executed.size() > OnlineExecutor::STREAM_MIN_REMAINDER && countLines(out) == executed.size());
+    const PlanReport report = PlanValidator(level).validate(executed);
+    assert(report.solved && report.makespan == 20);
+    fclose(out);
+    std::cout << "test_stream passed!" << std::endl;
+}
+
+// The agents swap ends of a corridor with one passing bay. With a window of two, the first cycles bring the goals no
+// closer until the window is widened enough to see the bay.
+void test_windowed() {
+    const Level level = makeLevel("red: 0\nblue: 1\n",
+                                  "+++++++\n"
+                                  "+0   1+\n"
+                                  "+++ +++\n"
+                                  "+++++++\n",
+                                  "+++++++\n"
+                                  "+1   0+\n"
+                                  "+++ +++\n"
+                                  "+++++++\n");
+    FILE *out = tmpfile();
+    std::istringstream in(responses(100, "true|true"));
+    OnlineExecutor executor(out, in);
+    executor.stream(level, std::chrono::steady_clock::now() + std::chrono::seconds(30), 2);
+
+    assert(executor.getRoundsCount() >= 2);
+    const auto &executed = executor.getExecuted();
+    assert(countLines(out) == executed.size());
+    assert(PlanValidator(level).validate(executed).solved);
+    fclose(out);
+    std::cout << "test_windowed passed!" << std::endl;
+}
+
+static Level makeRoomLevel() {
+    return makeLevel("red: 0\nblue: 1\n",
+                     "+++++++\n"
+                     "+0    +\n"
+                     "+1    +\n"
+                     "+++++++\n",
+                     "+++++++\n"
+                     "+   0 +\n"
+                     "+   1 +\n"
+                     "+++++++\n");
+}
+
+// The server rejects agent 0's second move. The executed actions leave it one cell short, the repaired plan
+// takes it to its goal.
+void test_repair_after_rejection() {
+    const Level level = makeRoomLevel();
+    CBS cbs(level);
+    const std::vector<std::vector<const Action *>> plan(3, {&Action::MoveE, &Action::MoveE});
+    FILE *out = tmpfile();
+    std::istringstream in("true|true\nfalse|true\n" + responses(10, "true|true"));
+    OnlineExecutor executor(out, in);
+    executor.execute(level, cbs, plan, std::chrono::steady_clock::now() + std::chrono::seconds(30));
+
+    assert(executor.getRepairsCount() == 1);
+    const auto &executed = executor.getExecuted();
+    assert(executed.size() == plan.size() + 1 && countLines(out) == executed.size());
+    assert(executed[1][0] == &Action::NoOp && executed[1][1] == &Action::MoveE);
+    assert(PlanValidator(level).validate(executed).solved);
+    fclose(out);
+    std::cout << "test_repair_after_rejection passed!" << std::endl;
+}
+
+// Agent 0 can never move, every repaired plan is rejected again until the repairs run out
+void test_repairs_limited() {
+    const Level level = makeRoomLevel();
+    CBS cbs(level);
+    const std::vector<std::vector<const Action *>> plan(3, {&Action::MoveE, &Action::MoveE});
+    FILE *out = tmpfile();
+    std::istringstream in(responses(100, "false|true"));
+    OnlineExecutor executor(out, in);
+    executor.execute(level, cbs, plan, std::chrono::steady_clock::now() + std::chrono::seconds(60));
+
+    assert(executor.getRepairsCount() == OnlineExecutor::MAX_REPAIRS);
+    const auto &executed = executor.getExecuted();
+    assert(countLines(out) == executed.size());
+    const PlanReport report = PlanValidator(level).validate(executed);
+    assert(report.valid && !report.solved);
+    fclose(out);
+    std::cout << "test_repairs_limited passed!" << std::endl;
+}
+
+int main() {
+    test_stream();
+    test_windowed();
+    test_repair_after_rejection();
+    test_repairs_limited();
+    std::cout << "All online executor tests passed!\n";
+    return 0;
+}
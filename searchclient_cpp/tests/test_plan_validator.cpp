@@ -0,0 +1,186 @@
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cbs.hpp"
+#include "level.hpp"
+#include "plan_validator.hpp"
+#include "solver.hpp"
+#include "test_helpers.hpp"
+
+using Plan = std::vector<std::vector<const Action *>>;
+
+// Agent 0 pushes A onto its goal while agent 1 walks to its own
+static Level makeTwoAgentLevel() {
+    return makeLevel("red: 0, A\nblue: 1\n",
+                     "+++++++\n"
+                     "+0A   +\n"
+                     "+1    +\n"
+                     "+++++++\n",
+                     "+++++++\n"
+                     "+   A +\n"
+                     "+    1+\n"
+                     "+++++++\n");
+}
+
+void test_reports_metrics() {
+    const Level level = makeTwoAgentLevel();
+    const Plan plan = {{&Action::PushEE, &Action::MoveE},
+                       {&Action::PushEE, &Action::MoveE},
+                       {&Action::NoOp, &Action::MoveE},
+                       {&Action::NoOp, &Action::MoveE}};
+    const PlanReport report = PlanValidator(level).validate(plan);
+    assert(report.valid && report.solved);
+    assert(report.error.empty() && report.failed_step == SIZE_MAX);
+    assert(report.makespan == 4);
+    assert(report.sum_of_costs == 2 + 4);
+    assert(report.fuel == 6);
+
+    // Valid but one step short of agent 1's goal
+    const PlanReport unsolved = PlanValidator(level).validate(Plan(plan.begin(), plan.end() - 1));
+    assert(unsolved.valid && !unsolved.solved);
+    assert(unsolved.error.find("Agent 1") != std::string::npos);
+    std::cout << "test_reports_metrics passed!" << std::endl;
+}
+
+void test_rejects_inapplicable_actions() {
+    const Level level = makeTwoAgentLevel();
+    const PlanValidator validator(level);
+
+    const PlanReport into_wall = validator.validate({{&Action::NoOp, &Action::NoOp}, {&Action::MoveN, &Action::NoOp}});
+    assert(!into_wall.valid && into_wall.failed_step == 1);
+    assert(into_wall.error == "Step 1: agent 0 Move(N) moves into an occupied cell");
+
+    // Agent 1 is blue, the box is red
+    const PlanReport wrong_color = validator.validate({{&Action::NoOp, &Action::MoveE}, {&Action::NoOp, &Action::PushNN}});
+    assert(!wrong_color.valid && wrong_color.failed_step == 1);
+    assert(wrong_color.error.find("no box of its color") != std::string::npos);
+
+    const PlanReport no_box = validator.validate({{&Action::PullWN, &Action::NoOp}});
+    assert(!no_box.valid && no_box.error.find("no box of its color to pull") != std::string::npos);
+
+    // The box cannot be pushed into the wall
+    const PlanReport blocked_box = validator.validate({{&Action::PushEN, &Action::NoOp}});
+    assert(!blocked_box.valid && blocked_box.error.find("pushes the box into an occupied cell") != std::string::npos);
+
+    // Cells left in a joint action are only free in the next one
+    const PlanReport into_left = validator.validate({{&Action::NoOp, &Action::MoveE}, {&Action::MoveS, &Action::NoOp}});
+    assert(into_left.valid && !into_left.solved);
+    const PlanReport into_leaving = validator.validate({{&Action::MoveS, &Action::MoveE}});
+    assert(!into_leaving.valid && into_leaving.error == "Step 0: agent 0 Move(S) moves into an occupied cell");
+    std::cout << "test_rejects_inapplicable_actions passed!" << std::endl;
+}
+
+void test_rejects_conflicts() {
+    const Level level = makeLevel("red: 0, 1, A\n",
+                                  "+++++++\n"
+                                  "+0 1  +\n"
+                                  "+     +\n"
+                                  "+++++++\n",
+                                  "+++++++\n"
+                                  "+     +\n"
+                                  "+     +\n"
+                                  "+++++++\n");
+    const PlanReport same_cell = PlanValidator(level).validate({{&Action::MoveE, &Action::MoveW}});
+    assert(!same_cell.valid && same_cell.failed_step == 0);
+    assert(same_cell.error == "Step 0: agents 0 and 1 both move into (1, 2)");
+
+    const Level box_level = makeLevel("red: 0, 1, A\n",
+                                      "+++++++\n"
+                                      "+0A1  +\n"
+                                      "+     +\n"
+                                      "+++++++\n",
+                                      "+++++++\n"
+                                      "+     +\n"
+                                      "+     +\n"
+                                      "+++++++\n");
+    const PlanReport same_box = PlanValidator(box_level).validate({{&Action::PushES, &Action::PullEE}});
+    assert(!same_box.valid);
+    assert(same_box.error == "Step 0: agents 0 and 1 both move the box at (1, 2)");
+
+    const PlanReport one_mover = PlanValidator(box_level).validate({{&Action::PushES, &Action::MoveE}});
+    assert(one_mover.valid && one_mover.fuel == 2);
+    std::cout << "test_rejects_conflicts passed!" << std::endl;
+}
+
+void test_parses_plans() {
+    const Plan plan = PlanValidator::parsePlan(
+        "#portfolio-winner: cbs\n"
+        "Push(E,E)@Push(E,E)|Move(E)@Move(E)\n"
+        "\n"
+        "NoOp | Move(E)\r\n",
+        2);
+    assert(plan.size() == 2);
+    assert(plan[0][0] == &Action::PushEE && plan[0][1] == &Action::MoveE);
+    assert(plan[1][0] == &Action::NoOp && plan[1][1] == &Action::MoveE);
+
+    for (const char *malformed : {"Move(E)\n", "Move(E)|Jump\n", "Move(E)|Move(E)|NoOp\n"}) {
+        try {
+            PlanValidator::parsePlan(malformed, 2);
+            assert(false);
+        } catch (const std::invalid_argument &e) {
+            assert(std::string(e.what()).rfind("Malformed plan: line 1", 0) == 0);
+        }
+    }
+    std::cout << "test_parses_plans passed!" << std::endl;
+}
+
+// Every offline strategy, with the LNS and compression passes the feature flags enable, must produce plans the
+// server accepts
+void test_validates_solver_plans() {
+    const std::vector<Level> levels = {
+        makeTwoAgentLevel(),
+        makeLevel("red: 0, A\nblue: 1, B\n",
+                  "+++++++++\n"
+                  "+0A   B1+\n"
+                  "+++ + +++\n"
+                  "+++   +++\n"
+                  "+++++++++\n",
+                  "+++++++++\n"
+                  "+B     A+\n"
+                  "+++ + +++\n"
+                  "+++   +++\n"
+                  "+++++++++\n"),
+        makeLevel("red: 0, 1, A, B\n",
+                  "+++++++\n"
+                  "+0 A  +\n"
+                  "+     +\n"
+                  "+1 B  +\n"
+                  "+++++++\n",
+                  "+++++++\n"
+                  "+    B+\n"
+                  "+     +\n"
+                  "+    A+\n"
+                  "+++++++\n"),
+    };
+    for (const auto &level : levels) {
+        for (const std::string strategy : {"cbs", "pp", "portfolio"}) {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            CBS cbs(level, deadline);
+            const Plan plan = solveLevel(level, cbs, strategy, deadline);
+            if (plan.empty()) {
+                assert(strategy == "pp");  // Prioritized planning is incomplete, the agents swap sides on the second level
+                continue;
+            }
+            const PlanReport report = PlanValidator(level).validate(plan);
+            if (!report.solved) {
+                std::cerr << strategy << ": " << report.error << std::endl;
+            }
+            assert(report.solved && report.makespan == plan.size());
+        }
+    }
+    std::cout << "test_validates_solver_plans passed!" << std::endl;
+}
+
+int main() {
+    test_reports_metrics();
+    test_rejects_inapplicable_actions();
+    test_rejects_conflicts();
+    test_parses_plans();
+    test_validates_solver_plans();
+    std::cout << "All plan validator tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "action.hpp"
+#include "plan_writer.hpp"
+
+static std::vector<std::string> readLines(FILE *file) {
+    std::vector<std::string> lines;
+    rewind(file);
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        lines.emplace_back(line);
+    }
+    return lines;
+}
+
+static std::string responses(size_t count, const std::string &response) {
+    std::string all;
+    for (size_t i = 0; i < count; i++) {
+        all += response + "\n";
+    }
+    return all;
+}
+
+void test_streams_whole_plan() {
+    const std::vector<std::vector<const Action *>> plan(1000, {&Action::MoveE, &Action::NoOp});
+    FILE *out = tmpfile();
+    std::istringstream in(responses(plan.size(), "true|true"));
+    PlanWriter writer(out, in, 8);
+    assert(writer.send(plan));
+    const auto lines = readLines(out);
+    assert(lines.size() == plan.size());
+    assert(lines[0] == formatJointAction(plan[0], false) + "\n");
+    fclose(out);
+}
+
+void test_reports_first_rejection() {
+    const std::vector<std::vector<const Action *>> plan(100, {&Action::MoveE, &Action::MoveW});
+    FILE *out = tmpfile();
+    std::istringstream in(responses(3, "true|true") + responses(97, "true|false"));
+    PlanWriter writer(out, in, 4);
+    assert(!writer.send(plan));
+    assert(writer.getFailedStep() == 3);
+    assert(writer.getFailedResponse() == "true|false");
+    // Sending stops within a window of the rejected action
+    assert(readLines(out).size() < 3 + 2 * 4);
+    fclose(out);
+}
+
+void test_records_executed_actions() {
+    const std::vector<std::vector<const Action *>> plan(6, {&Action::MoveE, &Action::MoveW});
+    FILE *out = tmpfile();
+    std::istringstream in(responses(2, "true|true") + responses(4, "false|true"));
+    PlanWriter writer(out, in, 1);
+    assert(!writer.send(plan));
+    const auto &executed = writer.getExecuted();
+    // With a window of one nothing is in flight past the rejected action
+    assert(executed.size() == 3);
+    assert(executed[1][0] == &Action::MoveE);
+    assert(executed[2][0] == &Action::NoOp && executed[2][1] == &Action::MoveW);
+    fclose(out);
+}
+
+void test_server_stops_answering() {
+    const std::vector<std::vector<const Action *>> plan(10, {&Action::NoOp});
+    FILE *out = tmpfile();
+    std::istringstream in(responses(5, "true"));
+    PlanWriter writer(out, in);
+    assert(!writer.send(plan));
+    assert(writer.getFailedStep() == 5);
+    fclose(out);
+}
+
+void test_appends_while_sending() {
+    const std::vector<std::vector<const Action *>> prefix(30, {&Action::MoveE});
+    const std::vector<std::vector<const Action *>> rest(20, {&Action::MoveW});
+    FILE *out = tmpfile();
+    std::istringstream in(responses(prefix.size() + rest.size(), "true"));
+    PlanWriter writer(out, in, 8);
+    writer.start();
+    writer.append(prefix);
+    writer.append(rest);
+    assert(writer.finish());
+    assert(writer.getUnfinished() == 0);
+    const auto lines = readLines(out);
+    assert(lines.size() == prefix.size() + rest.size());
+    assert(lines[29] == formatJointAction(prefix[0], false) + "\n");
+    assert(lines[30] == formatJointAction(rest[0], false) + "\n");
+    fclose(out);
+}
+
+int main() {
+    test_streams_whole_plan();
+    test_reports_first_rejection();
+    test_records_executed_actions();
+    test_server_stops_answering();
+    test_appends_while_sending();
+    std::cout << "All plan writer tests passed!\n";
+    return 0;
+}
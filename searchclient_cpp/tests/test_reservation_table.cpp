@@ -0,0 +1,71 @@
+#include <cassert>
+#include <iostream>
+#include <sstream>
+
+#include "level.hpp"
+#include "low_level_state.hpp"
+#include "reservation_table.hpp"
+
+static Level loadCorridorLevel() {
+    const std::string lvl =
+        "#domain\n"
+        "hospital\n"
+        "#levelname\n"
+        "corridor\n"
+        "#colors\n"
+        "red: 0\n"
+        "#initial\n"
+        "++++++\n"
+        "+0   +\n"
+        "++++++\n"
+        "#goal\n"
+        "++++++\n"
+        "+  0 +\n"
+        "++++++\n"
+        "#end\n";
+    std::istringstream in(lvl);
+    return loadLevel(in);
+}
+
+void test_reserve_and_query() {
+    Level level = loadCorridorLevel();
+    ReservationTable table(level.static_level);
+
+    table.reserve(Cell2D(1, 2), 3);
+    assert(table.isReserved(Cell2D(1, 2), 3));
+    assert(!table.isReserved(Cell2D(1, 2), 2));
+    assert(!table.isReserved(Cell2D(1, 3), 3));
+    assert(table.isReservedFrom(Cell2D(1, 2), 3));
+    assert(!table.isReservedFrom(Cell2D(1, 2), 4));
+    assert(table.getHorizon() == 4);
+
+    table.block(Cell2D(1, 4));
+    assert(table.isReserved(Cell2D(1, 4), 0) && table.isReserved(Cell2D(1, 4), 100));
+    table.unblock(Cell2D(1, 4));
+    assert(!table.isReservedFrom(Cell2D(1, 4), 0));
+
+    table.clear();
+    assert(!table.isReserved(Cell2D(1, 2), 3));
+    assert(table.getHorizon() == 0);
+}
+
+void test_reserve_plan_keeps_final_cells() {
+    Level level = loadCorridorLevel();
+    LowLevelState state(level.static_level, level.agents, level.boxes);
+    ReservationTable table(level.static_level);
+
+    table.reservePlan(state, {{&Action::MoveE}, {&Action::MoveE}});
+    assert(table.isReserved(Cell2D(1, 1), 0));
+    assert(table.isReserved(Cell2D(1, 2), 1));
+    assert(!table.isReserved(Cell2D(1, 2), 2));
+    assert(table.isReserved(Cell2D(1, 3), 2));
+    assert(table.isReserved(Cell2D(1, 3), 1'000));
+    assert(!table.isReservedFrom(Cell2D(1, 1), 1));
+}
+
+int main() {
+    test_reserve_and_query();
+    test_reserve_plan_keeps_final_cells();
+    std::cout << "All ReservationTable tests passed!\n";
+    return 0;
+}
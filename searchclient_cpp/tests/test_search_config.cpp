@@ -0,0 +1,129 @@
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cbs.hpp"
+#include "level.hpp"
+#include "plan_validator.hpp"
+#include "search_config.hpp"
+#include "solver.hpp"
+
+static bool throwsInvalid(SearchConfig &config, const std::vector<std::string> &args) {
+    try {
+        config.parseArgs(args);
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+    return false;
+}
+
+void test_defaults() {
+    const SearchConfig config;
+    assert(config.solver == "cbs" && config.frontier == "bestfirst" && config.heuristic == "astar");
+    assert(config.threads == 0 && config.time_limit == std::chrono::seconds(150));
+    assert(config.window == SearchConfig::DEFAULT_CONFLICT_WINDOW);
+
+    Heuristic *heuristic = config.makeHeuristic();
+    assert(heuristic->getName() == "Modified A*");
+    Frontier *frontier = config.makeFrontier(heuristic);
+    assert(frontier->getName().find("best-first") != std::string::npos);
+    delete frontier;
+    std::cout << "test_defaults passed!" << std::endl;
+}
+
+void test_parses_args() {
+    SearchConfig config;
+    config.parseArgs({"--frontier", "BFS", "--threads", "2", "--memory", "512", "--timeout", "30", "portfolio"});
+    assert(config.solver == "portfolio" && config.frontier == "bfs");
+    assert(config.threads == 2 && config.memory_mb == 512 && config.time_limit == std::chrono::seconds(30));
+    delete config.makeFrontier(config.makeHeuristic());
+
+    // Strategy names of earlier versions
+    SearchConfig weighted;
+    weighted.parseArgs({"cbs+wastar", "5"});
+    assert(weighted.solver == "cbs" && weighted.heuristic == "wastar" && weighted.weight == 5);
+    SearchConfig windowed;
+    windowed.parseArgs({"windowed", "8"});
+    assert(windowed.solver == "windowed" && windowed.window == 8);
+
+    SearchConfig invalid;
+    assert(throwsInvalid(invalid, {"--frontier", "ida"}));
+    assert(throwsInvalid(invalid, {"--threads", "-1"}));
+    assert(throwsInvalid(invalid, {"--timeout", "10s"}));
+    assert(throwsInvalid(invalid, {"--memory", "4294967296"}));
+    assert(throwsInvalid(invalid, {"--speed", "1"}));
+    assert(throwsInvalid(invalid, {"--weight"}));
+    std::cout << "test_parses_args passed!" << std::endl;
+}
+
+void test_loads_file() {
+    const std::string path = "/tmp/test_search_config.cfg";
+    FILE *file = fopen(path.c_str(), "w");
+    fprintf(file, "# sweep settings\nsolver = pp\nheuristic = greedy  # no g\n\ntimeout=20\n");
+    fclose(file);
+
+    // The command line wins over the file, whatever the order
+    SearchConfig config;
+    config.parseArgs({"--timeout", "40", "--config", path});
+    assert(config.solver == "pp" && config.heuristic == "greedy");
+    assert(config.time_limit == std::chrono::seconds(40));
+    Heuristic *heuristic = config.makeHeuristic();
+    assert(heuristic->getName() == "Greedy");
+    delete heuristic;
+
+    file = fopen(path.c_str(), "w");
+    fprintf(file, "solver pp\n");
+    fclose(file);
+    try {
+        SearchConfig().loadFile(path);
+        assert(false);
+    } catch (const std::invalid_argument &e) {
+        assert(std::string(e.what()) == path + ":1: expected key = value");
+    }
+    std::remove(path.c_str());
+    assert(throwsInvalid(config, {"--config", path}));
+    std::cout << "test_loads_file passed!" << std::endl;
+}
+
+// Every frontier and heuristic, and the portfolio on a single thread, must still produce valid plans
+void test_solves_with_each_setting() {
+    const Level level = parseLevel(
+        "#domain\nhospital\n#levelname\nconfig\n#colors\nred: 0, A\nblue: 1\n#initial\n"
+        "+++++++\n"
+        "+0A   +\n"
+        "+1    +\n"
+        "+++++++\n"
+        "#goal\n"
+        "+++++++\n"
+        "+   A +\n"
+        "+    1+\n"
+        "+++++++\n"
+        "#end\n");
+    const std::vector<std::vector<std::string>> settings = {
+        {"--frontier", "bfs"}, {"--frontier", "dfs"}, {"--heuristic", "wastar"}, {"--heuristic", "greedy"},
+        {"--threads", "1", "portfolio"}, {"--threads", "1", "portfolio-best", "--timeout", "2"},
+    };
+    for (const auto &args : settings) {
+        SearchConfig::active = SearchConfig();
+        SearchConfig::active.parseArgs(args);
+        const auto deadline = std::chrono::steady_clock::now() + SearchConfig::active.time_limit;
+        CBS cbs(level, deadline);
+        const auto plan = solveLevel(level, cbs, SearchConfig::active.solver, deadline);
+        assert(!plan.empty() && PlanValidator(level).validate(plan).solved);
+    }
+    SearchConfig::active = SearchConfig();
+    std::cout << "test_solves_with_each_setting passed!" << std::endl;
+}
+
+int main() {
+    test_defaults();
+    test_parses_args();
+    test_loads_file();
+    test_solves_with_each_setting();
+    std::cout << "All search config tests passed!\n";
+    return 0;
+}
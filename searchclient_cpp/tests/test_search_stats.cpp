@@ -0,0 +1,109 @@
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "cbs.hpp"
+#include "level.hpp"
+#include "search_stats.hpp"
+
+#ifdef USE_SEARCH_STATS
+// The value of a top level counter of the exported JSON
+static unsigned long long readCounter(const std::string &json, const std::string &key) {
+    const size_t at = json.find("\"" + key + "\": ");
+    assert(at != std::string::npos);
+    return std::stoull(json.substr(at + key.size() + 4));
+}
+
+static double readMs(const std::string &json, const std::string &key) {
+    const size_t at = json.find("\"" + key + "\": ");
+    assert(at != std::string::npos);
+    return std::stod(json.substr(at + key.size() + 4));
+}
+
+void test_disabled_collects_nothing() {
+    SearchStats::reset();
+    assert(!SearchStats::isEnabled());
+    SearchStats::add(SearchStats::LOW_LEVEL_CALLS, 5);
+    SearchStats::ScopedTimer timer(SearchStats::HEURISTIC);
+    assert(SearchStats::start() == std::chrono::steady_clock::time_point());
+    assert(readCounter(SearchStats::toJson(), "low_level_calls") == 0);
+    std::cout << "test_disabled_collects_nothing passed!" << std::endl;
+}
+
+void test_merges_threads() {
+    SearchStats::reset();
+    SearchStats::enable();
+    SearchStats::add(SearchStats::CT_NODES_EXPANDED, 2);
+    SearchStats::updatePeak(SearchStats::STATES_HELD, 7);
+    std::thread worker([]() {
+        SearchStats::add(SearchStats::CT_NODES_EXPANDED, 3);
+        SearchStats::updatePeak(SearchStats::STATES_HELD, 11);
+        SearchStats::ScopedTimer timer(SearchStats::CONFLICT_DETECTION);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    });
+    worker.join();
+
+    const std::string json = SearchStats::toJson();
+    assert(readCounter(json, "ct_nodes_expanded") == 5);
+    assert(readCounter(json, "peak_states_held") == 11);
+    assert(readMs(json, "conflict_detection_ms") >= 2.0);
+    std::cout << "test_merges_threads passed!" << std::endl;
+}
+
+// Two agents swapping sides of a corridor with one passing bay must be untangled by CBS
+void test_counts_search() {
+    const Level level = parseLevel(
+        "#domain\nhospital\n#levelname\nstats\n#colors\nred: 0\nblue: 1\n#initial\n"
+        "+++++++\n"
+        "+0   1+\n"
+        "+++ +++\n"
+        "+++++++\n"
+        "#goal\n"
+        "+++++++\n"
+        "+1   0+\n"
+        "+++ +++\n"
+        "+++++++\n"
+        "#end\n");
+    SearchStats::reset();
+    SearchStats::enable();
+    CBS cbs(level, std::chrono::steady_clock::now() + std::chrono::seconds(10));
+    assert(!cbs.solve().empty());
+
+    const std::string json = SearchStats::toJson();
+    assert(readCounter(json, "low_level_expanded") >= cbs.getExpandedStatesCount());
+    assert(readCounter(json, "low_level_calls") >= 2);
+    assert(readCounter(json, "low_level_duplicates_pruned") > 0);
+    assert(readMs(json, "low_level_search_ms") > 0.0);
+    if (readCounter(json, "ct_nodes_expanded") > 0) {
+        assert(readCounter(json, "ct_nodes_generated") > 1);
+        assert(json.find("\"calls\": ") != std::string::npos);
+    }
+
+    const std::string path = "/tmp/test_search_stats.json";
+    assert(SearchStats::exportJson(path));
+    std::ifstream file(path);
+    std::stringstream exported;
+    exported << file.rdbuf();
+    assert(readCounter(exported.str(), "low_level_expanded") == readCounter(json, "low_level_expanded"));
+    std::remove(path.c_str());
+    assert(!SearchStats::exportJson("/nonexistent/stats.json"));
+    std::cout << "test_counts_search passed!" << std::endl;
+}
+#endif
+
+int main() {
+#ifdef USE_SEARCH_STATS
+    test_disabled_collects_nothing();
+    test_merges_threads();
+    test_counts_search();
+#else
+    assert(SearchStats::toJson() == "{}");
+#endif
+    std::cout << "All search stats tests passed!\n";
+    return 0;
+}